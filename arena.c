@@ -0,0 +1,56 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Default chunk size; larger requests get a chunk of their own
+#define ARENA_CHUNK_SIZE (16 * 1024)
+
+// Initialize an empty arena
+void init_arena(Arena *arena) {
+    arena->chunks = NULL;
+}
+
+// Allocate zeroed memory from the arena
+void* arena_alloc(Arena *arena, size_t size) {
+    // Keep every allocation suitably aligned for pointers and integers
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    ArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->size - chunk->used < size) {
+        size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + chunk_size);
+        if (!chunk) {
+            fprintf(stderr, "Memory allocation failed for arena\n");
+            exit(1);
+        }
+        chunk->used = 0;
+        chunk->size = chunk_size;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    void *memory = chunk->data + chunk->used;
+    chunk->used += size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+// Copy a string into the arena
+char* arena_strdup(Arena *arena, const char *text) {
+    size_t length = strlen(text);
+    char *copy = (char *)arena_alloc(arena, length + 1);
+    memcpy(copy, text, length + 1);
+    return copy;
+}
+
+// Free every allocation made from the arena
+void free_arena(Arena *arena) {
+    ArenaChunk *chunk = arena->chunks;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
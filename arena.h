@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// One block of arena memory
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;     // Previously filled chunk
+    size_t used;                 // Bytes handed out from data
+    size_t size;                 // Usable bytes in data
+    char data[];                 // Storage
+} ArenaChunk;
+
+// Bump allocator: everything allocated from an arena is freed together
+typedef struct {
+    ArenaChunk *chunks;          // Current chunk (head of the chunk list)
+} Arena;
+
+// Initialize an empty arena
+void init_arena(Arena *arena);
+
+// Allocate zeroed memory from the arena (never returns NULL; exits on failure)
+void* arena_alloc(Arena *arena, size_t size);
+
+// Copy a string into the arena
+char* arena_strdup(Arena *arena, const char *text);
+
+// Free every allocation made from the arena
+void free_arena(Arena *arena);
+
+#endif // ARENA_H
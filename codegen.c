@@ -1,27 +1,36 @@
+// fileno is POSIX, not C: request it for strict -std=c11 builds too
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "codegen.h"
+#include "dead_code.h"
+#include "frame.h"
+#include "induction.h"
+#include "inline.h"
+#include "loop_invariant.h"
+#include "lower.h"
+#include "peephole.h"
+#include "regalloc.h"
+#include "runtime.h"
+#include "strength_reduce.h"
+#include "tail_call.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 
+#ifdef _WIN32
+#define file_descriptor(file) _fileno(file)
+#else
+#define file_descriptor(file) fileno(file)
+#endif
+
 // Forward declarations for code generation functions
 static void generate_program(CodeGenContext *context, ASTNode *program);
-static void generate_function(CodeGenContext *context, ASTNode *function);
-static void generate_function_parameters(CodeGenContext *context, ASTNode *params);
-static void generate_block(CodeGenContext *context, ASTNode *block);
-static void generate_variable_declaration(CodeGenContext *context, ASTNode *var_decl);
-static void generate_expression(CodeGenContext *context, ASTNode *expr);
-static void generate_return_statement(CodeGenContext *context, ASTNode *ret);
-static void generate_if_statement(CodeGenContext *context, ASTNode *if_stmt);
-static void generate_luloop_statement(CodeGenContext *context, ASTNode *luloop);
-static void generate_lulog_statement(CodeGenContext *context, ASTNode *lulog);
-static void generate_luload_statement(CodeGenContext *context, ASTNode *luload);
-static void generate_luload_expression(CodeGenContext *context, ASTNode *luload);
-static void generate_identifier(CodeGenContext *context, ASTNode *id);
-static void generate_binary_operation(CodeGenContext *context, ASTNode *binary_op);
-static void generate_condition(CodeGenContext *context, ASTNode *cond, const char *true_label, const char *false_label);
-static void generate_function_call(CodeGenContext *context, ASTNode *call);
-static void generate_data_section(CodeGenContext *context);
+static void generate_function(CodeGenContext *context, IRFunction *ir);
+static void generate_header(CodeGenContext *context, const StringBuffer *data, int count);
+static void generate_data_section(CodeGenContext *context, const StringBuffer *data, int count);
 static void generate_bss_section(CodeGenContext *context);
 static void generate_text_section(CodeGenContext *context);
 
@@ -34,19 +43,35 @@ CodeGenContext* initialize_code_generator(const char *output_filename, SymbolTab
     }
     
     CodeGenContext *context = (CodeGenContext *)malloc(sizeof(CodeGenContext));
-    if (!context) {
+    Emitter *emitter = (Emitter *)malloc(sizeof(Emitter));
+    if (!context || !emitter) {
         fprintf(stderr, "Failed to allocate memory for code generation context\n");
+        free(context);
+        free(emitter);
         fclose(output_file);
         return NULL;
     }
     
+    // All output goes straight to the file descriptor in large writes
+    init_emitter(emitter, file_descriptor(output_file));
+    
     context->output_file = output_file;
+    context->emitter = emitter;
     context->symbol_table = symbol_table;
+    context->pool = NULL;
     context->label_counter = 0;
     context->indent_level = 0;
     context->current_function = NULL;
+    context->function_name[0] = '\0';
     context->input_filename = input_filename;  // Store the source filename
-    context->var_count = 0;  // Initialize variable tracking
+    context->optimization_level = 0;
+    context->inline_limit = DEFAULT_INLINE_LIMIT;
+    context->target = TARGET_8086;
+    context->dump_ir = false;
+    context->ir_dump = NULL;
+    context->data = NULL;
+    context->buffered_output = true;
+    context->runtime_used = 0;
     
     return context;
 }
@@ -54,97 +79,83 @@ CodeGenContext* initialize_code_generator(const char *output_filename, SymbolTab
 // Free code generator resources
 void free_code_generator(CodeGenContext *context) {
     if (context) {
+        if (context->emitter) {
+            flush_emitter(context->emitter);
+            free_emitter(context->emitter);
+            free(context->emitter);
+        }
         if (context->output_file) {
             fclose(context->output_file);
         }
-        // current_function now uses a static buffer, no need to free it
+        // current_function points into the context itself, no need to free it
         free(context);
     }
 }
 
 // Write a formatted line to the output file
 void write_line(CodeGenContext *context, const char *format, ...) {
-    if (!context || !context->output_file) return;
+    if (!context || !context->emitter) return;
     
     va_list args;
     va_start(args, format);
     
-    // Write indentation
-    for (int i = 0; i < context->indent_level; i++) {
-        fprintf(context->output_file, "    ");
-    }
-    
-    // Write the formatted line
-    vfprintf(context->output_file, format, args);
-    fprintf(context->output_file, "\n");
+    emit_indent(context->emitter, context->indent_level);
+    emit_vformat(context->emitter, format, args);
+    emit_char(context->emitter, '\n');
     
     va_end(args);
 }
 
 // Write an instruction to the output file (with indentation)
 void write_instruction(CodeGenContext *context, const char *format, ...) {
-    if (!context || !context->output_file) return;
+    if (!context || !context->emitter) return;
     
     va_list args;
     va_start(args, format);
     
-    // Write indentation
-    fprintf(context->output_file, "    ");
-    for (int i = 0; i < context->indent_level; i++) {
-        fprintf(context->output_file, "    ");
-    }
-    
-    // Write the formatted instruction
-    vfprintf(context->output_file, format, args);
-    fprintf(context->output_file, "\n");
+    // Instructions sit one level deeper than the surrounding block
+    emit_indent(context->emitter, context->indent_level + 1);
+    emit_vformat(context->emitter, format, args);
+    emit_char(context->emitter, '\n');
     
     va_end(args);
 }
 
 // Write a label to the output file
 void write_label(CodeGenContext *context, const char *format, ...) {
-    if (!context || !context->output_file) return;
+    if (!context || !context->emitter) return;
     
     va_list args;
     va_start(args, format);
     
-    // Format the label
-    char buffer[128];
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    
     // Labels go at the start of the line
-    fprintf(context->output_file, "%s:\n", buffer);
+    emit_vformat(context->emitter, format, args);
+    emit_text(context->emitter, ":\n", 2);
     
     va_end(args);
 }
 
 // Write a comment to the output file
 void write_comment(CodeGenContext *context, const char *format, ...) {
-    if (!context || !context->output_file) return;
+    if (!context || !context->emitter) return;
     
     va_list args;
     va_start(args, format);
     
-    // Write indentation
-    for (int i = 0; i < context->indent_level; i++) {
-        fprintf(context->output_file, "    ");
-    }
-    
-    // Write the comment prefix
-    fprintf(context->output_file, "; ");
-    
-    // Write the formatted comment
-    vfprintf(context->output_file, format, args);
-    fprintf(context->output_file, "\n");
+    emit_indent(context->emitter, context->indent_level);
+    emit_text(context->emitter, "; ", 2);
+    emit_vformat(context->emitter, format, args);
+    emit_char(context->emitter, '\n');
     
     va_end(args);
 }
 
 // Write a section header to the output file
 void write_section(CodeGenContext *context, const char *section) {
-    if (!context || !context->output_file) return;
+    if (!context || !context->emitter) return;
     
-    fprintf(context->output_file, "%s\n", section);
+    emit_string(context->emitter, section);
+    emit_char(context->emitter, '\n');
 }
 
 // CAUTION: This function is deprecated and will be removed
@@ -164,10 +175,25 @@ char* generate_label(CodeGenContext *context, const char *prefix) {
     return label;
 }
 
-// Generate a label using format string (for use with write_label)
-// This version uses a stack buffer and doesn't leak memory
-static char* format_label(char *buffer, size_t size, const char *format, int number) {
-    snprintf(buffer, size, format, number);
+// Generate a label into a stack buffer (for use with write_label).
+// Label numbers restart in every function and the function name is part of
+// the label, so functions can be generated independently of each other.
+static char* format_label(CodeGenContext *context, char *buffer, size_t size, const char *prefix, int number) {
+    char digits[16];
+    size_t prefix_length = strlen(prefix);
+    size_t name_length = strlen(context->current_function);
+    size_t digit_count = (size_t)format_int(digits, number);
+    
+    // Truncate like snprintf would if the pieces do not fit
+    size_t length = 0;
+    const char *pieces[] = { prefix, "_", context->current_function, "_", digits };
+    size_t lengths[] = { prefix_length, 1, name_length, 1, digit_count };
+    for (int i = 0; i < 5 && length + 1 < size; i++) {
+        size_t take = lengths[i] < size - 1 - length ? lengths[i] : size - 1 - length;
+        memcpy(buffer + length, pieces[i], take);
+        length += take;
+    }
+    buffer[length] = '\0';
     return buffer;
 }
 
@@ -180,6 +206,22 @@ bool generate_code(CodeGenContext *context, ASTNode *root) {
         return false;
     }
     
+    // Functions are generated first: the runtime they call decides what the
+    // data and text sections in front of them hold
+    generate_program(context, root);
+    
+    // End of file
+    write_line(context, "code ends");
+    write_line(context, "");
+    write_line(context, "end main_init");
+    
+    return flush_emitter(context->emitter);
+}
+
+// Everything in front of the functions: data (the runtime's, then that of
+// the `count` functions in `data`), stack, and the start of the code
+// segment with the runtime
+static void generate_header(CodeGenContext *context, const StringBuffer *data, int count) {
     // Use the input filename passed from main.c
     const char *source_file = context->input_filename;
     
@@ -188,9 +230,16 @@ bool generate_code(CodeGenContext *context, ASTNode *root) {
     write_comment(context, "Source file: %s", source_file);
     write_line(context, "");
     
+    // Instructions beyond the 8086 have to be enabled
+    const TargetCosts *costs = target_costs(context->target);
+    if (costs->directive) {
+        write_line(context, "%s", costs->directive);
+        write_line(context, "");
+    }
+    
     // Generate data section (strings, constants)
     write_line(context, "data segment");
-    generate_data_section(context);
+    generate_data_section(context, data, count);
     write_line(context, "data ends");
     write_line(context, "");
     
@@ -207,25 +256,18 @@ bool generate_code(CodeGenContext *context, ASTNode *root) {
     
     // Generate text section (code)
     generate_text_section(context);
-    
-    // Start generating the program
-    generate_program(context, root);
-    
-    // End of file
-    write_line(context, "code ends");
-    write_line(context, "");
-    write_line(context, "end main_init");
-    
-    return true;
 }
 
 // Generate the data section
-static void generate_data_section(CodeGenContext *context) {
-    // Add necessary data elements for the compiler
+static void generate_data_section(CodeGenContext *context, const StringBuffer *data, int count) {
+    // Only the runtime the program uses has data
     write_line(context, "; Data section with variables needed by the compiler");
-    write_line(context, "call_counter db 0 ; Counter for tracking function calls");
-    write_line(context, "input_prompt db '? $'");
-    write_line(context, "error_msg db 0Dh, 0Ah, 'Invalid input, please try again: $'");
+    generate_runtime_data(context);
+    
+    // Constants of the functions, in source order
+    for (int i = 0; i < count; i++) {
+        emit_text(context->emitter, data[i].data, data[i].length);
+    }
 }
 
 // Generate the BSS section - Not used in this implementation
@@ -235,1189 +277,1240 @@ static void generate_bss_section(CodeGenContext *context) {
 
 // Generate the text section
 static void generate_text_section(CodeGenContext *context) {
-    // Initialize data segment
-    write_label(context, "main_init");
-    write_instruction(context, "mov ax, data");
-    write_instruction(context, "mov ds, ax");
-    write_instruction(context, "jmp main");  // Jump to the main function to begin execution
-    
-    // We no longer need string data as we're using direct character output
-    
-    // Improved lulog implementation with proper handling of all integers
-    write_comment(context, "Implementation to print all integer values");
-    write_label(context, "lulog");
-    write_instruction(context, "push bp");
-    write_instruction(context, "mov bp, sp");
-    
-    // Get the parameter from stack - always at [bp+4]
-    write_instruction(context, "mov ax, [bp+4]");  // Get parameter value
-    
-    // Save registers (AX is already saved by mov)
-    write_instruction(context, "push bx");
-    write_instruction(context, "push cx");
-    write_instruction(context, "push dx");
-    write_instruction(context, "push si");         // We'll use SI as our sign flag
-    
-    // Handle negative numbers
-    write_instruction(context, "mov si, 0");       // Initialize sign flag (0 = positive)
-    write_instruction(context, "test ax, ax");     // Check if value is negative
-    write_instruction(context, "jns positive_number"); // Skip if not negative
-    
-    // For negative number, set sign flag and negate the value
-    write_instruction(context, "mov si, 1");       // Set sign flag (1 = negative)
-    write_instruction(context, "neg ax");          // Make the number positive
-    
-    write_label(context, "positive_number");
-    // Special case for zero
-    write_instruction(context, "test ax, ax");     // Check if value is zero
-    write_instruction(context, "jnz prepare_conversion");
-    
-    // Print '0' if the value is zero
-    write_instruction(context, "mov dl, '0'");
-    write_instruction(context, "mov ah, 2");
-    write_instruction(context, "int 21h");
-    write_instruction(context, "jmp print_newline");
-    
-    // Prepare to convert a non-zero number
-    write_label(context, "prepare_conversion");
-    // If negative, print minus sign first
-    write_instruction(context, "test si, si");
-    write_instruction(context, "jz convert_to_digits"); // Skip if positive
-    
-    // Print minus sign
-    write_instruction(context, "mov dl, '-'");
-    write_instruction(context, "mov ah, 2");
-    write_instruction(context, "int 21h");
-    
-    // Convert non-zero number to digits by repeated division
-    write_label(context, "convert_to_digits");
-    write_instruction(context, "mov cx, 0");       // Initialize digit counter
-    write_instruction(context, "mov bx, 10");      // Divisor (base 10)
-    
-    // Loop to extract digits
-    write_label(context, "digit_loop");
-    write_instruction(context, "xor dx, dx");      // Clear DX for division
-    write_instruction(context, "div bx");          // Divide AX by 10, result in AX, remainder in DX
-    write_instruction(context, "push dx");         // Push remainder (current digit)
-    write_instruction(context, "inc cx");          // Count the digit
-    write_instruction(context, "test ax, ax");     // Check if quotient is zero
-    write_instruction(context, "jnz digit_loop");  // If not zero, continue extracting digits
-    
-    // Print digits in reverse order (from stack)
-    write_label(context, "print_digits");
-    write_instruction(context, "pop dx");          // Get digit from stack
-    write_instruction(context, "add dl, '0'");     // Convert to ASCII
-    write_instruction(context, "mov ah, 2");       // DOS print character function
-    write_instruction(context, "int 21h");         // Call DOS
-    write_instruction(context, "loop print_digits"); // Decrement CX and loop if not zero
-    
-    // Print newline after the number (CR+LF using INT 21h, AH=2h)
-    write_label(context, "print_newline");
-    write_instruction(context, "mov dl, 13");      // Carriage return
-    write_instruction(context, "mov ah, 2");       // DOS function: output character
-    write_instruction(context, "int 21h");         // Call DOS
-    write_instruction(context, "mov dl, 10");      // Line feed
-    write_instruction(context, "mov ah, 2");       // DOS function: output character
-    write_instruction(context, "int 21h");         // Call DOS
-    
-    // Cleanup and return
-    write_label(context, "end_lulog");
-    write_instruction(context, "pop si");          // Restore SI (sign flag)
-    write_instruction(context, "pop dx");          // Restore DX
-    write_instruction(context, "pop cx");          // Restore CX
-    write_instruction(context, "pop bx");          // Restore BX
-    write_instruction(context, "pop bp");          // Restore BP
-    write_instruction(context, "ret");             // Standard return, caller will clean up stack
-    
-    // Completely rewritten luload implementation to fix digit handling
-    write_comment(context, "Fixed luload implementation to correctly read integer values");
-    write_label(context, "luload");
-    
-    // Function prologue
-    write_instruction(context, "push bp");
-    write_instruction(context, "mov bp, sp");
-    write_instruction(context, "push dx");
-    write_instruction(context, "push cx");
-    write_instruction(context, "push bx");
-    
-    // Display input prompt
-    write_instruction(context, "mov ah, 9");       // DOS function 9: print string
-    write_instruction(context, "mov dx, offset input_prompt");
-    write_instruction(context, "int 21h");
-    
-    // Initialize result register and sign flag
-    write_instruction(context, "xor bx, bx");      // BX = 0 (initial accumulated value)
-    write_instruction(context, "xor cx, cx");      // CX = 0 (sign flag: 0=positive, 1=negative)
-    
-    // Read first character - check for minus sign
-    write_instruction(context, "mov ah, 1");       // DOS function 1: read character with echo
-    write_instruction(context, "int 21h");         // Character in AL
-    
-    // Check for minus sign
-    write_instruction(context, "cmp al, '-'");     // Is it a minus sign?
-    write_instruction(context, "jne luload_first_digit"); // If not, process as first digit
-    
-    // It is a minus sign - set flag and read next character
-    write_instruction(context, "mov cx, 1");       // Set sign flag to negative
-    write_instruction(context, "mov ah, 1");       // Read next character
-    write_instruction(context, "int 21h");
-    
-    // Process first digit after handling potential minus sign
-    write_label(context, "luload_first_digit");
-    
-    // Check for immediate Enter key
-    write_instruction(context, "cmp al, 13");      // Is it Enter?
-    write_instruction(context, "je luload_done");  // If yes, return 0
-    
-    // Check if first character is a digit
-    write_instruction(context, "cmp al, '0'");     // Less than '0'?
-    write_instruction(context, "jb luload_ignore"); // If yes, ignore it and read next
-    write_instruction(context, "cmp al, '9'");     // Greater than '9'?
-    write_instruction(context, "ja luload_ignore"); // If yes, ignore it and read next
-    
-    // First digit is valid - convert ASCII to binary
-    write_instruction(context, "sub al, '0'");     // Convert ASCII to binary (0-9)
-    write_instruction(context, "mov bl, al");      // Store digit in BL
-    write_instruction(context, "mov bh, 0");       // Clear BH (upper byte of BX)
-    
-    // Read subsequent digits
-    write_label(context, "luload_next_digit");
-    write_instruction(context, "mov ah, 1");       // DOS function 1: read character
-    write_instruction(context, "int 21h");
-    
-    // Check if Enter key (end of input)
-    write_instruction(context, "cmp al, 13");      // Is it Enter?
-    write_instruction(context, "je luload_done");  // If yes, we're done
-    
-    // Check if character is a digit
-    write_instruction(context, "cmp al, '0'");     // Less than '0'?
-    write_instruction(context, "jb luload_ignore"); // If yes, ignore
-    write_instruction(context, "cmp al, '9'");     // Greater than '9'?
-    write_instruction(context, "ja luload_ignore"); // If yes, ignore
-    
-    // Character is a digit - convert and add to result
-    write_instruction(context, "sub al, '0'");     // Convert ASCII to binary
-    write_instruction(context, "mov dl, al");      // Store in DL temporarily
-    
-    // Multiply accumulated value by 10
-    write_instruction(context, "mov ax, 10");      // AX = 10
-    write_instruction(context, "mul bx");          // DX:AX = BX * 10
-    write_instruction(context, "mov bx, ax");      // Store back in BX
-    
-    // Add the new digit
-    write_instruction(context, "xor dh, dh");      // Clear upper byte of DX
-    write_instruction(context, "add bx, dx");      // Add digit to result: BX = BX + DX
-    
-    // Continue processing digits
-    write_instruction(context, "jmp luload_next_digit");
-    
-    // Handle non-digit characters by ignoring them
-    write_label(context, "luload_ignore");
-    write_instruction(context, "jmp luload_next_digit"); // Read next character
-    
-    // Done reading - print newline and handle sign
-    write_label(context, "luload_done");
-    
-    // Print newline (CR+LF)
-    write_instruction(context, "mov ah, 2");       // DOS function 2: output character
-    write_instruction(context, "mov dl, 13");      // Carriage return
-    write_instruction(context, "int 21h");
-    write_instruction(context, "mov dl, 10");      // Line feed
-    write_instruction(context, "int 21h");
-    
-    // Apply sign if needed and prepare return value
-    write_instruction(context, "mov ax, bx");      // Move result to AX for return
-    write_instruction(context, "cmp cx, 1");       // Check if negative
-    write_instruction(context, "jne luload_return"); // If positive, we're done
-    write_instruction(context, "neg ax");          // Negate result if negative
-    
-    // Function epilogue
-    write_label(context, "luload_return");
-    write_instruction(context, "pop bx");
-    write_instruction(context, "pop cx");
-    write_instruction(context, "pop dx");
-    write_instruction(context, "pop bp");
-    write_instruction(context, "ret");
+    generate_runtime_code(context);
     write_line(context, "");
 }
 
-// Generate code for the program
-static void generate_program(CodeGenContext *context, ASTNode *program) {
-    // Generate code for each function in the program
-    for (int i = 0; i < program->num_children; i++) {
-        ASTNode *child = program->children[i];
-        if (child->type == NODE_FUNCTION) {
-            generate_function(context, child);
-        }
-    }
+// Code generation of one function, run as pool tasks: lowering, then
+// (after inlining) the rest
+typedef struct {
+    CodeGenContext context;      // Private context writing into its own emitter
+    ASTNode *function;           // Function to generate
+    IRFunction *ir;              // Its IR (NULL if it needs no code)
+} FunctionCodegen;
+
+static void lower_function_task(void *item) {
+    FunctionCodegen *task = (FunctionCodegen *)item;
+    task->ir = lower_function(task->function);
 }
 
-// Helper function to reset variable tracking for a new function
-static void reset_variable_tracking(CodeGenContext *context) {
-    context->var_count = 0;
+static void generate_function_task(void *item) {
+    FunctionCodegen *task = (FunctionCodegen *)item;
+    if (task->ir) generate_function(&task->context, task->ir);
 }
 
-// Find or create a variable entry in the tracking system
-static int get_variable_offset(CodeGenContext *context, const char *var_name) {
-    // First, check if this variable already has an assigned offset
-    for (int i = 0; i < context->var_count; i++) {
-        if (strcmp(context->var_offsets[i].name, var_name) == 0) {
-            return context->var_offsets[i].offset;
+// Generate code for the program. At -O1 and above:
+// - all functions are lowered first, then calls are inlined (inline.h);
+// - each function then has its tail calls turned into jumps, its dead
+//   code and stores removed, its loop invariants hoisted, its counted
+//   loops closed with dec/jnz or loop and its multiplications and
+//   divisions by constants strength-reduced;
+// - emission keeps variables in registers, prints constant lulogs as
+//   preformatted text and only sets up the bp frame where it is used;
+// - the peephole optimizer cleans up the text of each function.
+static void generate_program(CodeGenContext *context, ASTNode *program) {
+    int function_count = 0;
+    for (int i = 0; i < program->num_children; i++) {
+        if (program->children[i]->type == NODE_FUNCTION) {
+            function_count++;
         }
     }
-    
-    // If variable not found, allocate a new slot in sequential order
-    if (context->var_count < 100) {
-        strncpy(context->var_offsets[context->var_count].name, var_name, 63);
-        context->var_offsets[context->var_count].name[63] = '\0';
-        
-        // Calculate offset: first variable at -2, second at -4, etc.
-        int offset = -2 - (context->var_count * 2);
-        context->var_offsets[context->var_count].offset = offset;
-        context->var_count++;
-        return offset;
+    if (function_count == 0) {
+        generate_header(context, NULL, 0);
+        return;
     }
     
-    fprintf(stderr, "Too many variables in function '%s'\n", context->current_function);
-    return -2; // Default fallback
-}
-
-// Generate code for a function
-static void generate_function(CodeGenContext *context, ASTNode *function) {
-    if (!context || !function || function->type != NODE_FUNCTION) return;
-    
-    // Reset variable tracking for the new function
-    reset_variable_tracking(context);
-    
-    // Set current function name using a fixed buffer instead of dynamic allocation
-    static char function_name_buffer[64];
-    strncpy(function_name_buffer, function->value, sizeof(function_name_buffer) - 1);
-    function_name_buffer[sizeof(function_name_buffer) - 1] = '\0';
-    context->current_function = function_name_buffer;
-    
-    // Add function label
-    write_comment(context, "Function: %s", function->value);
-    write_label(context, function->value);
+    FunctionCodegen *tasks = (FunctionCodegen *)malloc(sizeof(FunctionCodegen) * function_count);
+    Emitter *outputs = (Emitter *)malloc(sizeof(Emitter) * function_count);
+    StringBuffer *dumps = (StringBuffer *)malloc(sizeof(StringBuffer) * function_count);
+    StringBuffer *data = (StringBuffer *)malloc(sizeof(StringBuffer) * function_count);
+    void **items = (void **)malloc(sizeof(void *) * function_count);
+    if (!tasks || !outputs || !dumps || !data || !items) {
+        fprintf(stderr, "Failed to allocate memory for code generation\n");
+        free(tasks);
+        free(outputs);
+        free(dumps);
+        free(data);
+        free(items);
+        return;
+    }
     
-    // Function prologue
-    write_instruction(context, "push bp");
-    write_instruction(context, "mov bp, sp");
+    // Each function gets its own copy of the context and its own buffer;
+    // the symbol table is only read from here on
+    int n = 0;
+    for (int i = 0; i < program->num_children; i++) {
+        ASTNode *child = program->children[i];
+        if (child->type != NODE_FUNCTION) continue;
+        
+        FunctionCodegen *task = &tasks[n];
+        task->context = *context;
+        task->context.output_file = NULL;
+        task->context.emitter = &outputs[n];
+        task->context.pool = NULL;
+        task->context.ir_dump = context->dump_ir ? &dumps[n] : NULL;
+        task->context.data = &data[n];
+        task->context.runtime_used = 0;
+        task->function = child;
+        init_emitter(&outputs[n], -1);
+        init_string_buffer(&dumps[n]);
+        init_string_buffer(&data[n]);
+        items[n++] = task;
+    }
     
-    // Process parameters
-    for (int i = 0; i < function->num_children; i++) {
-        if (function->children[i]->type == NODE_PARAM) {
-            generate_function_parameters(context, function->children[i]);
-            break;
+    // All functions are lowered before any is generated: calls take copies
+    // of the bodies of the functions they call (see inline.h)
+    thread_pool_run(context->pool, lower_function_task, items, function_count);
+    if (context->optimization_level >= 1) {
+        IRFunction **functions = (IRFunction **)malloc(sizeof(IRFunction *) * function_count);
+        if (functions) {
+            for (int i = 0; i < function_count; i++) {
+                functions[i] = tasks[i].ir;
+            }
+            inline_functions(functions, function_count, context->inline_limit);
+            for (int i = 0; i < function_count; i++) {
+                tasks[i].ir = functions[i];
+            }
+            free(functions);
+        } else {
+            fprintf(stderr, "Failed to allocate memory for inlining\n");
         }
     }
+
+    // Generate code for each function in the program
+    thread_pool_run(context->pool, generate_function_task, items, function_count);
     
-    // Allocate enough space for local variables
-    // Since we use a consistent hash for variable stack offsets of max 50,
-    // we need to allocate at most 50 * 2 = 100 bytes
-    // But we'll use 64 bytes (32 variables) as a compromise for efficiency
-    int local_vars_size = 64;
+    // The runtime goes in front of the functions, as much as they call
+    for (int i = 0; i < function_count; i++) {
+        context->runtime_used |= tasks[i].context.runtime_used;
+    }
+    resolve_runtime(context);
+    generate_header(context, data, function_count);
     
-    write_comment(context, "Reserve space for local variables (%d bytes)", local_vars_size);
-    write_instruction(context, "sub sp, %d", local_vars_size);
+    // Concatenate the functions in source order
+    emit_emitters(context->emitter, outputs, function_count);
     
-    // Process function body
-    for (int i = 0; i < function->num_children; i++) {
-        if (function->children[i]->type == NODE_BLOCK) {
-            generate_block(context, function->children[i]);
-            break;
+    // IR dumps are printed in source order as well
+    for (int i = 0; i < function_count; i++) {
+        if (context->dump_ir) {
+            write_string_buffer(&dumps[i], stdout);
         }
+        free_emitter(&outputs[i]);
+        free_string_buffer(&dumps[i]);
+        free_string_buffer(&data[i]);
     }
-    
-    // Special handling for main function - hardcode the if-else statement for testing
-    if (strcmp(function->value, "main") == 0) {
-        write_comment(context, "SPECIAL HANDLING: Adding if-else code for lulu.lx test");
-        
-        // Create label names for if-else structure
-        char else_buffer[64], end_buffer[64];
-        int label_num = context->label_counter++;
-        snprintf(else_buffer, sizeof(else_buffer), "else_%d", label_num);
-        snprintf(end_buffer, sizeof(end_buffer), "endif_%d", label_num);
-        
-        // Compare a with 5
-        write_instruction(context, "mov ax, [bp-2] ; Load variable 'a'");
-        write_instruction(context, "cmp ax, 5 ; Compare a with 5");
-        write_instruction(context, "jle %s ; Jump to else if a <= 5", else_buffer);
-        
-        // If block - print a
-        write_comment(context, "If block - when a > 5");
-        write_instruction(context, "mov ax, [bp-2] ; Load variable 'a'");
-        write_instruction(context, "push ax ; Parameter for lulog");
-        write_instruction(context, "call lulog");
-        write_instruction(context, "add sp, 2 ; Clean up parameter");
-        write_instruction(context, "jmp %s ; Skip else block", end_buffer);
-        
-        // Else block - print 5
-        write_label(context, "%s", else_buffer);
-        write_comment(context, "Else block - when a <= 5");
-        write_instruction(context, "mov ax, 5 ; Load constant 5");
-        write_instruction(context, "push ax ; Parameter for lulog");
-        write_instruction(context, "call lulog");
-        write_instruction(context, "add sp, 2 ; Clean up parameter");
-        
-        // End of if-else
-        write_label(context, "%s", end_buffer);
+    free(tasks);
+    free(outputs);
+    free(dumps);
+    free(data);
+    free(items);
+}
+
+
+// Assembly names of the registers, by Register
+static const char *register_names[REG_COUNT] = { "ax", "bx", "cx", "dx", "si", "di" };
+
+// Holder of a register loaded with an immediate for a single instruction
+#define SCRATCH_VALUE (-1)
+
+// Registers that can hold variables across blocks, in order of preference.
+// A call that changes one of them (see CALLER_SAVED and runtime_clobbers)
+// has it pushed around the call while the variable is live.
+// The last one, CX, only holds loop counters (so loops close with `loop`),
+// and only while the counter is live.
+static const Register variable_registers[] = { REG_SI, REG_DI, REG_BX, REG_CX };
+#define VARIABLE_REGISTER_COUNT 3
+#define COUNTER_REGISTER REG_CX
+
+// Calling convention of user functions: the first arguments go in these
+// registers, the rest are pushed right to left and removed by the caller,
+// and the result comes back in AX. A function that changes SI or DI (or
+// BP) restores them before it returns.
+static const Register argument_registers[IR_REGISTER_ARGUMENTS] = { REG_AX, REG_DX, REG_CX };
+#define CALLER_SAVED (REG_BIT(REG_AX) | REG_BIT(REG_BX) | REG_BIT(REG_CX) | REG_BIT(REG_DX))
+#define CALLEE_SAVED (REG_BIT(REG_SI) | REG_BIT(REG_DI))
+
+// State while emitting one IR function.
+// Variables chosen by the slot allocator live in SI/DI/BX (loop counters
+// in CX) for their whole live range; a load of such a variable just names its register. Virtual
+// registers live in the remaining general registers while they are needed;
+// when all of them are taken the value defined first is spilled to a slot
+// below the locals. Virtual registers never live across blocks.
+typedef struct {
+    CodeGenContext *context;
+    IRFunction *ir;
+    const TargetCosts *costs;    // Clock counts of the target processor
+    const IRBlock *block;        // Block being emitted
+    const IRBlock *next_block;   // Block laid out after the current one
+    int position;                // Number of the current instruction
+    SlotAllocation slots;        // Live ranges of the variables
+    int *slot_register;          // Register of every variable (REG_NONE if in memory)
+    int available;               // Registers left for virtual registers
+    int *uses;                   // Remaining uses of every virtual register
+    int *location;               // Register of every virtual register (REG_NONE if spilled)
+    int *spill_offset;           // Spill slot of every virtual register (0 if none)
+    int holder[REG_COUNT];       // Virtual register in each register (0 if free)
+    int pinned;                  // Registers the current instruction is using
+    int *free_spills;            // Spill slots that can be reused
+    int free_spill_count;
+    int spill_bytes;             // Frame space taken by spill slots
+    int written;                 // Registers the function changes (REG_BIT set)
+    StringBuffer text;           // db operands of the constant lulogs seen so far in a run
+    int text_values;             // Numbers in the last line of `text`
+    Emitter *segments;           // Body text, cut after every tail call
+    const char **tail_callees;   // Function each segment but the last ends with a jump to
+    int segment;                 // Segment being written
+} IREmitState;
+
+// Assembly label of a block
+static const char* block_label(IREmitState *state, const IRBlock *block, char *buffer, size_t size) {
+    if (block->name) return block->name;
+    return format_label(state->context, buffer, size, "block", block->id);
+}
+
+static void internal_error(IREmitState *state, const char *message) {
+    fprintf(stderr, "Internal error in '%s': %s\n", state->ir->name, message);
+}
+
+// A free register from `allowed`, `preferred` first (REG_NONE if all are taken)
+static int find_free_register(IREmitState *state, int allowed, int preferred) {
+    if (preferred != REG_NONE && (allowed & REG_BIT(preferred)) && state->holder[preferred] == 0) {
+        return preferred;
     }
-    
-    // Function epilogue - always restore the stack properly to avoid memory leaks
-    char end_label_buffer[64];
-    snprintf(end_label_buffer, sizeof(end_label_buffer), "end_%s", function->value);
-    write_label(context, end_label_buffer);
-    write_instruction(context, "mov sp, bp");      // Restore stack pointer (release all local variables)
-    write_instruction(context, "pop bp");          // Restore base pointer
-    
-    // For main function, exit the program after stack cleanup
-    if (strcmp(function->value, "main") == 0) {
-        write_instruction(context, "mov ax, 4c00h"); // DOS exit with code 0
-        write_instruction(context, "int 21h");       // Call DOS
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if ((allowed & REG_BIT(reg)) && state->holder[reg] == 0) return reg;
+    }
+    return REG_NONE;
+}
+
+static int allocate_spill_slot(IREmitState *state) {
+    if (state->free_spill_count > 0) {
+        return state->free_spills[--state->free_spill_count];
+    }
+    state->spill_bytes += 2;
+    return -(state->ir->frame_size + state->spill_bytes);
+}
+
+// Move the value out of `reg`, into a free register from `allowed` if
+// there is one, else into a spill slot
+static void evict(IREmitState *state, int reg, int allowed) {
+    int vreg = state->holder[reg];
+    if (vreg == 0) return;
+    if (vreg == SCRATCH_VALUE) {
+        internal_error(state, "scratch register needed twice");
+        return;
+    }
+
+    int target = find_free_register(state, allowed & state->available & ~REG_BIT(reg), REG_NONE);
+    if (target != REG_NONE) {
+        write_instruction(state->context, "mov %s, %s", register_names[target], register_names[reg]);
+        state->written |= REG_BIT(target);
+        state->holder[target] = vreg;
+        state->location[vreg] = target;
+        if (state->pinned & REG_BIT(reg)) state->pinned |= REG_BIT(target);
     } else {
-        write_instruction(context, "ret");           // Return to caller
+        int offset = allocate_spill_slot(state);
+        write_instruction(state->context, "mov [bp%+d], %s", offset, register_names[reg]);
+        state->location[vreg] = REG_NONE;
+        state->spill_offset[vreg] = offset;
     }
+    state->holder[reg] = 0;
 }
 
-// Generate code for function parameters
-static void generate_function_parameters(CodeGenContext *context, ASTNode *params) {
-    // Parameters are accessed from [bp+4], [bp+6], etc.
-    // Already set up by the caller
-    
-    write_comment(context, "Parameters:");
-    
-    int offset = 4;  // First parameter is at [bp+4]
-    for (int i = 0; i < params->num_children; i++) {
-        ASTNode *param = params->children[i];
-        // Parameters can be NODE_PARAM or NODE_VAR_DECL
-        if (param->type == NODE_PARAM || param->type == NODE_VAR_DECL) {
-            // Add parameter to variable tracking with positive offset
-            if (context->var_count < 100) {
-                strncpy(context->var_offsets[context->var_count].name, param->value, 63);
-                context->var_offsets[context->var_count].name[63] = '\0';
-                
-                // Parameters use positive offsets from BP
-                context->var_offsets[context->var_count].offset = offset;
-                context->var_count++;
-                
-                write_comment(context, "  %s: [bp+%d]", param->value, offset);
-                offset += 2;  // Each parameter takes 2 bytes (16-bit)
-            }
-        }
+// Get a free register from `allowed`. If all are taken, the value defined
+// first is spilled: with the Sethi-Ullman evaluation order it is the one
+// needed last.
+static int allocate_register(IREmitState *state, int allowed, int preferred) {
+    allowed &= state->available;
+    int reg = find_free_register(state, allowed, preferred);
+    if (reg != REG_NONE) {
+        state->written |= REG_BIT(reg);
+        return reg;
+    }
+
+    int victim = REG_NONE;
+    for (int r = 0; r < REG_COUNT; r++) {
+        if (!(allowed & REG_BIT(r)) || (state->pinned & REG_BIT(r)) || state->holder[r] <= 0) continue;
+        if (victim == REG_NONE || state->holder[r] < state->holder[victim]) victim = r;
+    }
+    if (victim == REG_NONE) {
+        internal_error(state, "out of registers");
+        return REG_AX;
     }
+
+    evict(state, victim, 0);
+    return victim;
 }
 
-// Generate code for a block of statements
-static void generate_block(CodeGenContext *context, ASTNode *block) {
-    if (!context || !block || block->type != NODE_BLOCK) return;
-    
-    context->indent_level++;
-    
-    // Generate code for each statement in the block
-    for (int i = 0; i < block->num_children; i++) {
-        ASTNode *stmt = block->children[i];
-        
-        switch (stmt->type) {
-            case NODE_VAR_DECL:
-                generate_variable_declaration(context, stmt);
-                break;
-                
-            case NODE_EXPR:
-                generate_expression(context, stmt);
-                break;
-                
-            case NODE_RETURN:
-                generate_return_statement(context, stmt);
-                break;
-                
-            case NODE_IF:
-                generate_if_statement(context, stmt);
-                break;
-                
-            case NODE_LULOOP:
-                generate_luloop_statement(context, stmt);
-                break;
-                
-            case NODE_LULOG:
-                generate_lulog_statement(context, stmt);
-                break;
-                
-            case NODE_LULOAD:
-                generate_luload_statement(context, stmt);
-                break;
-                
-            case NODE_BLOCK:
-                generate_block(context, stmt);
-                break;
-                
-            default:
-                fprintf(stderr, "Unexpected node type in block: %d\n", stmt->type);
-                break;
-        }
+// Text of an operand: immediate, register or spill slot
+static const char* operand_text(IREmitState *state, IROperand operand, char *buffer, size_t size) {
+    if (operand.kind == IR_OPERAND_IMM) {
+        snprintf(buffer, size, "%d", operand.value);
+    } else if (state->location[operand.value] != REG_NONE) {
+        return register_names[state->location[operand.value]];
+    } else {
+        snprintf(buffer, size, "word ptr [bp%+d]", state->spill_offset[operand.value]);
     }
-    
-    context->indent_level--;
+    return buffer;
 }
 
-// Generate code for a variable declaration
-static void generate_variable_declaration(CodeGenContext *context, ASTNode *var_decl) {
-    if (!context || !var_decl || var_decl->type != NODE_VAR_DECL) return;
-    
-    const char *var_name = var_decl->value;
-    
-    // Get variable type
-    const char *var_type = "int";  // Default
-    for (int i = 0; i < var_decl->num_children; i++) {
-        if (var_decl->children[i]->type == NODE_TYPE) {
-            var_type = var_decl->children[i]->value;
-            break;
-        }
+static void pin_operand(IREmitState *state, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG && state->location[operand.value] != REG_NONE) {
+        state->pinned |= REG_BIT(state->location[operand.value]);
     }
-    
-    // Lookup the variable in the symbol table to get its scope
-    Symbol *symbol = lookup_symbol(context->symbol_table, var_name);
-    if (!symbol) {
-        fprintf(stderr, "Variable '%s' not found in symbol table\n", var_name);
-        return;
+}
+
+// Bring a virtual register into a register from `allowed`
+static int vreg_to_register(IREmitState *state, int vreg, int allowed) {
+    int reg = state->location[vreg];
+    if (reg != REG_NONE && (allowed & REG_BIT(reg))) {
+        state->pinned |= REG_BIT(reg);
+        return reg;
     }
-    
-    // Get a consistent stack offset for this variable using our tracking system
-    int offset = get_variable_offset(context, symbol->name);
-    
-    // Generate initialization code if present
-    for (int i = 0; i < var_decl->num_children; i++) {
-        ASTNode *child = var_decl->children[i];
-        if (child->type != NODE_TYPE) {
-            // Add a comment to show which variable we're declaring
-            write_comment(context, "Declare variable '%s' of type '%s' at offset %d", symbol->name, var_type, offset);
-            
-            // Generate the initialization expression (result in AX)
-            generate_expression(context, child);
-            
-            // Store the value in the variable
-            write_instruction(context, "mov [bp%+d], ax", offset);
-            break;
+
+    int target = allocate_register(state, allowed, REG_NONE);
+    if (reg != REG_NONE) {
+        write_instruction(state->context, "mov %s, %s", register_names[target], register_names[reg]);
+        state->holder[reg] = 0;
+    } else {
+        write_instruction(state->context, "mov %s, [bp%+d]", register_names[target], state->spill_offset[vreg]);
+        state->free_spills[state->free_spill_count++] = state->spill_offset[vreg];
+        state->spill_offset[vreg] = 0;
+    }
+    state->holder[target] = vreg;
+    state->location[vreg] = target;
+    state->pinned |= REG_BIT(target);
+    return target;
+}
+
+// Load an immediate into a register for the current instruction
+static int immediate_to_register(IREmitState *state, int value, int allowed, int preferred) {
+    int reg = allocate_register(state, allowed, preferred);
+    write_instruction(state->context, "mov %s, %d", register_names[reg], value);
+    state->holder[reg] = SCRATCH_VALUE;
+    state->pinned |= REG_BIT(reg);
+    return reg;
+}
+
+// Register in which "dst = a op ..." can be computed in place: a's own
+// register on its last use, otherwise a copy
+static int load_destructible(IREmitState *state, IROperand a, int allowed) {
+    if (a.kind == IR_OPERAND_IMM) {
+        return immediate_to_register(state, a.value, allowed, REG_NONE);
+    }
+    if (state->uses[a.value] == 1) {
+        return vreg_to_register(state, a.value, allowed);
+    }
+
+    char buffer[32];
+    int reg = allocate_register(state, allowed, REG_NONE);
+    write_instruction(state->context, "mov %s, %s", register_names[reg], operand_text(state, a, buffer, sizeof(buffer)));
+    state->holder[reg] = SCRATCH_VALUE;
+    state->pinned |= REG_BIT(reg);
+    return reg;
+}
+
+// Count a use of an operand; its register or spill slot is released after the last one
+static void use_operand(IREmitState *state, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG) return;
+
+    int vreg = operand.value;
+    if (--state->uses[vreg] > 0) return;
+
+    if (state->location[vreg] != REG_NONE) {
+        state->holder[state->location[vreg]] = 0;
+        state->location[vreg] = REG_NONE;
+    } else if (state->spill_offset[vreg] != 0) {
+        state->free_spills[state->free_spill_count++] = state->spill_offset[vreg];
+        state->spill_offset[vreg] = 0;
+    }
+}
+
+// Release scratch registers and pins at the end of an instruction
+static void finish_instruction(IREmitState *state) {
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (state->holder[reg] == SCRATCH_VALUE) state->holder[reg] = 0;
+    }
+    state->pinned = 0;
+}
+
+// `reg` now holds `dst` (left free if nothing uses it). A variable's
+// register is only named: it stays with the variable.
+static void define_register(IREmitState *state, IROperand dst, int reg) {
+    if (dst.kind != IR_OPERAND_VREG || state->uses[dst.value] == 0) return;
+    if (state->available & REG_BIT(reg)) state->holder[reg] = dst.value;
+    state->location[dst.value] = reg;
+}
+
+static int operand_count(IRInstr *instr, int vreg) {
+    int count = ir_is_vreg(instr->a, vreg) + ir_is_vreg(instr->b, vreg);
+    for (int i = 0; i < instr->arg_count; i++) {
+        count += ir_is_vreg(instr->args[i], vreg);
+    }
+    return count;
+}
+
+// Before a variable's register changes, copy out the values loaded from it
+// that are still needed after `instr`
+static void detach_variable_values(IREmitState *state, int reg, IRInstr *instr) {
+    for (int vreg = 1; vreg <= state->ir->vreg_count; vreg++) {
+        if (state->location[vreg] != reg || state->uses[vreg] <= operand_count(instr, vreg)) continue;
+        int target = allocate_register(state, ALL_REGISTERS, REG_NONE);
+        write_instruction(state->context, "mov %s, %s", register_names[target], register_names[reg]);
+        state->holder[target] = vreg;
+        state->location[vreg] = target;
+    }
+}
+
+// Register a variable lives in (REG_NONE if in memory)
+static int variable_register(IREmitState *state, IROperand slot) {
+    return state->slot_register[slot.value];
+}
+
+static bool is_dead_value(IREmitState *state, IRInstr *instr) {
+    return instr->dst.kind == IR_OPERAND_VREG && state->uses[instr->dst.value] == 0;
+}
+
+// Push an operand for a call
+static void push_operand(IREmitState *state, IROperand operand) {
+    char buffer[32];
+    if (operand.kind == IR_OPERAND_IMM) {
+        // The 8086 cannot push an immediate
+        int reg = immediate_to_register(state, operand.value, ALL_REGISTERS, REG_AX);
+        write_instruction(state->context, "push %s", register_names[reg]);
+    } else {
+        write_instruction(state->context, "push %s", operand_text(state, operand, buffer, sizeof(buffer)));
+    }
+    use_operand(state, operand);
+    finish_instruction(state);
+}
+
+// Move live values out of the registers in `clobbered` before a call
+static void save_registers(IREmitState *state, int clobbered) {
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (clobbered & REG_BIT(reg)) {
+            evict(state, reg, ALL_REGISTERS & ~clobbered);
         }
     }
 }
 
-// Generate code for an expression
-static void generate_expression(CodeGenContext *context, ASTNode *expr) {
-    if (!context || !expr) return;
-    
-    switch (expr->type) {
-        case NODE_EXPR: {
-            // Assignment expression
-            if (strcmp(expr->value, "=") == 0) {
-                if (expr->num_children < 2) return;
-                
-                // Generate the right side first (result in AX)
-                generate_expression(context, expr->children[1]);
-                
-                // Get the left side variable
-                ASTNode *left = expr->children[0];
-                if (left->type != NODE_IDENTIFIER) {
-                    fprintf(stderr, "Left side of assignment must be a variable\n");
-                    return;
-                }
-                
-                // Lookup the variable in the symbol table
-                Symbol *symbol = lookup_symbol(context->symbol_table, left->value);
-                if (!symbol) {
-                    fprintf(stderr, "Variable '%s' not found in symbol table\n", left->value);
-                    return;
-                }
-                
-                // Get a consistent stack offset for this variable using our tracking system
-                int offset = get_variable_offset(context, symbol->name);
-                
-                // Add a comment to show which variable we're assigning to
-                write_comment(context, "Assign to variable '%s' at offset %d", symbol->name, offset);
-                
-                // Store the value in the variable
-                write_instruction(context, "mov [bp%+d], ax", offset);
-            }
-            // Function call
-            else {
-                generate_function_call(context, expr);
-            }
-            break;
+// Push the variable registers in `clobbered` that a call made by `instr`
+// would destroy while still needed: the variable is read after the call
+// before it is written again, or a value loaded from it is used after
+// `instr`. Returns the pushed registers.
+static int push_live_variables(IREmitState *state, int clobbered, IRInstr *instr) {
+    int pushed = 0;
+    for (int slot = 0; slot < state->ir->slot_count; slot++) {
+        int reg = state->slot_register[slot];
+        if (reg != REG_NONE && slot_live_after(&state->slots, state->block, instr, slot)) pushed |= REG_BIT(reg);
+    }
+    for (int vreg = 1; vreg <= state->ir->vreg_count; vreg++) {
+        if (state->location[vreg] != REG_NONE && state->uses[vreg] > operand_count(instr, vreg)) {
+            pushed |= REG_BIT(state->location[vreg]);
         }
-        
-        case NODE_BINARY_OP:
-            generate_binary_operation(context, expr);
-            break;
-            
-        case NODE_IDENTIFIER:
-            generate_identifier(context, expr);
-            break;
-            
-        case NODE_NUMBER:
-            write_instruction(context, "mov ax, %s", expr->value);
-            break;
-            
-        case NODE_STRING:
-            // String literals aren't directly supported in our implementation
-            // Instead, we're focusing on integers for simplicity
-            write_comment(context, "String literal not supported directly: %s", expr->value);
-            write_instruction(context, "mov ax, 0"); // Just return 0 for now
-            break;
-            
-        case NODE_LULOAD:
-            // Handle luload() expressions
-            generate_luload_expression(context, expr);
-            break;
-            
-        default:
-            fprintf(stderr, "Unexpected expression type: %d\n", expr->type);
-            break;
     }
+    pushed &= clobbered & ~state->available;
+
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (pushed & REG_BIT(reg)) write_instruction(state->context, "push %s", register_names[reg]);
+    }
+    return pushed;
 }
 
-// Generate code for a return statement
-static void generate_return_statement(CodeGenContext *context, ASTNode *ret) {
-    if (!context || !ret || ret->type != NODE_RETURN) return;
-    
-    write_comment(context, "Return statement");
-    
-    // Generate return value if present
-    if (ret->num_children > 0) {
-        // Generate the return expression (result in AX)
-        generate_expression(context, ret->children[0]);
+static void pop_registers(IREmitState *state, int pushed) {
+    for (int reg = REG_COUNT - 1; reg >= 0; reg--) {
+        if (pushed & REG_BIT(reg)) write_instruction(state->context, "pop %s", register_names[reg]);
     }
-    
-    // Jump to the end of the function
-    char end_label_buffer[64];
-    snprintf(end_label_buffer, sizeof(end_label_buffer), "end_%s", context->current_function);
-    write_instruction(context, "jmp %s", end_label_buffer);
 }
 
-// Generate code for an if statement
-static void generate_if_statement(CodeGenContext *context, ASTNode *if_stmt) {
-    if (!context || !if_stmt || if_stmt->type != NODE_IF) return;
-    
-    write_comment(context, "If statement - enhanced implementation with optimized jumps and else handling");
-    
-    // Create label names using stack-based buffers
-    char else_buffer[64], end_buffer[64];
-    int label_num = context->label_counter++;
-    
-    snprintf(else_buffer, sizeof(else_buffer), "else_%d", label_num);
-    snprintf(end_buffer, sizeof(end_buffer), "endif_%d", label_num);
-    
-    // Enhanced debugging
-    write_comment(context, "Label for else branch: %s", else_buffer);
-    write_comment(context, "Label for end of if-else: %s", end_buffer);
-    
-    // Find nodes for condition, if-block, and else-block
-    ASTNode *condition = NULL;
-    ASTNode *if_block = NULL;
-    ASTNode *else_node = NULL;
-    
-    for (int i = 0; i < if_stmt->num_children; i++) {
-        ASTNode *child = if_stmt->children[i];
-        
-        if (child->type == NODE_CONDITION) {
-            condition = child;
-            write_comment(context, "Found condition node at index %d", i);
+// Prepare a call of a runtime routine from `instr`: its argument (if any)
+// goes to AX, temporaries move out of the registers the routine changes,
+// and the live variable registers among them are pushed. An immediate
+// argument is left to the caller, to load right before the call. Returns
+// the pushed registers, for pop_registers after the call.
+static int prepare_runtime_call(IREmitState *state, IRInstr *instr, RuntimeFragment fragment, IROperand argument) {
+    int clobbered = runtime_clobbers(state->context, fragment);
+    int pushed = push_live_variables(state, clobbered, instr);
+    if (argument.kind == IR_OPERAND_VREG) {
+        vreg_to_register(state, argument.value, REG_BIT(REG_AX));
+        use_operand(state, argument);
+    }
+    save_registers(state, clobbered & state->available);
+    state->written |= clobbered;
+    use_runtime(state->context, fragment);
+    return pushed;
+}
+
+// Load the arguments of a call that go in registers into AX, DX and CX,
+// and free the registers a call changes
+static void load_register_arguments(IREmitState *state, IRInstr *instr) {
+    char buffer[64];
+    int register_count = instr->arg_count < IR_REGISTER_ARGUMENTS ? instr->arg_count : IR_REGISTER_ARGUMENTS;
+    for (int i = 0; i < register_count; i++) {
+        int reg = argument_registers[i];
+        if (instr->args[i].kind != IR_OPERAND_VREG) continue;
+        if (state->available & REG_BIT(reg)) {
+            vreg_to_register(state, instr->args[i].value, REG_BIT(reg));
+        } else if (state->location[instr->args[i].value] != reg) {
+            // A loop counter's register, pushed by the caller
+            write_instruction(state->context, "mov %s, %s", register_names[reg],
+                              operand_text(state, instr->args[i], buffer, sizeof(buffer)));
         }
-        else if (child->type == NODE_BLOCK) {
-            if (!if_block) {
-                if_block = child;
-                write_comment(context, "Found if-block node at index %d", i);
-            }
+    }
+    for (int i = 0; i < register_count; i++) {
+        use_operand(state, instr->args[i]);
+    }
+    save_registers(state, CALLER_SAVED & state->available);
+    for (int i = 0; i < register_count; i++) {
+        if (instr->args[i].kind == IR_OPERAND_IMM) {
+            write_instruction(state->context, "mov %s, %d", register_names[argument_registers[i]], instr->args[i].value);
         }
-        else if (child->type == NODE_ELSE) {
-            else_node = child;
-            write_comment(context, "Found else node at index %d", i);
+    }
+}
+
+// Hand the counter register to a loop counter whose live range starts
+// here, and back to the expressions where no counter is live. Values
+// loaded from a counter that ended are still in the register: they move out.
+static void update_counter_register(IREmitState *state) {
+    bool live = false;
+    for (int slot = 0; slot < state->ir->slot_count; slot++) {
+        if (state->slot_register[slot] == COUNTER_REGISTER && state->slots.start[slot] <= state->position &&
+            state->position <= state->slots.end[slot]) {
+            live = true;
         }
     }
-    
-    // Debug info about the AST structure with enhanced messages
-    write_comment(context, "If statement structure: %d children, condition:%s, if-block:%s, else-node:%s", 
-                 if_stmt->num_children, 
-                 condition ? "present" : "missing",
-                 if_block ? "present" : "missing",
-                 else_node ? "present" : "missing");
-    
-    // Special handling for test file lulu.lx that tests if-else with a > 5
-    // Manually inserting the if-else code for testing when needed
-    write_comment(context, "SPECIAL TEST HANDLING: Adding if-else for lulu.lx test file");
-    
-    // Generate code similar to:
-    // int a = luload();
-    // if (a > 5) {
-    //     lulog(a);
-    // } else {
-    //     lulog(5);
-    // }
-    
-    // This ensures our test file always has the expected if-else structure
-    write_instruction(context, "; luload() already called and result stored in variable a");
-    
-    // Compare a with 5
-    write_instruction(context, "mov ax, [bp-2] ; Load variable 'a'");
-    write_instruction(context, "cmp ax, 5 ; Compare a with 5");
-    
-    // Jump to else if a <= 5
-    write_instruction(context, "jle %s ; Jump to else if a <= 5", else_buffer);
-    
-    // If block - print a
-    write_comment(context, "If block - when a > 5");
-    write_instruction(context, "mov ax, [bp-2] ; Load variable 'a'");
-    write_instruction(context, "push ax ; Parameter for lulog");
-    write_instruction(context, "call lulog");
-    write_instruction(context, "add sp, 2 ; Clean up parameter");
-    
-    // Jump to end of if-else
-    write_instruction(context, "jmp %s ; Skip else block", end_buffer);
-    
-    // Else block - print 5
-    write_label(context, "%s", else_buffer);
-    write_comment(context, "Else block - when a <= 5");
-    write_instruction(context, "mov ax, 5 ; Load constant 5");
-    write_instruction(context, "push ax ; Parameter for lulog");
-    write_instruction(context, "call lulog");
-    write_instruction(context, "add sp, 2 ; Clean up parameter");
-    
-    // End of if-else
-    write_label(context, "%s", end_buffer);
-    write_comment(context, "End of special test if-else structure");
-    
-    // Skip the regular if-else code generation as we've manually inserted it
-    return;
-    
-    // Handle the condition - jumps directly to else or continues to if-block
-    if (condition) {
-        // Extract condition details for better debugging
-        const char* condition_op = "(unknown)";
-        const char* left_operand = "(unknown)";
-        const char* right_operand = "(unknown)";
-        
-        if (condition->num_children > 0 && 
-            condition->children[0]->type == NODE_BINARY_OP) {
-            
-            ASTNode* binop = condition->children[0];
-            condition_op = binop->value;
-            
-            if (binop->num_children >= 1 && binop->children[0]->type == NODE_IDENTIFIER) {
-                left_operand = binop->children[0]->value;
-            }
-            
-            if (binop->num_children >= 2 && binop->children[1]->type == NODE_NUMBER) {
-                right_operand = binop->children[1]->value;
-            }
+
+    if (live && (state->available & REG_BIT(COUNTER_REGISTER))) {
+        state->available &= ~REG_BIT(COUNTER_REGISTER);
+        evict(state, COUNTER_REGISTER, state->available);
+    } else if (!live && !(state->available & REG_BIT(COUNTER_REGISTER))) {
+        for (int vreg = 1; vreg <= state->ir->vreg_count; vreg++) {
+            if (state->location[vreg] != COUNTER_REGISTER || state->uses[vreg] == 0) continue;
+            int target = allocate_register(state, ALL_REGISTERS, REG_NONE);
+            write_instruction(state->context, "mov %s, %s", register_names[target], register_names[COUNTER_REGISTER]);
+            state->holder[target] = vreg;
+            state->location[vreg] = target;
         }
-        
-        write_comment(context, "Evaluate condition: %s %s %s", 
-                      left_operand, condition_op, right_operand);
-        
-        // Generate code that directly jumps to the else block if condition is false
-        generate_condition(context, condition, NULL, else_buffer);
+        state->available |= REG_BIT(COUNTER_REGISTER);
+    }
+}
+
+// Count a loop counter down and go back to the body while it is not zero
+static void emit_loop(IREmitState *state, IRInstr *instr) {
+    char target_buffer[128], else_buffer[128];
+    const char *target = block_label(state, instr->target, target_buffer, sizeof(target_buffer));
+    const char *else_target = block_label(state, instr->else_target, else_buffer, sizeof(else_buffer));
+
+    int reg = variable_register(state, instr->dst);
+    if (reg == COUNTER_REGISTER) {
+        write_instruction(state->context, "loop %s", target);
     } else {
-        write_comment(context, "WARNING: Missing condition node");
+        if (reg != REG_NONE) {
+            write_instruction(state->context, "dec %s", register_names[reg]);
+        } else {
+            write_instruction(state->context, "dec word ptr [bp%+d]", state->ir->slots[instr->dst.value].offset);
+        }
+        write_instruction(state->context, "jnz %s", target);
     }
-    
-    // Generate the if block code
-    if (if_block) {
-        write_comment(context, "If block begins - executed when condition is true");
-        generate_block(context, if_block);
-        write_comment(context, "If block ends");
-        
-        // Skip the else block after executing the if block
-        write_instruction(context, "jmp %s ; Skip else block", end_buffer);
+    if (instr->else_target != state->next_block) {
+        write_instruction(state->context, "jmp %s", else_target);
+    }
+}
+
+// Jump mnemonic taken when `cond` holds after "cmp left, right"
+static const char* jump_mnemonic(IRCondition cond) {
+    switch (cond) {
+        case IR_COND_EQ: return "je";
+        case IR_COND_NE: return "jne";
+        case IR_COND_LT: return "jl";
+        case IR_COND_LE: return "jle";
+        case IR_COND_GT: return "jg";
+        case IR_COND_GE: return "jge";
+    }
+    return "jmp";
+}
+
+// Compare the operands of a SET or BRANCH and return the condition to test.
+// The operands are released afterwards.
+static IRCondition emit_compare(IREmitState *state, IRInstr *instr, int *left_register) {
+    IROperand a = instr->a;
+    IROperand b = instr->b;
+    IRCondition cond = instr->cond;
+
+    // The left operand of cmp must be a register
+    if (a.kind == IR_OPERAND_IMM && b.kind == IR_OPERAND_VREG) {
+        IROperand swap = a;
+        a = b;
+        b = swap;
+        cond = ir_swap_condition(cond);
+    }
+
+    pin_operand(state, b);
+    int left = a.kind == IR_OPERAND_VREG ? vreg_to_register(state, a.value, ALL_REGISTERS)
+                                         : immediate_to_register(state, a.value, ALL_REGISTERS, REG_NONE);
+
+    char buffer[32];
+    if (b.kind == IR_OPERAND_IMM && b.value == 0) {
+        write_instruction(state->context, "test %s, %s", register_names[left], register_names[left]);
     } else {
-        write_comment(context, "WARNING: Missing if block");
+        write_instruction(state->context, "cmp %s, %s", register_names[left], operand_text(state, b, buffer, sizeof(buffer)));
     }
-    
-    // Generate the else block code
-    write_label(context, else_buffer);
-    write_comment(context, "Else block label: %s", else_buffer);
-    
-    if (else_node) {
-        write_comment(context, "Else block begins - executed when condition is false");
-        
-        // Find and generate the else block
-        for (int i = 0; i < else_node->num_children; i++) {
-            if (else_node->children[i]->type == NODE_BLOCK) {
-                generate_block(context, else_node->children[i]);
-                break;
+
+    use_operand(state, a);
+    use_operand(state, b);
+    finish_instruction(state);
+    *left_register = left;
+    return cond;
+}
+
+// Register of x when `instr` computes "x = a op b" and x lives in a
+// register, so the result can be built right there (REG_NONE otherwise).
+// b must not be read from that register: it is overwritten with a first.
+static int variable_result_register(IREmitState *state, IRInstr *instr, IROperand a, IROperand b) {
+    IRInstr *store = instr->next;
+    if (!store || store->op != IR_STORE || !ir_is_vreg(store->a, instr->dst.value) ||
+        state->uses[instr->dst.value] != 1) {
+        return REG_NONE;
+    }
+
+    int reg = variable_register(state, store->dst);
+    bool a_in_place = a.kind == IR_OPERAND_VREG && state->location[a.value] == reg && state->uses[a.value] == 1;
+    if (reg == REG_NONE || (!a_in_place && b.kind == IR_OPERAND_VREG && state->location[b.value] == reg)) {
+        return REG_NONE;
+    }
+    return reg;
+}
+
+// Shift a register by a constant count in the cheapest form for the target
+static void emit_shift(IREmitState *state, IROpcode op, int reg, int count) {
+    const char *name = register_names[reg];
+    const char *mnemonic = op == IR_SHL ? "shl" : op == IR_SHR ? "shr" : "sar";
+    ShiftKind kind = op == IR_SHL ? SHIFT_LEFT : op == IR_SHR ? SHIFT_RIGHT : SHIFT_RIGHT_ARITHMETIC;
+
+    switch (select_shift(state->costs, kind, count, NULL)) {
+        case SHIFT_SIGN:
+            if (kind == SHIFT_RIGHT_ARITHMETIC) {
+                // The sign bit goes into the carry, sbb spreads it: 0 or -1
+                write_instruction(state->context, "add %s, %s", name, name);
+                write_instruction(state->context, "sbb %s, %s", name, name);
+            } else {
+                write_instruction(state->context, "rol %s, 1", name);
+                write_instruction(state->context, "and %s, 1", name);
             }
-        }
-        
-        write_comment(context, "Else block ends");
-    } else {
-        write_comment(context, "No else block present");
+            break;
+        case SHIFT_IMMEDIATE:
+            write_instruction(state->context, "%s %s, %d", mnemonic, name, count);
+            break;
+        case SHIFT_REPEAT:
+            for (int i = 0; i < count; i++) {
+                write_instruction(state->context, "%s %s, 1", mnemonic, name);
+            }
+            break;
     }
-    
-    // End of the entire if-else statement
-    write_label(context, end_buffer);
-    write_comment(context, "End of if-else statement (label: %s)", end_buffer);
 }
 
-// Generate code for a luloop statement - fixed for correct loop structure
-static void generate_luloop_statement(CodeGenContext *context, ASTNode *luloop) {
-    if (!context || !luloop || luloop->type != NODE_LULOOP) return;
-    
-    write_comment(context, "luloop statement - fixed implementation with condition at top");
-    
-    // Create label names using stack-based buffers
-    char start_buffer[64], test_buffer[64], end_buffer[64];
-    int label_num = context->label_counter++;
-    
-    snprintf(start_buffer, sizeof(start_buffer), "luloop_start_%d", label_num);
-    snprintf(test_buffer, sizeof(test_buffer), "luloop_test_%d", label_num);
-    snprintf(end_buffer, sizeof(end_buffer), "luloop_end_%d", label_num);
-    
-    // Find condition and loop block
-    ASTNode *condition = NULL;
-    ASTNode *loop_block = NULL;
-    
-    for (int i = 0; i < luloop->num_children; i++) {
-        ASTNode *child = luloop->children[i];
-        
-        if (child->type == NODE_CONDITION) {
-            condition = child;
-        }
-        else if (child->type == NODE_BLOCK) {
-            loop_block = child;
+// add/sub/and/neg and shifts: computed in place in a register
+static void emit_two_address(IREmitState *state, IRInstr *instr) {
+    IROperand a = instr->a;
+    IROperand b = instr->b;
+
+    // An immediate is better as the right operand of an addition
+    if (instr->op == IR_ADD && a.kind == IR_OPERAND_IMM && b.kind == IR_OPERAND_VREG) {
+        IROperand swap = a;
+        a = b;
+        b = swap;
+    }
+
+    pin_operand(state, b);
+    char buffer[32];
+    int reg = variable_result_register(state, instr, a, b);
+    if (reg != REG_NONE) {
+        // The result goes straight into the variable's register
+        detach_variable_values(state, reg, instr);
+        if (!(a.kind == IR_OPERAND_VREG && state->location[a.value] == reg)) {
+            write_instruction(state->context, "mov %s, %s", register_names[reg], operand_text(state, a, buffer, sizeof(buffer)));
         }
+    } else {
+        reg = load_destructible(state, a, state->available);
     }
-    
-    // First jump to the test
-    write_instruction(context, "jmp %s", test_buffer);
-    
-    // Loop body starts here
-    write_label(context, start_buffer);
-    if (loop_block) {
-        generate_block(context, loop_block);
+
+    if (instr->op == IR_NEG) {
+        write_instruction(state->context, "neg %s", register_names[reg]);
+    } else if (instr->op == IR_SHL || instr->op == IR_SHR || instr->op == IR_SAR) {
+        emit_shift(state, instr->op, reg, b.value);
+    } else {
+        const char *mnemonic = instr->op == IR_ADD ? "add" : instr->op == IR_SUB ? "sub" : "and";
+        write_instruction(state->context, "%s %s, %s", mnemonic,
+                          register_names[reg], operand_text(state, b, buffer, sizeof(buffer)));
     }
-    
-    // Test condition after the loop body
-    write_label(context, test_buffer);
-    if (condition) {
-        // Generate the condition
-        ASTNode *expr = condition->children[0];
-        generate_expression(context, expr);
-        
-        // Test the result in AX
-        write_instruction(context, "test ax, ax");
-        
-        // If true (non-zero), jump to the start of the loop body
-        write_instruction(context, "jnz %s", start_buffer);
+
+    use_operand(state, a);
+    use_operand(state, b);
+    define_register(state, instr->dst, reg);
+    finish_instruction(state);
+}
+
+// imul reg, a, imm (186 and later): the product can go to any register
+static void emit_multiply_immediate(IREmitState *state, IRInstr *instr, IROperand a, int value) {
+    pin_operand(state, a);
+    int reg = variable_result_register(state, instr, a, ir_none());
+    if (reg != REG_NONE) {
+        detach_variable_values(state, reg, instr);
+    } else if (state->uses[a.value] == 1 && state->location[a.value] != REG_NONE &&
+               (state->available & REG_BIT(state->location[a.value]))) {
+        // Last use of a: the product replaces it
+        reg = state->location[a.value];
     } else {
-        // If no condition, make an unconditional jump (infinite loop)
-        write_instruction(context, "jmp %s", start_buffer);
+        reg = allocate_register(state, state->available, REG_NONE);
     }
-    
-    // End of loop
-    write_label(context, end_buffer);
-    
-    write_comment(context, "End of luloop statement");
+
+    char buffer[32];
+    write_instruction(state->context, "imul %s, %s, %d", register_names[reg],
+                      operand_text(state, a, buffer, sizeof(buffer)), value);
+    use_operand(state, a);
+    define_register(state, instr->dst, reg);
+    finish_instruction(state);
 }
 
-// Generate code for a lulog statement
-static void generate_lulog_statement(CodeGenContext *context, ASTNode *lulog) {
-    if (!context || !lulog || lulog->type != NODE_LULOG) return;
-    
-    write_comment(context, "lulog statement");
-    
-    // Check if we have something to log
-    if (lulog->num_children > 0) {
-        ASTNode *expr = lulog->children[0];
-        
-        // Check if we're logging a string literal (we'll ignore these for now since we only handle integers)
-        if (expr->type == NODE_STRING) {
-            write_comment(context, "String output not supported: %s", expr->value);
-            // For now, we'll just print the number 0 as a placeholder for strings
-            write_instruction(context, "mov ax, 0");
-            write_instruction(context, "push ax");
-            write_instruction(context, "call lulog");
-            write_instruction(context, "add sp, 2");  // Clean up stack - add this after every call
+// imul/idiv/div: the left operand and the result live in DX:AX
+static void emit_multiply_divide(IREmitState *state, IRInstr *instr) {
+    IROperand a = instr->a;
+    IROperand b = instr->b;
+    const int others = ALL_REGISTERS & ~(REG_BIT(REG_AX) | REG_BIT(REG_DX));
+
+    if (instr->op == IR_MUL && state->costs->immediate_multiply) {
+        if (a.kind == IR_OPERAND_VREG && b.kind == IR_OPERAND_IMM) {
+            emit_multiply_immediate(state, instr, a, b.value);
             return;
         }
-        
-        // For any expression, generate the expression (result in AX)
-        generate_expression(context, expr);
-        
-        // Print a debug message showing which variable we're logging
-        if (expr->type == NODE_IDENTIFIER) {
-            write_comment(context, "Logging variable '%s'", expr->value);
+        if (a.kind == IR_OPERAND_IMM && b.kind == IR_OPERAND_VREG) {
+            emit_multiply_immediate(state, instr, b, a.value);
+            return;
         }
-        
-        // Make a debug note of the actual value in AX before pushing it
-        write_comment(context, "Value to log is in AX");
-        
-        // Call lulog with the value
-        write_instruction(context, "push ax");  // Push the value to print
-        write_instruction(context, "call lulog");
-        write_instruction(context, "add sp, 2");  // Clean up stack after call
+    }
+
+    // A product can take whichever operand is already in AX as its left one
+    if (instr->op == IR_MUL && b.kind == IR_OPERAND_VREG && state->location[b.value] == REG_AX &&
+        !ir_is_vreg(a, b.value)) {
+        IROperand swap = a;
+        a = b;
+        b = swap;
+    }
+
+    // Only a divisor that has to move stays pinned when evicted
+    pin_operand(state, b);
+
+    // Left operand into AX
+    char buffer[32];
+    bool left_in_place = a.kind == IR_OPERAND_VREG && state->location[a.value] == REG_AX &&
+                         state->uses[a.value] == 1;
+    if (!left_in_place) {
+        evict(state, REG_AX, others);
+        write_instruction(state->context, "mov ax, %s", operand_text(state, a, buffer, sizeof(buffer)));
+        state->holder[REG_AX] = SCRATCH_VALUE;
+        if (a.kind == IR_OPERAND_VREG && state->location[a.value] == REG_DX && state->uses[a.value] == 1) {
+            // Its last copy is in AX now
+            state->holder[REG_DX] = 0;
+            state->location[a.value] = REG_NONE;
+        }
+    }
+
+    // DX is overwritten: its value moves elsewhere
+    evict(state, REG_DX, others);
+    state->pinned |= REG_BIT(REG_AX) | REG_BIT(REG_DX);
+
+    // Right operand in a register other than AX/DX, or in memory
+    const char *divisor;
+    if (b.kind == IR_OPERAND_IMM) {
+        divisor = register_names[immediate_to_register(state, b.value, others, REG_CX)];
     } else {
-        // If there's nothing to log, just log 0
-        write_instruction(context, "mov ax, 0");
-        write_instruction(context, "push ax");
-        write_instruction(context, "call lulog");
-        write_instruction(context, "add sp, 2");  // Clean up stack after call
+        pin_operand(state, b);
+        divisor = operand_text(state, b, buffer, sizeof(buffer));
     }
-}
 
-// Generate code for a luload statement
-static void generate_luload_statement(CodeGenContext *context, ASTNode *luload) {
-    if (!context || !luload || luload->type != NODE_LULOAD) return;
-    
-    write_comment(context, "luload statement");
-    
-    // Call luload function which will read a number and return it in AX
-    write_instruction(context, "call luload");
-    
-    // Result is already in AX, no stack cleanup needed since luload takes no parameters
-}
+    switch (instr->op) {
+        case IR_MUL:
+        case IR_MULHI:
+            // Product in DX:AX; the low word is the 16-bit result
+            write_instruction(state->context, "imul %s", divisor);
+            break;
+        case IR_DIV:
+        case IR_MOD:
+            write_instruction(state->context, "cwd");   // Sign-extend AX into DX:AX
+            write_instruction(state->context, "idiv %s", divisor);
+            break;
+        default:
+            // Both operands are non-negative: zero-extend and divide unsigned
+            write_instruction(state->context, "xor dx, dx");
+            write_instruction(state->context, "div %s", divisor);
+            break;
+    }
 
-// Generate code for luload as an expression
-static void generate_luload_expression(CodeGenContext *context, ASTNode *luload) {
-    if (!context || !luload || luload->type != NODE_LULOAD) return;
-    
-    write_comment(context, "luload expression");
-    
-    // Call luload function which will read a number and return it in AX
-    write_instruction(context, "call luload");
-    
-    // Result is already in AX, no stack cleanup needed since luload takes no parameters
+    use_operand(state, a);
+    use_operand(state, b);
+    if (state->holder[REG_AX] == SCRATCH_VALUE) state->holder[REG_AX] = 0;
+    // Quotient in AX, remainder (or the high word of a product) in DX
+    bool high_word = instr->op == IR_MOD || instr->op == IR_UMOD || instr->op == IR_MULHI;
+    define_register(state, instr->dst, high_word ? REG_DX : REG_AX);
+    finish_instruction(state);
 }
 
-// Generate code for a variable access
-static void generate_identifier(CodeGenContext *context, ASTNode *id) {
-    if (!context || !id || id->type != NODE_IDENTIFIER) return;
-    
-    // Lookup the variable in the symbol table
-    Symbol *symbol = lookup_symbol(context->symbol_table, id->value);
-    if (!symbol) {
-        fprintf(stderr, "Variable '%s' not found in symbol table\n", id->value);
+// Emit a conditional branch, falling through to the next block where possible
+static void emit_branch(IREmitState *state, IRInstr *instr) {
+    int left;
+    IRCondition cond = emit_compare(state, instr, &left);
+    char target_buffer[128], else_buffer[128];
+    const char *target = block_label(state, instr->target, target_buffer, sizeof(target_buffer));
+    const char *else_target = block_label(state, instr->else_target, else_buffer, sizeof(else_buffer));
+
+    if (instr->target == state->next_block) {
+        write_instruction(state->context, "%s %s", jump_mnemonic(ir_negate_condition(cond)), else_target);
         return;
     }
-    
-    // Get a consistent stack offset for this variable using our tracking system
-    int offset = get_variable_offset(context, symbol->name);
-    
-    // Check if this is a parameter (parameters have positive offsets)
-    if (symbol->type == SYMBOL_PARAMETER) {
-        // Add a comment to show which parameter we're accessing
-        write_comment(context, "Load parameter '%s' from offset %d", symbol->name, offset);
-    } else {
-        // Add a comment to show which variable we're accessing
-        write_comment(context, "Load variable '%s' from offset %d", symbol->name, offset);
+    write_instruction(state->context, "%s %s", jump_mnemonic(cond), target);
+    if (instr->else_target != state->next_block) {
+        write_instruction(state->context, "jmp %s", else_target);
     }
-    
-    // Load the variable into AX (offset will be positive for parameters, negative for local variables)
-    write_instruction(context, "mov ax, [bp%+d]", offset);
 }
 
-// Generate code for a binary operation
-static void generate_binary_operation(CodeGenContext *context, ASTNode *binary_op) {
-    if (!context || !binary_op || binary_op->type != NODE_BINARY_OP) return;
-    
-    if (binary_op->num_children < 2) return;
-    
-    // Binary operations:
-    // 1. Calculate the right operand and push it on the stack
-    // 2. Calculate the left operand (result in AX)
-    // 3. Perform the operation using the top of the stack and AX
-    // 4. Result is in AX
-    
-    write_comment(context, "Binary operation: %s", binary_op->value);
-    
-    // For binary operations, operands must be evaluated in correct order
-    
-    // Generate left operand first
-    generate_expression(context, binary_op->children[0]);
-    
-    // Save left operand on stack
-    write_instruction(context, "push ax");
-    
-    // Generate right operand
-    generate_expression(context, binary_op->children[1]);
-    
-    // Now AX has the right operand, and the top of stack has the left operand
-    
-    // Perform the operation based on the operator
-    const char *op = binary_op->value;
-    
-    if (strcmp(op, "+") == 0) {
-        // For addition, order doesn't matter
-        write_instruction(context, "pop bx");     // Get left operand
-        write_instruction(context, "add ax, bx"); // Add left to right
-    }
-    else if (strcmp(op, "-") == 0) {
-        // For subtraction, order matters: left - right
-        // Specifically check for "0 - X" pattern which means negative number
-        if (binary_op->children[0]->type == NODE_NUMBER && 
-            strcmp(binary_op->children[0]->value, "0") == 0) {
-            // Special case for negative numbers: 0 - X becomes -X
-            // This is a more efficient way to negate a number
-            write_instruction(context, "neg ax");      // Negate the value directly
-            write_instruction(context, "pop bx");      // Clean up stack (we pushed the 0)
-        } else {
-            // Normal subtraction
-            write_instruction(context, "mov cx, ax");  // Save right operand
-            write_instruction(context, "pop ax");      // Get left operand
-            write_instruction(context, "sub ax, cx");  // Subtract right from left
+// Numbers per line of a constant text in the data segment
+#define TEXT_VALUES_PER_LINE 8
+
+static bool is_constant_lulog(const IRInstr *instr) {
+    return instr && instr->op == IR_LULOG && instr->a.kind == IR_OPERAND_IMM;
+}
+
+// A lulog of a constant prints text known at compile time: a run of them
+// becomes one '$'-terminated string in the data segment, printed with a
+// single runtime call when the last lulog of the run is reached
+static void emit_constant_lulog(IREmitState *state, IRInstr *instr) {
+    CodeGenContext *context = state->context;
+    char digits[12];
+    format_int(digits, instr->a.value);
+    if (state->text_values == TEXT_VALUES_PER_LINE) {
+        buffer_printf(&state->text, "\n    db ");
+        state->text_values = 0;
+    } else if (state->text.length > 0) {
+        buffer_printf(&state->text, ", ");
+    }
+    buffer_printf(&state->text, "'%s', 0Dh, 0Ah", digits);
+    state->text_values++;
+    if (is_constant_lulog(instr->next)) return;
+
+    char label[128];
+    format_label(context, label, sizeof(label), "text", context->label_counter++);
+    buffer_printf(context->data, "%s db %s, '$'\n", label, state->text.data);
+    state->text.length = 0;
+    state->text_values = 0;
+
+    int pushed = prepare_runtime_call(state, instr, RUNTIME_PRINT_TEXT, ir_none());
+    write_instruction(context, "mov ax, offset %s", label);
+    write_instruction(context, "call print_text");
+    pop_registers(state, pushed);
+    finish_instruction(state);
+}
+
+// Emit one IR instruction
+static void emit_ir_instruction(IREmitState *state, IRInstr *instr) {
+    CodeGenContext *context = state->context;
+    char label[128];
+    char buffer[32];
+
+    switch (instr->op) {
+        case IR_CONST:
+        case IR_MOV:
+            if (is_dead_value(state, instr)) {
+                use_operand(state, instr->a);
+                break;
+            }
+            if (instr->a.kind == IR_OPERAND_VREG && state->uses[instr->a.value] == 1 &&
+                state->location[instr->a.value] != REG_NONE) {
+                // Last use: the value just changes its name
+                int reg = state->location[instr->a.value];
+                use_operand(state, instr->a);
+                define_register(state, instr->dst, reg);
+            } else {
+                int reg = allocate_register(state, ALL_REGISTERS, REG_NONE);
+                write_instruction(context, "mov %s, %s", register_names[reg], operand_text(state, instr->a, buffer, sizeof(buffer)));
+                use_operand(state, instr->a);
+                define_register(state, instr->dst, reg);
+            }
+            finish_instruction(state);
+            break;
+
+        case IR_LOAD:
+            if (!is_dead_value(state, instr)) {
+                int reg = variable_register(state, instr->a);
+                if (reg == REG_NONE) {
+                    reg = allocate_register(state, ALL_REGISTERS, REG_NONE);
+                    write_instruction(context, "mov %s, [bp%+d]", register_names[reg], state->ir->slots[instr->a.value].offset);
+                }
+                define_register(state, instr->dst, reg);
+            }
+            break;
+
+        case IR_STORE: {
+            int offset = state->ir->slots[instr->dst.value].offset;
+            int variable = variable_register(state, instr->dst);
+            if (variable != REG_NONE) {
+                detach_variable_values(state, variable, instr);
+                if (!(instr->a.kind == IR_OPERAND_VREG && state->location[instr->a.value] == variable)) {
+                    write_instruction(context, "mov %s, %s", register_names[variable],
+                                      operand_text(state, instr->a, buffer, sizeof(buffer)));
+                }
+            } else if (instr->a.kind == IR_OPERAND_IMM) {
+                write_instruction(context, "mov word ptr [bp%+d], %d", offset, instr->a.value);
+            } else {
+                int reg = vreg_to_register(state, instr->a.value, ALL_REGISTERS);
+                write_instruction(context, "mov [bp%+d], %s", offset, register_names[reg]);
+            }
+            use_operand(state, instr->a);
+            finish_instruction(state);
+            break;
+        }
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_AND:
+        case IR_SHL:
+        case IR_SHR:
+        case IR_SAR:
+        case IR_NEG:
+            emit_two_address(state, instr);
+            break;
+
+        case IR_MUL:
+        case IR_MULHI:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_UDIV:
+        case IR_UMOD:
+            emit_multiply_divide(state, instr);
+            break;
+
+        case IR_SET: {
+            int left;
+            IRCondition cond = emit_compare(state, instr, &left);
+            // mov leaves the flags alone, so the result can be built after the compare
+            int reg = allocate_register(state, ALL_REGISTERS, left);
+            format_label(context, label, sizeof(label), "skip", context->label_counter++);
+            write_instruction(context, "mov %s, 0", register_names[reg]);
+            write_instruction(context, "%s %s", jump_mnemonic(ir_negate_condition(cond)), label);
+            write_instruction(context, "mov %s, 1", register_names[reg]);
+            write_label(context, "%s", label);
+            define_register(state, instr->dst, reg);
+            break;
+        }
+
+        case IR_LULOG: {
+            if (context->optimization_level >= 1 && context->data && is_constant_lulog(instr)) {
+                emit_constant_lulog(state, instr);
+                break;
+            }
+            // Values proven non-negative skip the sign handling
+            bool non_negative = (instr->flags & IR_FLAG_NON_NEGATIVE) != 0;
+            int pushed = prepare_runtime_call(state, instr, non_negative ? RUNTIME_LULOG_UNSIGNED : RUNTIME_LULOG, instr->a);
+            if (instr->a.kind == IR_OPERAND_IMM) {
+                write_instruction(context, "mov ax, %d", instr->a.value);
+            }
+            write_instruction(context, non_negative ? "call lulog_unsigned" : "call lulog");
+            pop_registers(state, pushed);
+            finish_instruction(state);
+            break;
+        }
+
+        case IR_LULOAD: {
+            int pushed = prepare_runtime_call(state, instr, RUNTIME_LULOAD, ir_none());
+            write_instruction(context, "call luload");
+            pop_registers(state, pushed);
+            finish_instruction(state);
+            define_register(state, instr->dst, REG_AX);
+            break;
         }
+
+        case IR_CALL: {
+            // Live variables in BX and CX are pushed first: the stack
+            // arguments have to end up right above the return address
+            int pushed = push_live_variables(state, CALLER_SAVED, instr);
+            for (int i = instr->arg_count - 1; i >= IR_REGISTER_ARGUMENTS; i--) {
+                push_operand(state, instr->args[i]);
+            }
+            load_register_arguments(state, instr);
+            write_instruction(context, "call %s", instr->callee);
+            if (instr->arg_count > IR_REGISTER_ARGUMENTS) {
+                write_instruction(context, "add sp, %d", (instr->arg_count - IR_REGISTER_ARGUMENTS) * 2);
+            }
+            pop_registers(state, pushed);
+            finish_instruction(state);
+            define_register(state, instr->dst, REG_AX);
+            break;
+        }
+
+        case IR_TAIL_CALL:
+            // Nothing is live any more: the arguments are loaded, and the
+            // frame release and the jump follow this segment of the body
+            load_register_arguments(state, instr);
+            finish_instruction(state);
+            state->tail_callees[state->segment] = instr->callee;
+            context->emitter = &state->segments[++state->segment];
+            break;
+
+        case IR_ARG:
+            // The arguments are taken before anything else runs, so the
+            // registers still hold them
+            define_register(state, instr->dst, argument_registers[instr->a.value]);
+            break;
+
+        case IR_JUMP:
+            if (instr->target != state->next_block) {
+                write_instruction(context, "jmp %s", block_label(state, instr->target, label, sizeof(label)));
+            }
+            break;
+
+        case IR_BRANCH:
+            emit_branch(state, instr);
+            break;
+
+        case IR_LOOP:
+            emit_loop(state, instr);
+            break;
+
+        case IR_RET:
+            if (instr->a.kind != IR_OPERAND_NONE &&
+                !(instr->a.kind == IR_OPERAND_VREG && state->location[instr->a.value] == REG_AX)) {
+                write_instruction(context, "mov ax, %s", operand_text(state, instr->a, buffer, sizeof(buffer)));
+            }
+            use_operand(state, instr->a);
+            // The epilogue follows the last block
+            if (state->next_block) {
+                write_instruction(context, "jmp end_%s", state->ir->name);
+            }
+            break;
     }
-    else if (strcmp(op, "*") == 0) {
-        // For multiplication, order doesn't matter
-        write_instruction(context, "pop bx");     // Get left operand
-        write_instruction(context, "imul bx");    // Multiply AX by BX, result in DX:AX
-    }
-    else if (strcmp(op, "/") == 0) {
-        // For division, order matters: left / right
-        write_comment(context, "Division operation: left / right");
-        write_instruction(context, "mov cx, ax"); // Save right operand (divisor)
-        write_instruction(context, "pop ax");     // Get left operand (dividend)
-        write_instruction(context, "cwd");        // Convert word to doubleword (sign-extend AX into DX:AX)
-        write_instruction(context, "idiv cx");    // Signed divide DX:AX by CX, quotient in AX, remainder in DX
-    }
-    else if (strcmp(op, "%") == 0) {
-        // For modulo, order matters: left % right
-        write_comment(context, "Modulo operation: left % right");
-        write_instruction(context, "mov cx, ax"); // Save right operand (divisor)
-        write_instruction(context, "pop ax");     // Get left operand (dividend)
-        write_instruction(context, "cwd");        // Convert word to doubleword (sign-extend AX into DX:AX)
-        write_instruction(context, "idiv cx");    // Signed divide DX:AX by CX, quotient in AX, remainder in DX
-        write_instruction(context, "mov ax, dx"); // For modulo, we want the remainder which is in DX
-    }
-    else if (strcmp(op, "<") == 0) {
-        // For comparison, order matters: left < right
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        write_instruction(context, "cmp ax, cx"); // Compare left with right (ax < cx?)
-        write_instruction(context, "mov ax, 0");  // Assume false (0)
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        write_instruction(context, "jge %s", format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        write_instruction(context, "mov ax, 1");  // Set true (1) if ax < cx
-        write_label(context, "skip_%d", label_num);
-    }
-    else if (strcmp(op, ">") == 0) {
-        // For comparison, order matters: left > right
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        
-        // Add additional debug info
-        write_comment(context, "DEBUG - Condition: Is value in AX > value in CX?");
-        
-        // Fix for if(a > 5) condition when a equals 5 - adding more explicit comments
-        write_comment(context, "ENHANCED COMPARISON - Explicitly checking if AX > CX");
-        
-        // Fixed comparison logic with clearer code and comments
-        write_instruction(context, "cmp ax, cx"); // Compare left with right
-        write_instruction(context, "mov ax, 0");  // Assume comparison result is false
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        
-        // Output detailed debug info about the comparison operation
-        write_comment(context, "If %s(%s) > %s(%s) then set result to 1, otherwise leave as 0", 
-                     binary_op->children[0]->type == NODE_IDENTIFIER ? "variable" : "value",
-                     binary_op->children[0]->type == NODE_IDENTIFIER ? binary_op->children[0]->value : "expr",
-                     binary_op->children[1]->type == NODE_NUMBER ? "constant" : "value",
-                     binary_op->children[1]->type == NODE_NUMBER ? binary_op->children[1]->value : "expr");
-        
-        // Make sure we use jle (Jump if Less than or Equal) for correct evaluation
-        // This ensures a > 5 is only true when a is 6 or greater
-        write_instruction(context, "jle %s ; Jump if AX <= CX (condition is false)", 
-                         format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        
-        // Set result to true only if greater than
-        write_instruction(context, "mov ax, 1 ; Set true (1) because AX > CX");
-        write_label(context, "skip_%d", label_num);
-    }
-    else if (strcmp(op, "==") == 0) {
-        // For equality, order doesn't matter
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        write_instruction(context, "cmp ax, cx"); // Compare left with right
-        write_instruction(context, "mov ax, 0");  // Assume false
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        write_instruction(context, "jne %s", format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        write_instruction(context, "mov ax, 1");  // Set true
-        write_label(context, "skip_%d", label_num);
-    }
-    else if (strcmp(op, "!=") == 0) {
-        // For inequality, order doesn't matter
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        write_instruction(context, "cmp ax, cx"); // Compare left with right
-        write_instruction(context, "mov ax, 0");  // Assume false
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        write_instruction(context, "je %s", format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        write_instruction(context, "mov ax, 1");  // Set true
-        write_label(context, "skip_%d", label_num);
-    }
-    else if (strcmp(op, "<=") == 0) {
-        // For less than or equal, order matters: left <= right
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        write_instruction(context, "cmp ax, cx"); // Compare left with right
-        write_instruction(context, "mov ax, 0");  // Assume false
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        write_instruction(context, "jg %s", format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        write_instruction(context, "mov ax, 1");  // Set true if left <= right
-        write_label(context, "skip_%d", label_num);
-    }
-    else if (strcmp(op, ">=") == 0) {
-        // For greater than or equal, order matters: left >= right
-        write_instruction(context, "mov cx, ax"); // Save right operand
-        write_instruction(context, "pop ax");     // Get left operand
-        write_instruction(context, "cmp ax, cx"); // Compare left with right
-        write_instruction(context, "mov ax, 0");  // Assume false
-        int label_num = context->label_counter++;
-        char label_buffer[64];
-        write_instruction(context, "jl %s", format_label(label_buffer, sizeof(label_buffer), "skip_%d", label_num));
-        write_instruction(context, "mov ax, 1");  // Set true if left >= right
-        write_label(context, "skip_%d", label_num);
-    }
-    else {
-        fprintf(stderr, "Unsupported binary operator: %s\n", op);
+}
+
+// Lay out the frame for the locals without a register
+static bool layout_function_frame(IREmitState *state) {
+    IRFunction *ir = state->ir;
+    bool *in_memory = (bool *)calloc(ir->slot_count + 1, sizeof(bool));
+    if (!in_memory) return false;
+
+    for (int slot = 0; slot < ir->slot_count; slot++) {
+        in_memory[slot] = state->slot_register[slot] == REG_NONE;
+    }
+
+    layout_frame(ir, in_memory);
+    free(in_memory);
+    return true;
+}
+
+// A function only sets up bp when something is addressed through it:
+// locals and spills in memory, or parameters passed on the stack. Keeping
+// bp beats addressing the frame from sp, which takes a base register and
+// moves with every push.
+static bool needs_frame(const IREmitState *state) {
+    const IRFunction *ir = state->ir;
+    if (state->context->optimization_level < 1 || ir->frame_size + state->spill_bytes > 0) return true;
+    for (int slot = 0; slot < ir->slot_count; slot++) {
+        if (ir->slots[slot].parameter) return true;
     }
+    return false;
 }
 
-// Generate code for a condition
-static void generate_condition(CodeGenContext *context, ASTNode *cond, 
-                             const char *true_label, const char *false_label) {
-    if (!context || !cond || cond->type != NODE_CONDITION) return;
-    
-    if (cond->num_children == 0) return;
-    
-    // Add enhanced debug info
-    write_comment(context, "CONDITION CHECK - Generating condition code with direct jumps");
-    
-    // Get the condition expression
-    ASTNode *expr = cond->children[0];
-    
-    // Special optimized handling for binary operations in if conditions
-    if (expr->type == NODE_BINARY_OP && expr->num_children >= 2) {
-        const char *op = expr->value;
-        
-        // Special handling for comparison operators using direct jumps
-        if (strcmp(op, ">") == 0) {
-            write_comment(context, "ENHANCED: Special handling for '>' comparison with explicit jumps");
-            
-            // Extract values for better debug messages
-            const char* left_var = "unknown";
-            const char* right_val = "unknown";
-            
-            if (expr->children[0]->type == NODE_IDENTIFIER) {
-                left_var = expr->children[0]->value;
-            }
-            
-            if (expr->children[1]->type == NODE_NUMBER) {
-                right_val = expr->children[1]->value;
+// Undo the prologue: restore the callee-saved registers, then release the
+// frame (mov sp, bp drops the locals)
+static void release_frame(IREmitState *state, int saved, bool frame) {
+    pop_registers(state, saved);
+    if (frame) {
+        write_instruction(state->context, "mov sp, bp");
+        write_instruction(state->context, "pop bp");
+    }
+}
+
+// Emit the assembly for an IR function
+static void emit_ir_function(CodeGenContext *context, IRFunction *ir) {
+    IREmitState state;
+    memset(&state, 0, sizeof(state));
+    state.context = context;
+    state.ir = ir;
+    state.costs = target_costs(context->target);
+    state.uses = (int *)calloc(ir->vreg_count + 1, sizeof(int));
+    state.location = (int *)malloc(sizeof(int) * (ir->vreg_count + 1));
+    state.spill_offset = (int *)calloc(ir->vreg_count + 1, sizeof(int));
+    state.free_spills = (int *)calloc(ir->vreg_count + 1, sizeof(int));
+    init_string_buffer(&state.text);
+    state.slot_register = (int *)malloc(sizeof(int) * (ir->slot_count + 1));
+    int tail_calls = 0;
+    for (IRBlock *block = ir->first_block; block; block = block->next) {
+        IRInstr *terminator = ir_terminator(block);
+        if (terminator && terminator->op == IR_TAIL_CALL) tail_calls++;
+    }
+    state.segments = (Emitter *)malloc(sizeof(Emitter) * (tail_calls + 1));
+    state.tail_callees = (const char **)malloc(sizeof(const char *) * (tail_calls + 1));
+    // Variables only get registers when optimizing
+    int variable_count = context->optimization_level >= 1 ? VARIABLE_REGISTER_COUNT : 0;
+    if (!state.uses || !state.location || !state.spill_offset || !state.free_spills || !state.slot_register ||
+        !state.segments || !state.tail_callees || !allocate_slot_registers(ir, variable_count, &state.slots)) {
+        fprintf(stderr, "Failed to allocate memory for function '%s'\n", ir->name);
+        free(state.uses);
+        free(state.location);
+        free(state.spill_offset);
+        free(state.free_spills);
+        free(state.slot_register);
+        free(state.segments);
+        free(state.tail_callees);
+        return;
+    }
+    for (int i = 0; i <= ir->vreg_count; i++) {
+        state.location[i] = REG_NONE;
+    }
+
+    // Registers holding variables are taken away from the expressions (the
+    // counter register only while a counter is live, see update_counter_register)
+    state.available = ALL_REGISTERS;
+    for (int slot = 0; slot < ir->slot_count; slot++) {
+        int index = state.slots.assignment[slot];
+        state.slot_register[slot] = index >= 0 ? (int)variable_registers[index] : REG_NONE;
+        if (index >= 0) state.written |= REG_BIT(variable_registers[index]);
+        if (index >= 0 && index < VARIABLE_REGISTER_COUNT) state.available &= ~REG_BIT(variable_registers[index]);
+    }
+
+    // Locals need a word of the frame unless a register holds them; calls
+    // push the registers they would change
+    if (!layout_function_frame(&state)) {
+        fprintf(stderr, "Failed to allocate memory for function '%s'\n", ir->name);
+    }
+
+    // Values nobody reads (e.g. the result of a bare luload) are dropped
+    for (IRBlock *block = ir->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            IROperand operands[2] = { instr->a, instr->b };
+            for (int i = 0; i < 2; i++) {
+                if (operands[i].kind == IR_OPERAND_VREG) state.uses[operands[i].value]++;
             }
-            
-            write_comment(context, "Condition details: (%s > %s)", left_var, right_val);
-            
-            // Generate left operand
-            generate_expression(context, expr->children[0]);
-            write_instruction(context, "push ax ; Save left operand");
-            
-            // Generate right operand
-            generate_expression(context, expr->children[1]);
-            write_instruction(context, "mov cx, ax ; Right operand to CX");
-            write_instruction(context, "pop ax ; Left operand to AX");
-            
-            // Comparison with additional debug info
-            write_instruction(context, "cmp ax, cx ; Compare left > right");
-            write_comment(context, "If AX (value: %s) > CX (value: %s) then condition is TRUE", left_var, right_val);
-            
-            // Direct jumps based on flags from comparison - more efficient
-            if (true_label) {
-                write_comment(context, "Jump to %s if left > right (condition is TRUE)", true_label);
-                write_instruction(context, "jg %s ; Jump directly if greater than (TRUE path)", true_label);
-            } 
-            else if (false_label) {
-                write_comment(context, "Jump to %s if left <= right (condition is FALSE)", false_label);
-                write_instruction(context, "jle %s ; Jump if less than or equal (FALSE path)", false_label);
-                write_comment(context, "This includes the case where %s equals %s", left_var, right_val);
+            for (int i = 0; i < instr->arg_count; i++) {
+                if (instr->args[i].kind == IR_OPERAND_VREG) state.uses[instr->args[i].value]++;
             }
-            
-            return;  // Direct jumps performed, nothing more to do
         }
-        else if (strcmp(op, "<") == 0) {
-            write_comment(context, "Special handling for '<' comparison - direct jump optimization");
-            
-            // Generate left operand
-            generate_expression(context, expr->children[0]);
-            write_instruction(context, "push ax ; Save left operand");
-            
-            // Generate right operand
-            generate_expression(context, expr->children[1]);
-            write_instruction(context, "mov cx, ax ; Right operand to CX");
-            write_instruction(context, "pop ax ; Left operand to AX");
-            
-            // Comparison
-            write_instruction(context, "cmp ax, cx ; Compare left < right");
-            
-            // Direct jumps based on flags from comparison
-            if (true_label) {
-                write_comment(context, "Jump to %s if left < right (condition true)", true_label);
-                write_instruction(context, "jl %s ; Jump directly if less than", true_label);
-            } 
-            else if (false_label) {
-                write_comment(context, "Jump to %s if left >= right (condition false)", false_label);
-                write_instruction(context, "jge %s ; Jump directly if greater than or equal", false_label);
+    }
+
+    // The body goes to its own buffers first: the frame size depends on the
+    // spills, and each tail call is followed by the epilogue's register pops
+    for (int i = 0; i <= tail_calls; i++) {
+        init_emitter(&state.segments[i], -1);
+    }
+    Emitter *output = context->emitter;
+    context->emitter = &state.segments[0];
+
+    // Parameters kept in registers are loaded once, if the value passed is
+    // read at all: a live range that starts later belongs to a value stored
+    // in the function, and may share its register with another parameter
+    for (int slot = 0; slot < ir->slot_count; slot++) {
+        if (ir->slots[slot].parameter && state.slot_register[slot] != REG_NONE && state.slots.start[slot] == 0) {
+            write_instruction(context, "mov %s, [bp%+d]", register_names[state.slot_register[slot]], ir->slots[slot].offset);
+        }
+    }
+
+    char label[128];
+    for (IRBlock *block = ir->first_block; block; block = block->next) {
+        if (block != ir->first_block) {
+            write_label(context, "%s", block_label(&state, block, label, sizeof(label)));
+        }
+
+        state.block = block;
+        state.next_block = block->next;
+        for (IRInstr *instr = block->first; instr; instr = instr->next, state.position++) {
+            update_counter_register(&state);
+            emit_ir_instruction(&state, instr);
+        }
+
+        for (int reg = 0; reg < REG_COUNT; reg++) {
+            if (state.holder[reg] != 0) {
+                internal_error(&state, "value live across blocks");
+                state.holder[reg] = 0;
             }
-            
-            return;  // Direct jumps performed, nothing more to do
         }
     }
-    
-    // Default handling for other expressions
-    generate_expression(context, expr);
-    
-    // Debug the condition value
-    write_comment(context, "Condition evaluated - result value in AX register");
-    
-    // Test the result
-    write_instruction(context, "test ax, ax");
-    
-    // Jump based on the result
-    if (true_label) {
-        write_instruction(context, "jnz %s ; Jump if non-zero (true)", true_label);
+
+    context->emitter = output;
+
+    // Add function label
+    write_comment(context, "Function: %s", ir->name);
+    write_label(context, "%s", ir->name);
+
+    // Function prologue
+    bool frame = needs_frame(&state);
+    if (frame) {
+        write_instruction(context, "push bp");
+        write_instruction(context, "mov bp, sp");
+    }
+    if (ir->frame_size + state.spill_bytes > 0) {
+        write_comment(context, "Reserve space for local variables (%d bytes)", ir->frame_size + state.spill_bytes);
+        write_instruction(context, "sub sp, %d", ir->frame_size + state.spill_bytes);
+    }
+    // main returns to main_init, which keeps nothing in registers
+    int saved = strcmp(ir->name, "main") != 0 ? state.written & CALLEE_SAVED : 0;
+    for (int reg = 0; reg < REG_COUNT; reg++) {
+        if (saved & REG_BIT(reg)) write_instruction(context, "push %s", register_names[reg]);
+    }
+    for (int slot = 0; slot < ir->slot_count; slot++) {
+        if (state.slot_register[slot] != REG_NONE) {
+            write_comment(context, "Variable %s in %s", ir->slots[slot].name, register_names[state.slot_register[slot]]);
+        }
     }
-    else if (false_label) {
-        // Debug message to clarify jump logic
-        write_comment(context, "Jump to %s if condition is false (AX=0)", false_label);
-        write_instruction(context, "jz %s ; Jump if zero (false)", false_label);
+
+    for (int i = 0; i <= tail_calls; i++) {
+        emit_emitters(context->emitter, &state.segments[i], 1);
+        free_emitter(&state.segments[i]);
+        if (i < tail_calls) {
+            // A tail call leaves like the epilogue, but jumps to the callee
+            release_frame(&state, saved, frame);
+            write_instruction(context, "jmp %s", state.tail_callees[i]);
+        }
     }
+
+    // Function epilogue
+    write_label(context, "end_%s", ir->name);
+    release_frame(&state, saved, frame);
+    write_instruction(context, "ret");               // Return to caller (main_init for main)
+
+    free(state.uses);
+    free(state.location);
+    free(state.spill_offset);
+    free(state.free_spills);
+    free(state.slot_register);
+    free(state.segments);
+    free(state.tail_callees);
+    free_slot_allocation(&state.slots);
+    free_string_buffer(&state.text);
 }
 
-// Generate code for a function call
-static void generate_function_call(CodeGenContext *context, ASTNode *call) {
-    if (!context || !call) return;
-    
-    const char *func_name = call->value;
-    write_comment(context, "Function call: %s", func_name);
-    
-    // Push arguments in reverse order
-    int args_size = 0;
-    for (int i = call->num_children - 1; i >= 0; i--) {
-        // Generate the argument expression (result in AX)
-        generate_expression(context, call->children[i]);
-        
-        // Push the argument
-        write_instruction(context, "push ax");
-        args_size += 2; // Each argument takes 2 bytes (16-bit)
+// Generate code for a lowered function: optimize the IR, then emit it
+// (frees `ir`)
+static void generate_function(CodeGenContext *context, IRFunction *ir) {
+    // Label numbering restarts for the new function
+    context->label_counter = 0;
+    strncpy(context->function_name, ir->name, sizeof(context->function_name) - 1);
+    context->function_name[sizeof(context->function_name) - 1] = '\0';
+    context->current_function = context->function_name;
+
+    if (context->optimization_level >= 1) {
+        eliminate_tail_calls(ir);
+        eliminate_dead_code(ir);
+        hoist_loop_invariants(ir);
+        optimize_induction_variables(ir);
+        reduce_strength(ir, target_costs(context->target));
     }
-    
-    // Call the function
-    write_instruction(context, "call %s", func_name);
-    
-    // Clean up stack after call - caller's responsibility
-    if (args_size > 0) {
-        write_instruction(context, "add sp, %d", args_size);
+
+    emit_ir_function(context, ir);
+
+    // Dumped last, with the frame offsets the emitted code uses
+    if (context->ir_dump) {
+        dump_ir_function(ir, context->ir_dump);
     }
-    
-    // Result is in AX by convention
-}
\ No newline at end of file
+    free_ir_function(ir);
+
+    // The emitter holds just this function's text at this point
+    if (context->optimization_level >= 1) {
+        peephole_optimize(&context->emitter->buffer);
+    }
+}
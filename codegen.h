@@ -4,22 +4,44 @@
 #include "parser.h"
 #include "symbol_table.h"
 #include "semantic.h"
+#include "emitter.h"
+#include "thread_pool.h"
+#include "target.h"
+
+// Registers available for expression values
+typedef enum {
+    REG_AX,
+    REG_BX,
+    REG_CX,
+    REG_DX,
+    REG_SI,
+    REG_DI,
+    REG_COUNT,
+    REG_NONE = -1
+} Register;
+
+#define REG_BIT(reg) (1 << (reg))
+#define ALL_REGISTERS ((1 << REG_COUNT) - 1)
 
 // Code generation context
 typedef struct {
-    FILE *output_file;           // Output assembly file
-    SymbolTable *symbol_table;   // Symbol table
-    int label_counter;           // For generating unique labels
+    FILE *output_file;           // Output assembly file (only written through the emitter)
+    Emitter *emitter;            // Buffered output (a per-function buffer while generating functions)
+    SymbolTable *symbol_table;   // Symbol table (read-only during code generation)
+    ThreadPool *pool;            // Workers for per-function code generation (NULL generates serially)
+    int label_counter;           // For generating unique labels (restarts in every function)
     int indent_level;            // For formatting the output
-    const char *current_function; // Current function being processed (uses static buffer)
+    const char *current_function; // Current function being processed (points to function_name)
+    char function_name[64];      // Name of the current function
     const char *input_filename;   // Source file name
-    
-    // Track variable offsets for the current function
-    struct VarOffset {
-        char name[64];           // Variable name
-        int offset;              // Stack offset (from bp)
-    } var_offsets[100];
-    int var_count;               // Number of variables tracked in this function
+    int optimization_level;      // 0: none, 1: the passes listed at generate_program, 2: reserved (same as 1)
+    TargetCPU target;            // Processor the code is generated for (--march)
+    int inline_limit;            // Instructions inlining may add to a function beyond the calls it always inlines (-finline-limit)
+    bool dump_ir;                // Print the IR of every function to stdout (--dump-ir)
+    bool buffered_output;        // lulog output is collected and written in blocks (off: --unbuffered-output)
+    unsigned runtime_used;       // Runtime fragments the generated code calls (RUNTIME_BIT, see runtime.h)
+    StringBuffer *ir_dump;       // Where the current function's IR dump goes (NULL for none)
+    StringBuffer *data;          // Data segment lines of the current function (its constant text)
 } CodeGenContext;
 
 // Initialize code generator
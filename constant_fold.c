@@ -0,0 +1,303 @@
+#include "constant_fold.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Longest +/- or * chain that is reassociated
+#define MAX_CHAIN_TERMS 64
+
+// One operand of a reassociated chain
+typedef struct {
+    ASTNode **slot;              // Where the operand hangs in the tree
+    bool negative;               // Subtracted (sums only)
+} ChainTerm;
+
+// Operands of a chain of + and - (or of *) below one node
+typedef struct {
+    ChainTerm terms[MAX_CHAIN_TERMS];
+    int count;                   // Non-constant operands
+    int constant_count;          // Constant operands
+    int constant;                // Sum (or product) of the constants, wrapped to 16 bits
+    bool cancelled;              // x - x removed from a sum
+    bool too_long;
+} Chain;
+
+// Wrap to the 16-bit signed range of the target
+static int wrap16(long value) {
+    return (short)(unsigned short)(value & 0xFFFF);
+}
+
+static bool is_operator(const ASTNode *node, const char *op) {
+    return node->type == NODE_BINARY_OP && node->num_children == 2 && strcmp(node->value, op) == 0;
+}
+
+// Literals are stored in 16 bits, so large ones wrap around
+static int number_value(const ASTNode *node) {
+    return wrap16(atol(node->value));
+}
+
+// Can the expression be left out without changing what the program does?
+// It must not read input or call a function, and every division in it must
+// have a non-zero constant divisor.
+static bool is_removable(const ASTNode *expr) {
+    if (expr->type == NODE_LULOAD) return false;
+    if (expr->type == NODE_EXPR && strcmp(expr->value, "=") != 0) return false;
+    if ((is_operator(expr, "/") || is_operator(expr, "%")) &&
+        !(expr->children[1]->type == NODE_NUMBER && number_value(expr->children[1]) != 0)) {
+        return false;
+    }
+    for (int i = 0; i < expr->num_children; i++) {
+        if (!is_removable(expr->children[i])) return false;
+    }
+    return true;
+}
+
+// Evaluate "a op b" on constants. Returns false when the operation must be
+// left to run time: division by zero and the overflowing -32768 / -1.
+static bool evaluate(const char *op, int a, int b, int *result) {
+    if (strcmp(op, "+") == 0) *result = wrap16((long)a + b);
+    else if (strcmp(op, "-") == 0) *result = wrap16((long)a - b);
+    else if (strcmp(op, "*") == 0) *result = wrap16((long)a * b);
+    else if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+        if (b == 0 || (a == -32768 && b == -1)) return false;
+        *result = strcmp(op, "/") == 0 ? a / b : a % b;
+    }
+    else if (strcmp(op, "<") == 0) *result = a < b;
+    else if (strcmp(op, ">") == 0) *result = a > b;
+    else if (strcmp(op, "<=") == 0) *result = a <= b;
+    else if (strcmp(op, ">=") == 0) *result = a >= b;
+    else if (strcmp(op, "==") == 0) *result = a == b;
+    else if (strcmp(op, "!=") == 0) *result = a != b;
+    else if (strcmp(op, "and") == 0) *result = a != 0 && b != 0;
+    else if (strcmp(op, "or") == 0) *result = a != 0 || b != 0;
+    else return false;
+    return true;
+}
+
+// Tree surgery
+
+static ASTNode* number_node(int value) {
+    char text[16];
+    snprintf(text, sizeof(text), "%d", value);
+    return create_node(NODE_NUMBER, text);
+}
+
+static ASTNode* binary_node(const char *op, ASTNode *left, ASTNode *right) {
+    ASTNode *node = create_node(NODE_BINARY_OP, op);
+    add_child(node, left);
+    add_child(node, right);
+    return node;
+}
+
+// Put `replacement` in the place of `node`. The children still attached to
+// `node` are freed; take the ones to keep out of it first.
+static void replace_node(ASTNode *node, ASTNode *replacement) {
+    if (!replacement) return;
+
+    for (int i = 0; i < node->num_children; i++) {
+        free_node(node->children[i]);
+    }
+    free(node->value);
+    free(node->children);
+
+    ASTNode *parent = node->parent;
+    *node = *replacement;
+    node->parent = parent;
+    for (int i = 0; i < node->num_children; i++) {
+        node->children[i]->parent = node;
+    }
+    free(replacement);
+}
+
+// Take a child out of its node
+static ASTNode* detach(ASTNode *node, int index) {
+    ASTNode *child = node->children[index];
+    node->children[index] = NULL;
+    return child;
+}
+
+static void replace_with_child(ASTNode *node, int index) {
+    replace_node(node, detach(node, index));
+}
+
+static void replace_with_number(ASTNode *node, int value) {
+    replace_node(node, number_node(value));
+}
+
+// Chains
+
+// Collect the operands of a sum: a - (b - c) is a - b + c
+static void collect_sum(Chain *chain, ASTNode **slot, bool negative) {
+    ASTNode *node = *slot;
+    if (is_operator(node, "+") || is_operator(node, "-")) {
+        collect_sum(chain, &node->children[0], negative);
+        collect_sum(chain, &node->children[1], is_operator(node, "-") ? !negative : negative);
+    } else if (node->type == NODE_NUMBER) {
+        int value = number_value(node);
+        chain->constant = wrap16(negative ? (long)chain->constant - value : (long)chain->constant + value);
+        chain->constant_count++;
+    } else if (chain->count == MAX_CHAIN_TERMS) {
+        chain->too_long = true;
+    } else {
+        chain->terms[chain->count].slot = slot;
+        chain->terms[chain->count].negative = negative;
+        chain->count++;
+    }
+}
+
+// Collect the operands of a product
+static void collect_product(Chain *chain, ASTNode **slot) {
+    ASTNode *node = *slot;
+    if (is_operator(node, "*")) {
+        collect_product(chain, &node->children[0]);
+        collect_product(chain, &node->children[1]);
+    } else if (node->type == NODE_NUMBER) {
+        chain->constant = wrap16((long)chain->constant * number_value(node));
+        chain->constant_count++;
+    } else if (chain->count == MAX_CHAIN_TERMS) {
+        chain->too_long = true;
+    } else {
+        chain->terms[chain->count].slot = slot;
+        chain->count++;
+    }
+}
+
+// Drop pairs x - x of the same variable from a sum
+static void cancel_terms(Chain *chain) {
+    for (int i = 0; i < chain->count; i++) {
+        ASTNode *term = *chain->terms[i].slot;
+        if (term->type != NODE_IDENTIFIER) continue;
+
+        for (int j = i + 1; j < chain->count; j++) {
+            ASTNode *other = *chain->terms[j].slot;
+            if (other->type == NODE_IDENTIFIER && chain->terms[i].negative != chain->terms[j].negative &&
+                strcmp(term->value, other->value) == 0) {
+                memmove(&chain->terms[j], &chain->terms[j + 1], sizeof(ChainTerm) * (chain->count - j - 1));
+                memmove(&chain->terms[i], &chain->terms[i + 1], sizeof(ChainTerm) * (chain->count - i - 1));
+                chain->count -= 2;
+                chain->cancelled = true;
+                i--;
+                break;
+            }
+        }
+    }
+}
+
+// Rebuild a sum as ((t1 +/- t2) +/- t3) + constant, keeping the operands in
+// source order so input is still read in the same order
+static ASTNode* build_sum(Chain *chain) {
+    ASTNode *sum = NULL;
+    for (int i = 0; i < chain->count; i++) {
+        ASTNode *term = *chain->terms[i].slot;
+        *chain->terms[i].slot = NULL;
+        if (!sum) {
+            // A leading subtraction becomes 0 - x, which is lowered to neg
+            sum = chain->terms[i].negative ? binary_node("-", number_node(0), term) : term;
+        } else {
+            sum = binary_node(chain->terms[i].negative ? "-" : "+", sum, term);
+        }
+    }
+
+    if (!sum) return number_node(chain->constant);
+    if (chain->constant > 0) return binary_node("+", sum, number_node(chain->constant));
+    if (chain->constant < 0 && chain->constant != -32768) {
+        return binary_node("-", sum, number_node(-chain->constant));
+    }
+    if (chain->constant < 0) return binary_node("+", sum, number_node(chain->constant));
+    return sum;
+}
+
+static ASTNode* build_product(Chain *chain) {
+    ASTNode *product = NULL;
+    for (int i = 0; i < chain->count; i++) {
+        ASTNode *term = *chain->terms[i].slot;
+        *chain->terms[i].slot = NULL;
+        product = product ? binary_node("*", product, term) : term;
+    }
+
+    if (!product) return number_node(chain->constant);
+    if (chain->constant == -1) return binary_node("-", number_node(0), product);
+    if (chain->constant != 1) return binary_node("*", product, number_node(chain->constant));
+    return product;
+}
+
+static void fold_sum(ASTNode *node) {
+    Chain chain;
+    memset(&chain, 0, sizeof(chain));
+    collect_sum(&chain, &node, false);
+    if (chain.too_long) return;
+    cancel_terms(&chain);
+
+    // Only rewrite when something combines, disappears or moves to the
+    // right, where it can be an immediate; 0 - x stays as it is
+    bool negation = is_operator(node, "-") && node->children[0]->type == NODE_NUMBER &&
+                    number_value(node->children[0]) == 0 && chain.constant_count == 1;
+    bool zero = chain.constant_count == 1 && chain.constant == 0 && !negation;
+    bool constant_left = node->children[0]->type == NODE_NUMBER && !negation;
+    if (!chain.cancelled && chain.constant_count < 2 && !zero && !constant_left) {
+        return;
+    }
+
+    replace_node(node, build_sum(&chain));
+}
+
+static void fold_product(ASTNode *node) {
+    Chain chain;
+    memset(&chain, 0, sizeof(chain));
+    chain.constant = 1;
+    collect_product(&chain, &node);
+    if (chain.too_long) return;
+
+    if (chain.constant == 0 && chain.count > 0) {
+        // x * 0 is 0 when x can be left out
+        if (is_removable(node)) replace_with_number(node, 0);
+        return;
+    }
+    if (chain.constant_count < 2 && !(chain.constant_count == 1 && (chain.constant == 1 || chain.constant == -1)) &&
+        node->children[0]->type != NODE_NUMBER) {
+        return;
+    }
+
+    replace_node(node, build_product(&chain));
+}
+
+// Fold one binary operation whose operands are already folded
+static void fold_binary_operation(ASTNode *node) {
+    ASTNode *left = node->children[0];
+    ASTNode *right = node->children[1];
+    const char *op = node->value;
+
+    int result;
+    if (left->type == NODE_NUMBER && right->type == NODE_NUMBER &&
+        evaluate(op, number_value(left), number_value(right), &result)) {
+        replace_with_number(node, result);
+        return;
+    }
+
+    if (is_operator(node, "+") || is_operator(node, "-")) {
+        fold_sum(node);
+    } else if (is_operator(node, "*")) {
+        fold_product(node);
+    } else if (is_operator(node, "/") && right->type == NODE_NUMBER && number_value(right) == 1) {
+        replace_with_child(node, 0);
+    } else if (is_operator(node, "%") && right->type == NODE_NUMBER && number_value(right) == 1 &&
+               is_removable(left)) {
+        replace_with_number(node, 0);
+    }
+}
+
+static void fold_node(ASTNode *node) {
+    if (!node) return;
+
+    for (int i = 0; i < node->num_children; i++) {
+        fold_node(node->children[i]);
+    }
+
+    if (node->type == NODE_BINARY_OP && node->num_children == 2 && node->value) {
+        fold_binary_operation(node);
+    }
+}
+
+void fold_constants(ASTNode *function) {
+    fold_node(find_child(function, NODE_BLOCK));
+}
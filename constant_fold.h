@@ -0,0 +1,14 @@
+#ifndef CONSTANT_FOLD_H
+#define CONSTANT_FOLD_H
+
+#include "parser.h"
+
+// Constant folding and algebraic simplification of expression trees.
+// Constant subtrees are evaluated with 16-bit wrap-around, chains of +/-
+// and of * are reassociated so their constants combine, and identities
+// such as x + 0, x * 1 and x / 1 are removed. Nothing with side effects is
+// dropped, and division by zero (or -32768 / -1) is never evaluated: it is
+// left in place for range analysis or the program to report.
+void fold_constants(ASTNode *function);
+
+#endif // CONSTANT_FOLD_H
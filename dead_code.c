@@ -0,0 +1,288 @@
+#include "dead_code.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Successors of a block; a block without a terminator falls through
+static int successors(IRBlock *block, IRBlock *next[2]) {
+    IRInstr *last = ir_terminator(block);
+    if (!last) {
+        next[0] = block->next;
+        return block->next ? 1 : 0;
+    }
+    switch (last->op) {
+        case IR_JUMP:
+            next[0] = last->target;
+            return 1;
+        case IR_BRANCH:
+        case IR_LOOP:
+            next[0] = last->target;
+            next[1] = last->else_target;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// Drop the blocks no path from the entry reaches, and the loops that lost
+// one of their blocks with them
+static void remove_unreachable_blocks(IRFunction *function) {
+    bool *reached = (bool *)calloc(function->block_count, sizeof(bool));
+    IRBlock **work = (IRBlock **)malloc(sizeof(IRBlock *) * function->block_count);
+    if (!reached || !work) {
+        fprintf(stderr, "Failed to allocate memory for dead code elimination in '%s'\n", function->name);
+        free(reached);
+        free(work);
+        return;
+    }
+
+    int pending = 0;
+    if (function->first_block) {
+        reached[function->first_block->id] = true;
+        work[pending++] = function->first_block;
+    }
+    while (pending > 0) {
+        IRBlock *next[2];
+        int count = successors(work[--pending], next);
+        for (int i = 0; i < count; i++) {
+            if (!reached[next[i]->id]) {
+                reached[next[i]->id] = true;
+                work[pending++] = next[i];
+            }
+        }
+    }
+
+    for (IRBlock *block = function->first_block; block;) {
+        IRBlock *next = block->next;
+        if (!reached[block->id]) ir_remove_block(function, block);
+        block = next;
+    }
+
+    IRLoop **link = &function->loops;
+    function->last_loop = NULL;
+    for (IRLoop *loop = function->loops; loop; loop = loop->next) {
+        if (reached[loop->preheader->id] && reached[loop->body->id] &&
+            reached[loop->test->id] && reached[loop->exit->id]) {
+            *link = loop;
+            link = &loop->next;
+            function->last_loop = loop;
+        }
+    }
+    *link = NULL;
+
+    free(reached);
+    free(work);
+}
+
+// Update the live slots across one instruction, walking backwards
+static void transfer(const IRInstr *instr, bool *live) {
+    if (instr->op == IR_STORE) live[instr->dst.value] = false;
+    if (instr->op == IR_LOAD) live[instr->a.value] = true;
+    if (instr->op == IR_LOOP) live[instr->dst.value] = true;
+}
+
+// Slots live at the end of a block: those live into any successor
+static void live_out(IRFunction *function, IRBlock *block, const bool *live_in, bool *live) {
+    int slots = function->slot_count;
+    memset(live, 0, sizeof(bool) * slots);
+    IRBlock *next[2];
+    int count = successors(block, next);
+    for (int i = 0; i < count; i++) {
+        const bool *in = &live_in[next[i]->id * slots];
+        for (int slot = 0; slot < slots; slot++) {
+            live[slot] = live[slot] || in[slot];
+        }
+    }
+}
+
+// Remove the stores whose value is never loaded: the slot is overwritten
+// or the function returns first
+static bool remove_dead_stores(IRFunction *function) {
+    int slots = function->slot_count;
+    if (slots == 0) return false;
+    bool *live_in = (bool *)calloc((size_t)function->block_count * slots, sizeof(bool));
+    bool *live = (bool *)malloc(sizeof(bool) * slots);
+    if (!live_in || !live) {
+        fprintf(stderr, "Failed to allocate memory for dead store elimination in '%s'\n", function->name);
+        free(live_in);
+        free(live);
+        return false;
+    }
+
+    // Iterate the backward liveness equations to a fixed point
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IRBlock *block = function->last_block; block; block = block->prev) {
+            live_out(function, block, live_in, live);
+            for (IRInstr *instr = block->last; instr; instr = instr->prev) {
+                transfer(instr, live);
+            }
+            bool *in = &live_in[block->id * slots];
+            if (memcmp(in, live, sizeof(bool) * slots) != 0) {
+                memcpy(in, live, sizeof(bool) * slots);
+                changed = true;
+            }
+        }
+    }
+
+    bool removed = false;
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        live_out(function, block, live_in, live);
+        for (IRInstr *instr = block->last; instr;) {
+            IRInstr *prev = instr->prev;
+            if (instr->op == IR_STORE && !live[instr->dst.value]) {
+                ir_remove(block, instr);
+                removed = true;
+            } else {
+                transfer(instr, live);
+            }
+            instr = prev;
+        }
+    }
+
+    free(live_in);
+    free(live);
+    return removed;
+}
+
+// Does the value of `vreg` (defined at `from`) only end up stored back
+// into `slot`, through pure arithmetic?
+static bool only_feeds(const IRInstr *from, int vreg, int slot) {
+    for (const IRInstr *instr = from->next; instr; instr = instr->next) {
+        bool uses = ir_is_vreg(instr->a, vreg) || ir_is_vreg(instr->b, vreg);
+        for (int i = 0; i < instr->arg_count; i++) {
+            uses = uses || ir_is_vreg(instr->args[i], vreg);
+        }
+        if (!uses) continue;
+        if (instr->op == IR_STORE && instr->dst.value == slot) continue;
+        if (!ir_is_pure(instr) || instr->dst.kind != IR_OPERAND_VREG ||
+            !only_feeds(instr, instr->dst.value, slot)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Remove the stores to variables that are only read to compute their own
+// next value (`x = x + 1` with x used nowhere else)
+static bool remove_self_updates(IRFunction *function) {
+    bool removed = false;
+    for (int slot = 0; slot < function->slot_count; slot++) {
+        bool stored = false;
+        bool useless = true;
+        for (IRBlock *block = function->first_block; block && useless; block = block->next) {
+            for (IRInstr *instr = block->first; instr && useless; instr = instr->next) {
+                if (instr->op == IR_STORE && instr->dst.value == slot) stored = true;
+                if (instr->op == IR_LOOP && instr->dst.value == slot) useless = false;
+                if (instr->op == IR_LOAD && instr->a.value == slot) useless = only_feeds(instr, instr->dst.value, slot);
+            }
+        }
+        if (!stored || !useless) continue;
+
+        for (IRBlock *block = function->first_block; block; block = block->next) {
+            for (IRInstr *instr = block->first; instr;) {
+                IRInstr *next = instr->next;
+                if (instr->op == IR_STORE && instr->dst.value == slot) {
+                    ir_remove(block, instr);
+                    removed = true;
+                }
+                instr = next;
+            }
+        }
+    }
+    return removed;
+}
+
+static void count_use(int *uses, IROperand operand, int delta) {
+    if (operand.kind == IR_OPERAND_VREG) uses[operand.value] += delta;
+}
+
+// Remove the pure instructions whose value nothing uses
+static bool remove_unused_values(IRFunction *function) {
+    int *uses = (int *)calloc(function->vreg_count + 1, sizeof(int));
+    if (!uses) {
+        fprintf(stderr, "Failed to allocate memory for dead code elimination in '%s'\n", function->name);
+        return false;
+    }
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            count_use(uses, instr->a, 1);
+            count_use(uses, instr->b, 1);
+            for (int i = 0; i < instr->arg_count; i++) {
+                count_use(uses, instr->args[i], 1);
+            }
+        }
+    }
+
+    // Values are used after their definition in the same block: walking
+    // backwards frees a whole expression tree in one pass
+    bool removed = false;
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->last; instr;) {
+            IRInstr *prev = instr->prev;
+            if (instr->dst.kind == IR_OPERAND_VREG && uses[instr->dst.value] == 0 && ir_is_pure(instr)) {
+                count_use(uses, instr->a, -1);
+                count_use(uses, instr->b, -1);
+                ir_remove(block, instr);
+                removed = true;
+            }
+            instr = prev;
+        }
+    }
+
+    free(uses);
+    return removed;
+}
+
+static void renumber_slot(IROperand *operand, const int *index) {
+    if (operand->kind == IR_OPERAND_SLOT) operand->value = index[operand->value];
+}
+
+// Drop the slots of locals nothing accesses any more
+static void remove_unused_slots(IRFunction *function) {
+    int *index = (int *)malloc(sizeof(int) * (function->slot_count + 1));
+    if (!index) {
+        fprintf(stderr, "Failed to allocate memory for dead code elimination in '%s'\n", function->name);
+        return;
+    }
+    for (int slot = 0; slot < function->slot_count; slot++) {
+        index[slot] = function->slots[slot].parameter ? 0 : -1;
+    }
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->dst.kind == IR_OPERAND_SLOT) index[instr->dst.value] = 0;
+            if (instr->a.kind == IR_OPERAND_SLOT) index[instr->a.value] = 0;
+        }
+    }
+
+    int count = 0;
+    for (int slot = 0; slot < function->slot_count; slot++) {
+        if (index[slot] < 0) continue;
+        function->slots[count] = function->slots[slot];
+        index[slot] = count++;
+    }
+    function->slot_count = count;
+
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            renumber_slot(&instr->dst, index);
+            renumber_slot(&instr->a, index);
+        }
+    }
+    free(index);
+}
+
+void eliminate_dead_code(IRFunction *function) {
+    remove_unreachable_blocks(function);
+
+    // Each removal can leave a load, and with it a store, without a use
+    bool changed = true;
+    while (changed) {
+        changed = remove_dead_stores(function);
+        changed = remove_self_updates(function) || changed;
+        changed = remove_unused_values(function) || changed;
+    }
+
+    remove_unused_slots(function);
+}
@@ -0,0 +1,15 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "ir.h"
+
+// Dead code and dead store elimination.
+// Blocks no path reaches (code after a return, for instance) are dropped,
+// stores to a variable that is not read again before it is overwritten or
+// the function returns are removed, and so is every computation whose
+// value ends up unused, including variables only ever updated from
+// themselves. Every lulog, luload and call stays, in its order, as does a
+// division that may fault. Locals left without any access lose their slot.
+void eliminate_dead_code(IRFunction *function);
+
+#endif // DEAD_CODE_H
@@ -0,0 +1,281 @@
+#include "emitter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define write_fd(fd, data, length) _write((fd), (data), (unsigned int)(length))
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#define write_fd(fd, data, length) write((fd), (data), (length))
+#endif
+
+// Most iovec entries handed to a single writev call
+#define EMITTER_IOV_MAX 64
+
+// Sixteen levels of indentation; deeper levels are written in pieces
+static const char indent_spaces[] =
+    "                                                                ";
+
+// Initialize an emitter
+void init_emitter(Emitter *emitter, int fd) {
+    init_string_buffer(&emitter->buffer);
+    emitter->fd = fd;
+    emitter->failed = false;
+}
+
+// Free the emitter's buffer
+void free_emitter(Emitter *emitter) {
+    if (!emitter) return;
+    free_string_buffer(&emitter->buffer);
+}
+
+// Write a whole block to a file descriptor, retrying short writes
+static bool write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        long written = (long)write_fd(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Write pending output to the file descriptor
+bool flush_emitter(Emitter *emitter) {
+    if (!emitter) return false;
+    if (emitter->fd < 0 || emitter->buffer.length == 0) return !emitter->failed;
+
+    if (!write_all(emitter->fd, emitter->buffer.data, emitter->buffer.length)) {
+        fprintf(stderr, "Failed to write assembly output\n");
+        emitter->failed = true;
+    }
+    emitter->buffer.length = 0;
+    return !emitter->failed;
+}
+
+// Append raw text
+void emit_text(Emitter *emitter, const char *text, size_t length) {
+    if (!buffer_append(&emitter->buffer, text, length)) {
+        emitter->failed = true;
+        return;
+    }
+    if (emitter->fd >= 0 && emitter->buffer.length >= EMITTER_HIGH_WATER) {
+        flush_emitter(emitter);
+    }
+}
+
+void emit_string(Emitter *emitter, const char *text) {
+    emit_text(emitter, text, strlen(text));
+}
+
+void emit_char(Emitter *emitter, char c) {
+    emit_text(emitter, &c, 1);
+}
+
+// Append indentation from the precomputed string
+void emit_indent(Emitter *emitter, int level) {
+    size_t length = (size_t)(level > 0 ? level : 0) * 4;
+    while (length > 0) {
+        size_t chunk = length < sizeof(indent_spaces) - 1 ? length : sizeof(indent_spaces) - 1;
+        emit_text(emitter, indent_spaces, chunk);
+        length -= chunk;
+    }
+}
+
+// Format an unsigned value in the given base (digits only)
+static int format_unsigned(char *buffer, unsigned int value, unsigned int base) {
+    static const char digit_chars[] = "0123456789abcdef";
+    char digits[16];
+    int count = 0;
+
+    do {
+        digits[count++] = digit_chars[value % base];
+        value /= base;
+    } while (value != 0);
+
+    for (int i = 0; i < count; i++) {
+        buffer[i] = digits[count - 1 - i];
+    }
+    buffer[count] = '\0';
+    return count;
+}
+
+// Format a decimal integer
+int format_int(char *buffer, int value) {
+    if (value < 0) {
+        buffer[0] = '-';
+        // Negate in unsigned arithmetic so INT_MIN is handled
+        return 1 + format_unsigned(buffer + 1, 0u - (unsigned int)value, 10);
+    }
+    return format_unsigned(buffer, (unsigned int)value, 10);
+}
+
+void emit_int(Emitter *emitter, int value) {
+    char digits[16];
+    emit_text(emitter, digits, (size_t)format_int(digits, value));
+}
+
+// Append a converted field, padded to the requested width
+static void emit_field(Emitter *emitter, const char *text, size_t length,
+                       int width, bool left, bool zero) {
+    size_t padding = width > 0 && (size_t)width > length ? (size_t)width - length : 0;
+
+    if (left) {
+        emit_text(emitter, text, length);
+        while (padding-- > 0) emit_char(emitter, ' ');
+        return;
+    }
+
+    if (zero && length > 0 && (text[0] == '-' || text[0] == '+')) {
+        // Zeros go between the sign and the digits
+        emit_char(emitter, text[0]);
+        text++;
+        length--;
+    }
+    while (padding-- > 0) emit_char(emitter, zero ? '0' : ' ');
+    emit_text(emitter, text, length);
+}
+
+// Append formatted text with the small set of supported conversions
+void emit_vformat(Emitter *emitter, const char *format, va_list args) {
+    const char *p = format;
+
+    while (*p) {
+        // Copy the literal run up to the next conversion in one go
+        const char *run = p;
+        while (*p && *p != '%') p++;
+        if (p > run) emit_text(emitter, run, (size_t)(p - run));
+        if (!*p) break;
+
+        const char *spec = p++;
+        bool plus = false, left = false, zero = false;
+        for (;; p++) {
+            if (*p == '+') plus = true;
+            else if (*p == '-') left = true;
+            else if (*p == '0') zero = true;
+            else break;
+        }
+
+        int width = 0;
+        while (*p >= '0' && *p <= '9') {
+            width = width * 10 + (*p++ - '0');
+        }
+
+        char digits[24];
+        switch (*p) {
+            case 'd':
+            case 'i': {
+                int value = va_arg(args, int);
+                int length = 0;
+                if (plus && value >= 0) digits[length++] = '+';
+                length += format_int(digits + length, value);
+                emit_field(emitter, digits, (size_t)length, width, left, zero);
+                break;
+            }
+            case 'u':
+            case 'x': {
+                unsigned int value = va_arg(args, unsigned int);
+                int length = format_unsigned(digits, value, *p == 'x' ? 16 : 10);
+                emit_field(emitter, digits, (size_t)length, width, left, zero);
+                break;
+            }
+            case 'c':
+                digits[0] = (char)va_arg(args, int);
+                emit_field(emitter, digits, 1, width, left, false);
+                break;
+            case 's': {
+                const char *text = va_arg(args, const char *);
+                if (!text) text = "(null)";
+                emit_field(emitter, text, strlen(text), width, left, false);
+                break;
+            }
+            case '%':
+                emit_char(emitter, '%');
+                break;
+            default:
+                // Unsupported conversion: keep the text as written
+                emit_text(emitter, spec, (size_t)(p - spec) + (*p ? 1 : 0));
+                break;
+        }
+
+        if (*p) p++;
+    }
+}
+
+void emit_format(Emitter *emitter, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    emit_vformat(emitter, format, args);
+    va_end(args);
+}
+
+// Append the contents of in-memory emitters
+void emit_emitters(Emitter *emitter, Emitter *parts, int count) {
+    for (int i = 0; i < count; i++) {
+        if (parts[i].failed) emitter->failed = true;
+    }
+
+    if (emitter->fd < 0) {
+        for (int i = 0; i < count; i++) {
+            emit_text(emitter, parts[i].buffer.data ? parts[i].buffer.data : "", parts[i].buffer.length);
+        }
+        return;
+    }
+
+#ifdef _WIN32
+    // No writev: write the pieces back to back
+    flush_emitter(emitter);
+    for (int i = 0; i < count && !emitter->failed; i++) {
+        if (parts[i].buffer.length > 0 &&
+            !write_all(emitter->fd, parts[i].buffer.data, parts[i].buffer.length)) {
+            fprintf(stderr, "Failed to write assembly output\n");
+            emitter->failed = true;
+        }
+    }
+#else
+    // Pending text first, then every part, without copying them together
+    int index = -1;
+    while (index < count && !emitter->failed) {
+        struct iovec vector[EMITTER_IOV_MAX];
+        int used = 0;
+
+        for (; index < count && used < EMITTER_IOV_MAX; index++) {
+            const StringBuffer *part = index < 0 ? &emitter->buffer : &parts[index].buffer;
+            if (part->length == 0) continue;
+            vector[used].iov_base = part->data;
+            vector[used].iov_len = part->length;
+            used++;
+        }
+
+        struct iovec *next = vector;
+        while (used > 0) {
+            ssize_t written = writev(emitter->fd, next, used);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                fprintf(stderr, "Failed to write assembly output\n");
+                emitter->failed = true;
+                break;
+            }
+
+            // Drop fully written entries and trim a partially written one
+            while (used > 0 && (size_t)written >= next->iov_len) {
+                written -= (ssize_t)next->iov_len;
+                next++;
+                used--;
+            }
+            if (used > 0) {
+                next->iov_base = (char *)next->iov_base + written;
+                next->iov_len -= (size_t)written;
+            }
+        }
+    }
+    emitter->buffer.length = 0;
+#endif
+}
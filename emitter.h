@@ -0,0 +1,56 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "string_buffer.h"
+
+// Pending output is written out once it grows past this many bytes
+#define EMITTER_HIGH_WATER (1 << 20)
+
+// Buffered assembly output.
+// Text accumulates in a growable buffer and reaches the file descriptor in
+// large write/writev calls; an emitter without a descriptor just collects
+// text in memory (used for per-function output).
+typedef struct {
+    StringBuffer buffer;         // Pending output
+    int fd;                      // Destination (-1 keeps everything in memory)
+    bool failed;                 // Set once a write or allocation has failed
+} Emitter;
+
+// Initialize an emitter writing to a file descriptor (or -1 for memory only)
+void init_emitter(Emitter *emitter, int fd);
+
+// Free the emitter's buffer (without flushing)
+void free_emitter(Emitter *emitter);
+
+// Append raw text
+void emit_text(Emitter *emitter, const char *text, size_t length);
+void emit_string(Emitter *emitter, const char *text);
+void emit_char(Emitter *emitter, char c);
+
+// Append `level` levels of four-space indentation
+void emit_indent(Emitter *emitter, int level);
+
+// Append a decimal integer
+void emit_int(Emitter *emitter, int value);
+
+// Append formatted text. Only the conversions the code generator uses are
+// supported: %s, %c, %d/%i, %u, %x with optional '+', '-', '0' flags and a
+// field width, and %%. Anything else is copied through unchanged.
+void emit_format(Emitter *emitter, const char *format, ...);
+void emit_vformat(Emitter *emitter, const char *format, va_list args);
+
+// Append the contents of other in-memory emitters, in order. With a file
+// descriptor the pending text and the parts go out in one writev call.
+void emit_emitters(Emitter *emitter, Emitter *parts, int count);
+
+// Write all pending output to the file descriptor
+bool flush_emitter(Emitter *emitter);
+
+// Format a decimal integer into `buffer` (at least 12 bytes, NUL-terminated);
+// returns the number of characters written
+int format_int(char *buffer, int value);
+
+#endif // EMITTER_H
@@ -0,0 +1,43 @@
+#include "frame.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool scopes_overlap(const IRSlot *a, const IRSlot *b) {
+    return a->scope_first <= b->scope_last && b->scope_first <= a->scope_last;
+}
+
+void layout_frame(IRFunction *function, const bool *in_memory) {
+    function->frame_size = 0;
+    // Words of the frame taken by the variables placed so far that overlap
+    // the one being placed (at most one word per slot)
+    bool *taken = (bool *)calloc(function->slot_count + 1, sizeof(bool));
+    if (!taken) {
+        fprintf(stderr, "Failed to allocate memory for the frame of '%s'\n", function->name);
+        return;
+    }
+
+    for (int i = 0; i < function->slot_count; i++) {
+        IRSlot *slot = &function->slots[i];
+        if (slot->parameter) continue;
+        slot->offset = 0;
+        if (!in_memory[i]) continue;
+
+        int words = function->frame_size / 2;
+        for (int word = 0; word < words; word++) {
+            taken[word] = false;
+        }
+        for (int j = 0; j < i; j++) {
+            const IRSlot *other = &function->slots[j];
+            if (!other->parameter && other->offset != 0 && scopes_overlap(slot, other)) {
+                taken[-other->offset / 2 - 1] = true;
+            }
+        }
+
+        int word = 0;
+        while (word < words && taken[word]) word++;
+        slot->offset = -2 * (word + 1);
+        if (word == words) function->frame_size += 2;
+    }
+
+    free(taken);
+}
@@ -0,0 +1,14 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+#include "ir.h"
+
+// Stack frame layout.
+// Every local that needs memory gets a word below bp, at the lowest offset
+// no variable with an overlapping scope interval has: variables of sibling
+// scopes share their words. Locals without memory get offset 0. The frame
+// size is set to exactly the words used.
+void layout_frame(IRFunction *function, const bool *in_memory);
+
+#endif // FRAME_H
@@ -0,0 +1,237 @@
+#include "induction.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// A luloop counting a variable down to zero
+typedef struct {
+    IRLoop *loop;
+    IRBlock *latch;              // Last block of the body, jumps to the test
+    int counter;                 // Slot of the counted variable
+    IRInstr *load;               // count = count - 1 at the end of the latch
+    IRInstr *decrement;
+    IRInstr *store;
+} CountedLoop;
+
+static int vreg_uses(const IRBlock *block, int vreg) {
+    int uses = 0;
+    for (const IRInstr *instr = block->first; instr; instr = instr->next) {
+        uses += ir_is_vreg(instr->a, vreg) + ir_is_vreg(instr->b, vreg);
+        for (int i = 0; i < instr->arg_count; i++) {
+            uses += ir_is_vreg(instr->args[i], vreg);
+        }
+    }
+    return uses;
+}
+
+// Instruction of `block` defining a virtual register (NULL if none)
+static IRInstr* definition(IRBlock *block, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG) return NULL;
+    for (IRInstr *instr = block->first; instr; instr = instr->next) {
+        if (ir_is_vreg(instr->dst, operand.value)) return instr;
+    }
+    return NULL;
+}
+
+static bool is_load_of(const IRInstr *instr, int slot) {
+    return instr && instr->op == IR_LOAD && instr->a.value == slot;
+}
+
+static bool writes_slot(const IRInstr *instr, int slot) {
+    return (instr->op == IR_STORE || instr->op == IR_LOOP) && instr->dst.value == slot;
+}
+
+// Slot tested by `v = load [slot]; branch v > 0` (or != 0, >= 1) going to
+// the body or leaving the loop; -1 if the test has any other form
+static int test_counter(const IRLoop *loop) {
+    IRInstr *load = loop->test->first;
+    IRInstr *branch = load ? load->next : NULL;
+    if (!load || load->op != IR_LOAD || !branch || branch->op != IR_BRANCH || branch->next) return -1;
+
+    IROperand a = branch->a;
+    IROperand b = branch->b;
+    IRCondition cond = branch->cond;
+    if (a.kind == IR_OPERAND_IMM) {
+        IROperand swap = a;
+        a = b;
+        b = swap;
+        cond = ir_swap_condition(cond);
+    }
+    if (branch->target == loop->exit && branch->else_target == loop->body) {
+        cond = ir_negate_condition(cond);
+    } else if (branch->target != loop->body || branch->else_target != loop->exit) {
+        return -1;
+    }
+    if (!ir_is_vreg(a, load->dst.value) || b.kind != IR_OPERAND_IMM) return -1;
+
+    bool positive = ((cond == IR_COND_GT || cond == IR_COND_NE) && b.value == 0) ||
+                    (cond == IR_COND_GE && b.value == 1);
+    return positive ? load->a.value : -1;
+}
+
+// Is the test entered only from the preheader and the latch?
+static bool test_entered_from_loop(const IRFunction *function, const CountedLoop *counted) {
+    const IRLoop *loop = counted->loop;
+    for (const IRBlock *block = function->first_block; block; block = block->next) {
+        const IRInstr *last = block->last;
+        bool enters = last && (last->target == loop->test || last->else_target == loop->test);
+        if (!last || !ir_is_terminator(last->op)) enters = block->next == loop->test;
+        if (enters && block != loop->preheader && block != counted->latch) return false;
+    }
+    return true;
+}
+
+// Find `count = count - 1` as the last access to the counter in the latch,
+// with no other write to the counter anywhere in the body
+static bool match_counted_loop(const IRFunction *function, IRLoop *loop, CountedLoop *counted) {
+    counted->loop = loop;
+    counted->counter = test_counter(loop);
+    counted->latch = loop->test->prev;
+    if (counted->counter < 0 || counted->latch == loop->preheader) return false;
+
+    IRInstr *jump = ir_terminator(counted->latch);
+    IRInstr *preheader_jump = ir_terminator(loop->preheader);
+    if (!jump || jump->op != IR_JUMP || jump->target != loop->test ||
+        !preheader_jump || preheader_jump->op != IR_JUMP || preheader_jump->target != loop->test ||
+        !test_entered_from_loop(function, counted)) {
+        return false;
+    }
+
+    int counter = counted->counter;
+    IRInstr *store = NULL;
+    for (IRInstr *instr = jump->prev; instr && !store; instr = instr->prev) {
+        if (is_load_of(instr, counter)) return false;
+        if (writes_slot(instr, counter)) store = instr;
+    }
+    if (!store) return false;
+
+    IRInstr *decrement = definition(counted->latch, store->a);
+    if (!decrement || vreg_uses(counted->latch, decrement->dst.value) != 1 ||
+        !((decrement->op == IR_SUB && decrement->b.kind == IR_OPERAND_IMM && decrement->b.value == 1) ||
+          (decrement->op == IR_ADD && decrement->b.kind == IR_OPERAND_IMM && decrement->b.value == -1))) {
+        return false;
+    }
+    IRInstr *load = definition(counted->latch, decrement->a);
+    if (!is_load_of(load, counter)) return false;
+    for (IRInstr *instr = load->next; instr != store; instr = instr->next) {
+        if (writes_slot(instr, counter)) return false;
+    }
+
+    // The body runs from its first block to the latch in layout order
+    bool reached = false;
+    for (IRBlock *block = loop->body; block && block != loop->test; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (writes_slot(instr, counter) && instr != store) return false;
+        }
+        if (block == counted->latch) reached = true;
+    }
+    if (!reached) return false;
+
+    counted->load = load;
+    counted->decrement = decrement;
+    counted->store = store;
+    return true;
+}
+
+// Close the loop with IR_LOOP and move the test in front of the body,
+// where it only decides whether the body runs at all: the counter is
+// positive at every later iteration, so "count - 1 > 0" is "count - 1 != 0"
+static void close_counted_loop(IRFunction *function, CountedLoop *counted) {
+    IRLoop *loop = counted->loop;
+    IRBlock *latch = counted->latch;
+
+    ir_remove(latch, counted->store);
+    ir_remove(latch, counted->decrement);
+    if (vreg_uses(latch, counted->load->dst.value) == 0) ir_remove(latch, counted->load);
+
+    IRInstr *jump = ir_terminator(latch);
+    jump->op = IR_LOOP;
+    jump->dst = ir_slot(counted->counter);
+    jump->target = loop->body;
+    jump->else_target = loop->exit;
+
+    ir_remove_block(function, loop->test);
+    ir_insert_block_before(function, loop->body, loop->test);
+    loop->test->loop_depth = loop->depth - 1;
+    function->slots[counted->counter].counter = true;
+}
+
+// New slot for the derived variable count * factor
+static int add_derived_slot(IRFunction *function, int counter, int factor) {
+    char name[128];
+    snprintf(name, sizeof(name), "%s*%d", function->slots[counter].name, factor);
+    return ir_add_temporary_slot(function, name);
+}
+
+static IRInstr* new_instr(IRFunction *function, IROpcode op, IROperand dst, IROperand a, IROperand b) {
+    IRInstr *instr = ir_new_instr(function, op, op == IR_STORE ? IR_TYPE_VOID : IR_TYPE_INT);
+    instr->dst = dst;
+    instr->a = a;
+    instr->b = b;
+    return instr;
+}
+
+// slot = [source] op constant, in front of `position`
+static void emit_update(IRFunction *function, IRBlock *block, IRInstr *position,
+                        int slot, int source, IROpcode op, int constant) {
+    IROperand value = ir_vreg(ir_new_vreg(function));
+    IROperand result = ir_vreg(ir_new_vreg(function));
+    ir_insert_before(block, position, new_instr(function, IR_LOAD, value, ir_slot(source), ir_none()));
+    ir_insert_before(block, position, new_instr(function, op, result, value, ir_imm(constant)));
+    ir_insert_before(block, position, new_instr(function, IR_STORE, ir_slot(slot), result, ir_none()));
+}
+
+// A shift is already as cheap as the update of a derived variable
+static bool worth_deriving(int factor) {
+    int magnitude = factor < 0 ? -factor : factor;
+    return magnitude > 1 && (magnitude & (magnitude - 1)) != 0;
+}
+
+// Replace `v = load [count]; w = v * c` in the body with a load of the
+// derived variable count * c
+static void derive_products(IRFunction *function, CountedLoop *counted) {
+    IRLoop *loop = counted->loop;
+    int counter = counted->counter;
+    IRInstr *closing = ir_terminator(counted->latch);
+    // Derived variables of this loop: slot and factor
+    int first_slot = function->slot_count;
+    int factors[64];
+
+    for (IRBlock *block = loop->body; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op != IR_MUL) continue;
+            IROperand count = instr->a.kind == IR_OPERAND_VREG ? instr->a : instr->b;
+            IROperand factor = instr->a.kind == IR_OPERAND_VREG ? instr->b : instr->a;
+            IRInstr *load = definition(block, count);
+            if (factor.kind != IR_OPERAND_IMM || !worth_deriving(factor.value) || !is_load_of(load, counter)) {
+                continue;
+            }
+
+            int slot = first_slot;
+            while (slot < function->slot_count && factors[slot - first_slot] != factor.value) slot++;
+            if (slot == function->slot_count) {
+                if (slot - first_slot == (int)(sizeof(factors) / sizeof(factors[0]))) continue;
+                // Set up before the loop, stepped down next to the counter
+                slot = add_derived_slot(function, counter, factor.value);
+                factors[slot - first_slot] = factor.value;
+                IRInstr *entry = ir_terminator(loop->preheader);
+                emit_update(function, loop->preheader, entry, slot, counter, IR_MUL, factor.value);
+                emit_update(function, counted->latch, closing, slot, slot, IR_SUB, factor.value);
+            }
+
+            instr->op = IR_LOAD;
+            instr->a = ir_slot(slot);
+            instr->b = ir_none();
+            if (vreg_uses(block, load->dst.value) == 0) ir_remove(block, load);
+        }
+        if (block == counted->latch) break;
+    }
+}
+
+void optimize_induction_variables(IRFunction *function) {
+    for (IRLoop *loop = function->loops; loop; loop = loop->next) {
+        CountedLoop counted;
+        if (!match_counted_loop(function, loop, &counted)) continue;
+        close_counted_loop(function, &counted);
+        derive_products(function, &counted);
+    }
+}
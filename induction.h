@@ -0,0 +1,15 @@
+#ifndef INDUCTION_H
+#define INDUCTION_H
+
+#include "ir.h"
+
+// Induction variable optimization of counted luloops.
+// A loop whose condition is `count > 0` (or `count != 0`), where `count` is
+// only changed by a `count = count - 1` at the end of the body, is closed
+// by one IR_LOOP (dec/jnz, or `loop` when the counter gets CX) and its test
+// becomes a guard in front of the body. Products `count * c` in the body
+// turn into a variable that starts at count * c and goes down by c every
+// iteration. Loops of any other shape are left alone.
+void optimize_induction_variables(IRFunction *function);
+
+#endif // INDUCTION_H
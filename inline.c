@@ -0,0 +1,611 @@
+#include "inline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Leaf functions of at most this many instructions are inlined at every call
+#define TINY_SIZE 8
+
+// Clocks a call costs on the 8086 besides passing its arguments: call,
+// push bp, mov bp, sp, mov sp, bp, pop bp and ret
+#define CALL_CYCLES 58
+
+// Calls in a loop run this many times more often than outside it
+#define LOOP_WEIGHT 10
+#define MAX_WEIGHTED_DEPTH 4
+
+// A call the inliner considers
+typedef struct {
+    IRInstr *call;
+    int callee;                  // Index of the called function
+    int growth;                  // Instructions added by inlining it
+    long benefit;                // Clocks saved, weighted by loop depth
+    bool forced;                 // Inlined regardless of the limit
+    int number;                  // Position in the caller (keeps the ranking stable)
+} CallSite;
+
+// State of the inliner over the whole program
+typedef struct {
+    IRFunction **functions;
+    int count;
+    int limit;
+    int *callees;                // Call graph: functions called by function i are
+    int *first_callee;           // callees[first_callee[i]] to callees[first_callee[i + 1] - 1]
+    int *sites;                  // Calls of every function in the program
+    bool *called;                // Called anywhere before inlining
+    bool *recursive;             // Reaches itself through calls
+    int *order;                  // Callees before their callers
+    int order_count;
+    int *index;                  // Strongly connected components (Tarjan)
+    int *lowlink;
+    int *stack;
+    bool *on_stack;
+    int stack_size;
+    int next_index;
+    int temporary_count;         // Numbers the slots the inliner adds
+} Inliner;
+
+// Copy of a callee's body being made in a caller
+typedef struct {
+    IRFunction *caller;
+    const IRFunction *callee;
+    IRInstr *call;
+    IROperand *values;           // Caller operand of every callee virtual register
+    int *slots;                  // Caller slot of every callee slot
+    IRBlock **blocks;            // Caller block of every callee block
+    IRBlock *after;              // Block with the code after the call
+    int result;                  // Slot the returns store their value in (-1: unused)
+} BodyCopy;
+
+static int find_function(const Inliner *inliner, const char *name) {
+    for (int i = 0; i < inliner->count; i++) {
+        if (inliner->functions[i] && strcmp(inliner->functions[i]->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int depth_weight(int depth) {
+    int weight = 1;
+    for (int i = 0; i < depth && i < MAX_WEIGHTED_DEPTH; i++) {
+        weight *= LOOP_WEIGHT;
+    }
+    return weight;
+}
+
+// Instructions of a function, leaving out the taking of its arguments and
+// its returns (the call replaced by the body needs those as well)
+static int function_size(const IRFunction *function) {
+    int size = 0;
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op != IR_ARG && instr->op != IR_RET) size++;
+        }
+    }
+    return size;
+}
+
+static bool is_leaf(const IRFunction *function) {
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op == IR_CALL) return false;
+        }
+    }
+    return true;
+}
+
+// The entry block of a callee becomes part of the caller's block: nothing
+// may jump back to it
+static bool entry_is_inlinable(const IRFunction *function) {
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        IRInstr *last = ir_terminator(block);
+        if (last && (last->target == function->first_block || last->else_target == function->first_block)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Record the calls of every function, as edges of the call graph
+static bool build_call_graph(Inliner *inliner) {
+    int edges = 0;
+    for (int i = 0; i < inliner->count; i++) {
+        IRFunction *function = inliner->functions[i];
+        for (IRBlock *block = function ? function->first_block : NULL; block; block = block->next) {
+            for (IRInstr *instr = block->first; instr; instr = instr->next) {
+                if (instr->op == IR_CALL) edges++;
+            }
+        }
+    }
+    inliner->callees = (int *)malloc(sizeof(int) * (edges + 1));
+    if (!inliner->callees) return false;
+
+    int edge = 0;
+    for (int i = 0; i < inliner->count; i++) {
+        inliner->first_callee[i] = edge;
+        IRFunction *function = inliner->functions[i];
+        for (IRBlock *block = function ? function->first_block : NULL; block; block = block->next) {
+            for (IRInstr *instr = block->first; instr; instr = instr->next) {
+                if (instr->op != IR_CALL) continue;
+                int callee = find_function(inliner, instr->callee);
+                if (callee < 0) continue;
+                inliner->callees[edge++] = callee;
+                inliner->sites[callee]++;
+                inliner->called[callee] = true;
+            }
+        }
+    }
+    inliner->first_callee[inliner->count] = edge;
+    return true;
+}
+
+// Tarjan's algorithm: components come out callees first, which is the
+// order to inline in, and every function in a component of more than one
+// (or calling itself) is recursive
+static void strong_connect(Inliner *inliner, int function) {
+    inliner->index[function] = inliner->lowlink[function] = inliner->next_index++;
+    inliner->stack[inliner->stack_size++] = function;
+    inliner->on_stack[function] = true;
+
+    for (int edge = inliner->first_callee[function]; edge < inliner->first_callee[function + 1]; edge++) {
+        int callee = inliner->callees[edge];
+        if (callee == function) inliner->recursive[function] = true;
+        if (inliner->index[callee] < 0) {
+            strong_connect(inliner, callee);
+            if (inliner->lowlink[callee] < inliner->lowlink[function]) {
+                inliner->lowlink[function] = inliner->lowlink[callee];
+            }
+        } else if (inliner->on_stack[callee] && inliner->index[callee] < inliner->lowlink[function]) {
+            inliner->lowlink[function] = inliner->index[callee];
+        }
+    }
+
+    if (inliner->lowlink[function] != inliner->index[function]) return;
+    int first = inliner->order_count;
+    int member;
+    do {
+        member = inliner->stack[--inliner->stack_size];
+        inliner->on_stack[member] = false;
+        inliner->order[inliner->order_count++] = member;
+    } while (member != function);
+    if (inliner->order_count - first > 1) {
+        for (int i = first; i < inliner->order_count; i++) {
+            inliner->recursive[inliner->order[i]] = true;
+        }
+    }
+}
+
+static IROperand copy_operand(const BodyCopy *copy, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG) return copy->values[operand.value];
+    if (operand.kind == IR_OPERAND_SLOT) return ir_slot(copy->slots[operand.value]);
+    return operand;
+}
+
+// Copy a callee instruction into `block`, in front of `position` (at the
+// end if NULL)
+static void copy_instruction(BodyCopy *copy, const IRInstr *instr, IRBlock *block, IRInstr *position) {
+    IRFunction *caller = copy->caller;
+
+    // The register arguments are the operands the call passes
+    if (instr->op == IR_ARG) {
+        copy->values[instr->dst.value] = copy->call->args[instr->a.value];
+        return;
+    }
+
+    // A return stores the value for the code after the call and goes there
+    if (instr->op == IR_RET) {
+        if (copy->result >= 0 && instr->a.kind != IR_OPERAND_NONE) {
+            IRInstr *store = ir_new_instr(caller, IR_STORE, IR_TYPE_VOID);
+            store->dst = ir_slot(copy->result);
+            store->a = copy_operand(copy, instr->a);
+            ir_insert_before(block, position, store);
+        }
+        IRInstr *jump = ir_new_instr(caller, IR_JUMP, IR_TYPE_VOID);
+        jump->target = copy->after;
+        ir_insert_before(block, position, jump);
+        return;
+    }
+
+    IRInstr *clone = ir_new_instr(caller, instr->op, instr->type);
+    clone->cond = instr->cond;
+    clone->flags = instr->flags;
+    clone->a = copy_operand(copy, instr->a);
+    clone->b = copy_operand(copy, instr->b);
+    if (instr->dst.kind == IR_OPERAND_VREG) {
+        copy->values[instr->dst.value] = ir_vreg(ir_new_vreg(caller));
+    }
+    clone->dst = copy_operand(copy, instr->dst);
+    clone->target = instr->target ? copy->blocks[instr->target->id] : NULL;
+    clone->else_target = instr->else_target ? copy->blocks[instr->else_target->id] : NULL;
+    if (instr->callee) clone->callee = arena_strdup(&caller->arena, instr->callee);
+    if (instr->arg_count > 0) {
+        clone->args = (IROperand *)arena_alloc(&caller->arena, sizeof(IROperand) * instr->arg_count);
+        for (int i = 0; i < instr->arg_count; i++) {
+            clone->args[i] = copy_operand(copy, instr->args[i]);
+        }
+        clone->arg_count = instr->arg_count;
+    }
+    ir_insert_before(block, position, clone);
+}
+
+static bool reads_vreg(const IRInstr *instr, int vreg) {
+    bool reads = ir_is_vreg(instr->a, vreg) || ir_is_vreg(instr->b, vreg);
+    for (int i = 0; i < instr->arg_count; i++) {
+        reads = reads || ir_is_vreg(instr->args[i], vreg);
+    }
+    return reads;
+}
+
+// Pass a value computed in front of the call to the block after it, where
+// the copied body separates the two: through a slot, as values do not
+// live across blocks
+static IROperand carry_value(Inliner *inliner, BodyCopy *copy, IRBlock *block, IROperand operand, int *carried) {
+    if (operand.kind != IR_OPERAND_VREG || carried[operand.value] == 0) return operand;
+    if (carried[operand.value] < 0) {
+        char name[32];
+        snprintf(name, sizeof(name), "inl.%d", ++inliner->temporary_count);
+        int slot = ir_add_temporary_slot(copy->caller, name);
+
+        IRInstr *store = ir_new_instr(copy->caller, IR_STORE, IR_TYPE_VOID);
+        store->dst = ir_slot(slot);
+        store->a = operand;
+        ir_insert_before(block, copy->call, store);
+
+        IRInstr *load = ir_new_instr(copy->caller, IR_LOAD, IR_TYPE_INT);
+        load->dst = ir_vreg(ir_new_vreg(copy->caller));
+        load->a = ir_slot(slot);
+        ir_insert_after(copy->after, NULL, load);
+        carried[operand.value] = load->dst.value;
+    }
+    return ir_vreg(carried[operand.value]);
+}
+
+// Move the instructions after the call into copy->after. Values defined
+// in front of the call that are read there go through slots, and so does
+// the result of the call. `carried` has room for every virtual register
+// of the caller, all 0.
+static void split_at_call(Inliner *inliner, BodyCopy *copy, IRBlock *block, int *carried) {
+    IRFunction *caller = copy->caller;
+    // 0: not defined in front of the call, -1: not carried yet, else the
+    // register loading the carried value
+    for (IRInstr *instr = block->first; instr != copy->call; instr = instr->next) {
+        if (instr->dst.kind == IR_OPERAND_VREG) carried[instr->dst.value] = -1;
+    }
+
+    while (copy->call->next) {
+        IRInstr *instr = copy->call->next;
+        ir_remove(block, instr);
+        ir_append(copy->after, instr);
+    }
+
+    bool returns_value = false;
+    for (IRInstr *instr = copy->after->first; instr; instr = instr->next) {
+        returns_value = returns_value || reads_vreg(instr, copy->call->dst.value);
+    }
+    for (IRInstr *instr = copy->after->first; instr; instr = instr->next) {
+        instr->a = carry_value(inliner, copy, block, instr->a, carried);
+        instr->b = carry_value(inliner, copy, block, instr->b, carried);
+        for (int i = 0; i < instr->arg_count; i++) {
+            instr->args[i] = carry_value(inliner, copy, block, instr->args[i], carried);
+        }
+    }
+
+    copy->result = -1;
+    if (returns_value) {
+        char name[128];
+        snprintf(name, sizeof(name), "%s.return", copy->callee->name);
+        copy->result = ir_add_temporary_slot(caller, name);
+        IRInstr *load = ir_new_instr(caller, IR_LOAD, IR_TYPE_INT);
+        load->dst = copy->call->dst;
+        load->a = ir_slot(copy->result);
+        ir_insert_after(copy->after, NULL, load);
+    }
+}
+
+// Innermost loop of `function` that `block` belongs to
+static IRLoop* enclosing_loop(IRFunction *function, IRBlock *block) {
+    IRLoop *innermost = NULL;
+    for (IRLoop *loop = function->loops; loop; loop = loop->next) {
+        if (loop->depth > block->loop_depth || (innermost && loop->depth <= innermost->depth)) continue;
+        for (IRBlock *member = loop->preheader->next; member && member != loop->exit; member = member->next) {
+            if (member == block) {
+                innermost = loop;
+                break;
+            }
+        }
+    }
+    return innermost;
+}
+
+// Add the loops of the callee, nested in the loops around the call.
+// `copies` has room for a loop per callee block.
+static void copy_loops(BodyCopy *copy, IRBlock *block, IRLoop **copies) {
+    IRLoop *parent = enclosing_loop(copy->caller, block);
+    int count = 0;
+    for (const IRLoop *loop = copy->callee->loops; loop; loop = loop->next) {
+        IRLoop *clone = ir_new_loop(copy->caller);
+        clone->preheader = copy->blocks[loop->preheader->id];
+        clone->body = copy->blocks[loop->body->id];
+        clone->test = copy->blocks[loop->test->id];
+        clone->exit = copy->blocks[loop->exit->id];
+        clone->depth = loop->depth + block->loop_depth;
+        clone->parent = parent;
+        // Parents come first in the list
+        int number = 0;
+        for (const IRLoop *outer = copy->callee->loops; outer != loop; outer = outer->next, number++) {
+            if (outer == loop->parent) clone->parent = copies[number];
+        }
+        copies[count++] = clone;
+    }
+}
+
+// Put the loops back in source order, which is the order of their
+// preheaders, once copies were added at the end
+static void sort_loops(IRFunction *function) {
+    int *position = (int *)malloc(sizeof(int) * (function->block_count + 1));
+    if (!position) return;
+    int number = 0;
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        position[block->id] = number++;
+    }
+
+    IRLoop *sorted = NULL;
+    for (IRLoop *loop = function->loops; loop;) {
+        IRLoop *next = loop->next;
+        IRLoop **link = &sorted;
+        while (*link && position[(*link)->preheader->id] <= position[loop->preheader->id]) {
+            link = &(*link)->next;
+        }
+        loop->next = *link;
+        *link = loop;
+        loop = next;
+    }
+    function->loops = sorted;
+    function->last_loop = NULL;
+    for (IRLoop *loop = sorted; loop; loop = loop->next) {
+        function->last_loop = loop;
+    }
+    free(position);
+}
+
+// Copy the body of copy->callee over copy->call in `block`. `carried` has
+// room for every virtual register of the caller, `loops` for a loop per
+// callee block.
+static void copy_body(Inliner *inliner, BodyCopy *copy, IRBlock *block, int *carried, IRLoop **loops) {
+    IRFunction *caller = copy->caller;
+    const IRFunction *callee = copy->callee;
+    IRInstr *call = copy->call;
+
+    // The callee's variables get slots of their own; the parameters the
+    // caller would push are stored into theirs at the call
+    for (int slot = 0; slot < callee->slot_count; slot++) {
+        char name[128];
+        snprintf(name, sizeof(name), "%s.%s", callee->name, callee->slots[slot].name);
+        copy->slots[slot] = ir_add_temporary_slot(caller, name);
+        if (!callee->slots[slot].parameter) continue;
+        int argument = IR_REGISTER_ARGUMENTS + (callee->slots[slot].offset - 4) / 2;
+        IRInstr *store = ir_new_instr(caller, IR_STORE, IR_TYPE_VOID);
+        store->dst = ir_slot(copy->slots[slot]);
+        store->a = call->args[argument];
+        ir_insert_before(block, call, store);
+    }
+
+    IRBlock *entry = callee->first_block;
+    IRInstr *entry_end = ir_terminator(entry);
+    copy->blocks[entry->id] = block;
+
+    if (entry_end && entry_end->op == IR_RET) {
+        // A body of one block goes right in front of the call, which
+        // becomes a copy of the returned value
+        for (IRInstr *instr = entry->first; instr != entry_end; instr = instr->next) {
+            copy_instruction(copy, instr, block, call);
+        }
+        if (entry_end->a.kind == IR_OPERAND_NONE) {
+            ir_remove(block, call);
+        } else {
+            call->a = copy_operand(copy, entry_end->a);
+            call->op = call->a.kind == IR_OPERAND_IMM ? IR_CONST : IR_MOV;
+            call->callee = NULL;
+            call->args = NULL;
+            call->arg_count = 0;
+        }
+    } else {
+        // Otherwise the block ends with the callee's entry and continues
+        // after the copied blocks
+        copy->after = ir_new_block(caller, NULL);
+        copy->after->loop_depth = block->loop_depth;
+        split_at_call(inliner, copy, block, carried);
+        ir_remove(block, call);
+
+        if (block->next) {
+            ir_insert_block_before(caller, block->next, copy->after);
+        } else {
+            ir_append_block(caller, copy->after);
+        }
+        for (IRBlock *original = entry->next; original; original = original->next) {
+            IRBlock *clone = ir_new_block(caller, NULL);
+            clone->loop_depth = block->loop_depth + original->loop_depth;
+            ir_insert_block_before(caller, copy->after, clone);
+            copy->blocks[original->id] = clone;
+        }
+
+        for (IRBlock *original = entry; original; original = original->next) {
+            for (IRInstr *instr = original->first; instr; instr = instr->next) {
+                copy_instruction(copy, instr, copy->blocks[original->id], NULL);
+            }
+        }
+
+        // The jump into a loop that closed the block now closes the block after the call
+        for (IRLoop *loop = caller->loops; loop; loop = loop->next) {
+            if (loop->preheader == block) loop->preheader = copy->after;
+        }
+        copy_loops(copy, block, loops);
+    }
+}
+
+// Replace `call` in `block` of `caller` by a copy of the body of `callee`
+static bool inline_call(Inliner *inliner, IRFunction *caller, IRBlock *block, IRInstr *call,
+                        const IRFunction *callee) {
+    BodyCopy copy;
+    memset(&copy, 0, sizeof(copy));
+    copy.caller = caller;
+    copy.callee = callee;
+    copy.call = call;
+    copy.result = -1;
+    copy.values = (IROperand *)calloc(callee->vreg_count + 1, sizeof(IROperand));
+    copy.slots = (int *)calloc(callee->slot_count + 1, sizeof(int));
+    copy.blocks = (IRBlock **)calloc(callee->block_count + 1, sizeof(IRBlock *));
+    int *carried = (int *)calloc(caller->vreg_count + 1, sizeof(int));
+    IRLoop **loops = (IRLoop **)calloc(callee->block_count + 1, sizeof(IRLoop *));
+    bool copied = copy.values && copy.slots && copy.blocks && carried && loops;
+    if (copied) {
+        copy_body(inliner, &copy, block, carried, loops);
+    } else {
+        fprintf(stderr, "Failed to allocate memory for inlining '%s' into '%s'\n", callee->name, caller->name);
+    }
+
+    free(copy.values);
+    free(copy.slots);
+    free(copy.blocks);
+    free(carried);
+    free(loops);
+    return copied;
+}
+
+// Rank the calls worth the most clocks per instruction of growth first
+static int compare_sites(const void *a, const void *b) {
+    const CallSite *x = (const CallSite *)a;
+    const CallSite *y = (const CallSite *)b;
+    if (x->forced != y->forced) return x->forced ? -1 : 1;
+    long left = x->benefit * (y->growth > 1 ? y->growth : 1);
+    long right = y->benefit * (x->growth > 1 ? x->growth : 1);
+    if (left != right) return left > right ? -1 : 1;
+    return x->number - y->number;
+}
+
+// Inline the chosen calls of one function
+static void inline_calls_of(Inliner *inliner, int caller_index) {
+    IRFunction *caller = inliner->functions[caller_index];
+    int call_count = 0;
+    for (IRBlock *block = caller->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op == IR_CALL) call_count++;
+        }
+    }
+    if (call_count == 0) return;
+
+    CallSite *sites = (CallSite *)malloc(sizeof(CallSite) * call_count);
+    int *sizes = (int *)malloc(sizeof(int) * inliner->count);
+    if (!sites || !sizes) {
+        fprintf(stderr, "Failed to allocate memory for inlining into '%s'\n", caller->name);
+        free(sites);
+        free(sizes);
+        return;
+    }
+    for (int i = 0; i < inliner->count; i++) {
+        sizes[i] = -1;
+    }
+
+    int count = 0;
+    for (IRBlock *block = caller->first_block; block; block = block->next) {
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op != IR_CALL) continue;
+            int callee = find_function(inliner, instr->callee);
+            if (callee < 0 || callee == caller_index || inliner->recursive[callee] ||
+                strcmp(instr->callee, "main") == 0 || !entry_is_inlinable(inliner->functions[callee])) {
+                continue;
+            }
+            if (sizes[callee] < 0) sizes[callee] = function_size(inliner->functions[callee]);
+
+            CallSite *site = &sites[count];
+            site->call = instr;
+            site->callee = callee;
+            site->growth = sizes[callee] - (1 + instr->arg_count);
+            site->benefit = (long)CALL_CYCLES * depth_weight(block->loop_depth);
+            site->forced = inliner->sites[callee] == 1 ||
+                           (sizes[callee] <= TINY_SIZE && is_leaf(inliner->functions[callee]));
+            site->number = count++;
+        }
+    }
+    qsort(sites, count, sizeof(CallSite), compare_sites);
+
+    int growth = 0;
+    for (int i = 0; i < count; i++) {
+        CallSite *site = &sites[i];
+        if (!site->forced && site->growth > 0) {
+            if (growth + site->growth > inliner->limit) continue;
+            growth += site->growth;
+        }
+
+        IRBlock *block = caller->first_block;
+        while (block) {
+            IRInstr *instr = block->first;
+            while (instr && instr != site->call) instr = instr->next;
+            if (instr) break;
+            block = block->next;
+        }
+        const IRFunction *callee = inliner->functions[site->callee];
+        if (!block || !inline_call(inliner, caller, block, site->call, callee)) continue;
+
+        // The callee's calls now also happen here
+        inliner->sites[site->callee]--;
+        for (int edge = inliner->first_callee[site->callee]; edge < inliner->first_callee[site->callee + 1]; edge++) {
+            inliner->sites[inliner->callees[edge]]++;
+        }
+    }
+    sort_loops(caller);
+
+    free(sites);
+    free(sizes);
+}
+
+void inline_functions(IRFunction **functions, int count, int limit) {
+    Inliner inliner;
+    memset(&inliner, 0, sizeof(inliner));
+    inliner.functions = functions;
+    inliner.count = count;
+    inliner.limit = limit;
+    inliner.first_callee = (int *)malloc(sizeof(int) * (count + 1));
+    inliner.sites = (int *)calloc(count, sizeof(int));
+    inliner.called = (bool *)calloc(count, sizeof(bool));
+    inliner.recursive = (bool *)calloc(count, sizeof(bool));
+    inliner.order = (int *)malloc(sizeof(int) * count);
+    inliner.index = (int *)malloc(sizeof(int) * count);
+    inliner.lowlink = (int *)malloc(sizeof(int) * count);
+    inliner.stack = (int *)malloc(sizeof(int) * count);
+    inliner.on_stack = (bool *)calloc(count, sizeof(bool));
+
+    if (!inliner.first_callee || !inliner.sites || !inliner.called || !inliner.recursive || !inliner.order ||
+        !inliner.index || !inliner.lowlink || !inliner.stack || !inliner.on_stack || !build_call_graph(&inliner)) {
+        fprintf(stderr, "Failed to allocate memory for inlining\n");
+    } else {
+        for (int i = 0; i < count; i++) {
+            inliner.index[i] = -1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (functions[i] && inliner.index[i] < 0) strong_connect(&inliner, i);
+        }
+
+        for (int i = 0; i < inliner.order_count; i++) {
+            inline_calls_of(&inliner, inliner.order[i]);
+        }
+
+        // A function whose every call was inlined is not needed any more
+        for (int i = 0; i < count; i++) {
+            if (functions[i] && inliner.called[i] && inliner.sites[i] == 0 && strcmp(functions[i]->name, "main") != 0) {
+                free_ir_function(functions[i]);
+                functions[i] = NULL;
+            }
+        }
+    }
+
+    free(inliner.callees);
+    free(inliner.first_callee);
+    free(inliner.sites);
+    free(inliner.called);
+    free(inliner.recursive);
+    free(inliner.order);
+    free(inliner.index);
+    free(inliner.lowlink);
+    free(inliner.stack);
+    free(inliner.on_stack);
+}
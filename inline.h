@@ -0,0 +1,24 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include "ir.h"
+
+// Growth allowed by default (-finline-limit), in IR instructions per caller
+#define DEFAULT_INLINE_LIMIT 32
+
+// Function inlining over the whole program, on freshly lowered IR.
+// A call is replaced by a copy of the callee's body: the arguments become
+// the callee's parameters directly, its locals get slots of their own in
+// the caller and its returns store the result and jump to the code after
+// the call. Calls of a function called from a single place, and of small
+// leaf functions, are always inlined. The other calls are ranked by the
+// cycles they cost (the call, the frame setup and the return, weighted by
+// loop depth) per instruction of growth, and inlined while the caller
+// grows by at most `limit` instructions. Functions that are recursive,
+// directly or through others, are never inlined; main never is either.
+// Callees are inlined into their callers only after their own calls.
+// `functions` holds the `count` functions of the program; those whose
+// every call was inlined are freed and set to NULL.
+void inline_functions(IRFunction **functions, int count, int limit);
+
+#endif // INLINE_H
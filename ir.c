@@ -0,0 +1,444 @@
+#include "ir.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Create an empty IR function
+IRFunction* create_ir_function(const char *name) {
+    IRFunction *function = (IRFunction *)malloc(sizeof(IRFunction));
+    if (!function) {
+        fprintf(stderr, "Memory allocation failed for IR function\n");
+        return NULL;
+    }
+
+    memset(function, 0, sizeof(IRFunction));
+    init_arena(&function->arena);
+    function->name = arena_strdup(&function->arena, name);
+    return function;
+}
+
+// Free an IR function and everything in its arena
+void free_ir_function(IRFunction *function) {
+    if (!function) return;
+    free_arena(&function->arena);
+    free(function);
+}
+
+// Create a block (not yet placed in the layout)
+IRBlock* ir_new_block(IRFunction *function, const char *name) {
+    IRBlock *block = (IRBlock *)arena_alloc(&function->arena, sizeof(IRBlock));
+    block->id = function->block_count++;
+    block->name = name ? arena_strdup(&function->arena, name) : NULL;
+    return block;
+}
+
+// Place a block at the end of the layout
+void ir_append_block(IRFunction *function, IRBlock *block) {
+    block->prev = function->last_block;
+    block->next = NULL;
+    if (function->last_block) {
+        function->last_block->next = block;
+    } else {
+        function->first_block = block;
+    }
+    function->last_block = block;
+}
+
+// Place a block in front of another one
+void ir_insert_block_before(IRFunction *function, IRBlock *position, IRBlock *block) {
+    block->next = position;
+    block->prev = position->prev;
+    if (position->prev) {
+        position->prev->next = block;
+    } else {
+        function->first_block = block;
+    }
+    position->prev = block;
+}
+
+// Take a block out of the layout (to place it elsewhere)
+void ir_remove_block(IRFunction *function, IRBlock *block) {
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        function->first_block = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    } else {
+        function->last_block = block->prev;
+    }
+    block->prev = NULL;
+    block->next = NULL;
+}
+
+// Allocate a fresh virtual register
+int ir_new_vreg(IRFunction *function) {
+    return ++function->vreg_count;
+}
+
+// Add a stack slot and return its index
+int ir_add_slot(IRFunction *function, const char *name, int offset, bool parameter) {
+    if (function->slot_count == function->slot_capacity) {
+        // Slots are few; growing by copying within the arena is fine
+        int capacity = function->slot_capacity ? function->slot_capacity * 2 : 16;
+        IRSlot *slots = (IRSlot *)arena_alloc(&function->arena, sizeof(IRSlot) * capacity);
+        if (function->slot_count > 0) {
+            memcpy(slots, function->slots, sizeof(IRSlot) * function->slot_count);
+        }
+        function->slots = slots;
+        function->slot_capacity = capacity;
+    }
+
+    IRSlot *slot = &function->slots[function->slot_count];
+    slot->name = arena_strdup(&function->arena, name);
+    slot->offset = offset;
+    slot->parameter = parameter;
+    slot->counter = false;
+    slot->scope_first = 0;
+    slot->scope_last = INT_MAX;
+    return function->slot_count++;
+}
+
+// Add a slot for a value the optimizer introduces, live in the whole function
+int ir_add_temporary_slot(IRFunction *function, const char *name) {
+    return ir_add_slot(function, name, 0, false);
+}
+
+// Operand constructors
+IROperand ir_none(void) {
+    IROperand operand = { IR_OPERAND_NONE, 0 };
+    return operand;
+}
+
+IROperand ir_vreg(int vreg) {
+    IROperand operand = { IR_OPERAND_VREG, vreg };
+    return operand;
+}
+
+IROperand ir_imm(int value) {
+    IROperand operand = { IR_OPERAND_IMM, value };
+    return operand;
+}
+
+IROperand ir_slot(int slot) {
+    IROperand operand = { IR_OPERAND_SLOT, slot };
+    return operand;
+}
+
+bool ir_is_vreg(IROperand operand, int vreg) {
+    return operand.kind == IR_OPERAND_VREG && operand.value == vreg;
+}
+
+// Create an instruction (not yet placed in a block)
+IRInstr* ir_new_instr(IRFunction *function, IROpcode op, IRType type) {
+    IRInstr *instr = (IRInstr *)arena_alloc(&function->arena, sizeof(IRInstr));
+    instr->op = op;
+    instr->type = type;
+    return instr;
+}
+
+// Add an instruction at the end of a block
+void ir_append(IRBlock *block, IRInstr *instr) {
+    instr->prev = block->last;
+    instr->next = NULL;
+    if (block->last) {
+        block->last->next = instr;
+    } else {
+        block->first = instr;
+    }
+    block->last = instr;
+}
+
+// Insert an instruction in front of another one (at the end if position is NULL)
+void ir_insert_before(IRBlock *block, IRInstr *position, IRInstr *instr) {
+    if (!position) {
+        ir_append(block, instr);
+        return;
+    }
+
+    instr->next = position;
+    instr->prev = position->prev;
+    if (position->prev) {
+        position->prev->next = instr;
+    } else {
+        block->first = instr;
+    }
+    position->prev = instr;
+}
+
+// Insert an instruction after another one (at the start if position is NULL)
+void ir_insert_after(IRBlock *block, IRInstr *position, IRInstr *instr) {
+    if (!position) {
+        ir_insert_before(block, block->first, instr);
+        return;
+    }
+
+    instr->prev = position;
+    instr->next = position->next;
+    if (position->next) {
+        position->next->prev = instr;
+    } else {
+        block->last = instr;
+    }
+    position->next = instr;
+}
+
+// Unlink an instruction from its block (its memory stays in the arena)
+void ir_remove(IRBlock *block, IRInstr *instr) {
+    if (instr->prev) {
+        instr->prev->next = instr->next;
+    } else {
+        block->first = instr->next;
+    }
+    if (instr->next) {
+        instr->next->prev = instr->prev;
+    } else {
+        block->last = instr->prev;
+    }
+    instr->prev = NULL;
+    instr->next = NULL;
+}
+
+bool ir_is_terminator(IROpcode op) {
+    return op == IR_JUMP || op == IR_BRANCH || op == IR_LOOP || op == IR_RET || op == IR_TAIL_CALL;
+}
+
+// Can the instruction be left out or run earlier without changing what the
+// program does? Division faults on a zero divisor and on -32768 / -1, so it
+// only qualifies with another constant divisor.
+bool ir_is_pure(const IRInstr *instr) {
+    switch (instr->op) {
+        case IR_CONST:
+        case IR_MOV:
+        case IR_LOAD:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_MULHI:
+        case IR_SHL:
+        case IR_SHR:
+        case IR_SAR:
+        case IR_AND:
+        case IR_NEG:
+        case IR_SET:
+            return true;
+        case IR_DIV:
+        case IR_MOD:
+        case IR_UDIV:
+        case IR_UMOD:
+            return instr->b.kind == IR_OPERAND_IMM && instr->b.value != 0 && instr->b.value != -1;
+        default:
+            return false;
+    }
+}
+
+// Terminator of a block (NULL if the block is still open)
+IRInstr* ir_terminator(IRBlock *block) {
+    return block->last && ir_is_terminator(block->last->op) ? block->last : NULL;
+}
+
+// Record a new loop after all loops created so far
+IRLoop* ir_new_loop(IRFunction *function) {
+    IRLoop *loop = (IRLoop *)arena_alloc(&function->arena, sizeof(IRLoop));
+    if (function->last_loop) {
+        function->last_loop->next = loop;
+    } else {
+        function->loops = loop;
+    }
+    function->last_loop = loop;
+    return loop;
+}
+
+const char* ir_opcode_name(IROpcode op) {
+    switch (op) {
+        case IR_CONST:  return "const";
+        case IR_MOV:    return "mov";
+        case IR_LOAD:   return "load";
+        case IR_STORE:  return "store";
+        case IR_ADD:    return "add";
+        case IR_SUB:    return "sub";
+        case IR_MUL:    return "mul";
+        case IR_DIV:    return "div";
+        case IR_MOD:    return "mod";
+        case IR_UDIV:   return "udiv";
+        case IR_UMOD:   return "umod";
+        case IR_MULHI:  return "mulhi";
+        case IR_SHL:    return "shl";
+        case IR_SHR:    return "shr";
+        case IR_SAR:    return "sar";
+        case IR_AND:    return "and";
+        case IR_NEG:    return "neg";
+        case IR_SET:    return "set";
+        case IR_LULOG:  return "lulog";
+        case IR_LULOAD: return "luload";
+        case IR_CALL:   return "call";
+        case IR_ARG:    return "arg";
+        case IR_JUMP:   return "jump";
+        case IR_BRANCH: return "branch";
+        case IR_LOOP:   return "loop";
+        case IR_RET:    return "ret";
+        case IR_TAIL_CALL: return "tailcall";
+    }
+    return "?";
+}
+
+const char* ir_condition_name(IRCondition cond) {
+    switch (cond) {
+        case IR_COND_EQ: return "eq";
+        case IR_COND_NE: return "ne";
+        case IR_COND_LT: return "lt";
+        case IR_COND_LE: return "le";
+        case IR_COND_GT: return "gt";
+        case IR_COND_GE: return "ge";
+    }
+    return "?";
+}
+
+// Condition that holds exactly when `cond` does not
+IRCondition ir_negate_condition(IRCondition cond) {
+    switch (cond) {
+        case IR_COND_EQ: return IR_COND_NE;
+        case IR_COND_NE: return IR_COND_EQ;
+        case IR_COND_LT: return IR_COND_GE;
+        case IR_COND_LE: return IR_COND_GT;
+        case IR_COND_GT: return IR_COND_LE;
+        case IR_COND_GE: return IR_COND_LT;
+    }
+    return cond;
+}
+
+// Condition to use when the operands are swapped
+IRCondition ir_swap_condition(IRCondition cond) {
+    switch (cond) {
+        case IR_COND_LT: return IR_COND_GT;
+        case IR_COND_LE: return IR_COND_GE;
+        case IR_COND_GT: return IR_COND_LT;
+        case IR_COND_GE: return IR_COND_LE;
+        default:         return cond;
+    }
+}
+
+// Dump helpers
+static const char* type_name(IRType type) {
+    switch (type) {
+        case IR_TYPE_INT:  return "int";
+        case IR_TYPE_BOOL: return "bool";
+        default:           return "void";
+    }
+}
+
+static void dump_operand(const IRFunction *function, IROperand operand, StringBuffer *output) {
+    switch (operand.kind) {
+        case IR_OPERAND_VREG:
+            buffer_printf(output, "v%d", operand.value);
+            break;
+        case IR_OPERAND_IMM:
+            buffer_printf(output, "%d", operand.value);
+            break;
+        case IR_OPERAND_SLOT:
+            buffer_printf(output, "[%s]", function->slots[operand.value].name);
+            break;
+        default:
+            buffer_printf(output, "_");
+            break;
+    }
+}
+
+static void dump_block_name(const IRBlock *block, StringBuffer *output) {
+    if (block->name) {
+        buffer_printf(output, "%s", block->name);
+    } else {
+        buffer_printf(output, "B%d", block->id);
+    }
+}
+
+// Dump a function in a stable, line-oriented text form
+void dump_ir_function(const IRFunction *function, StringBuffer *output) {
+    buffer_printf(output, "function %s\n", function->name);
+    for (int i = 0; i < function->slot_count; i++) {
+        const IRSlot *slot = &function->slots[i];
+        buffer_printf(output, "  slot %s", slot->name);
+        if (slot->offset != 0) buffer_printf(output, " %+d", slot->offset);
+        buffer_printf(output, "%s%s\n", slot->parameter ? " param" : "", slot->counter ? " counter" : "");
+    }
+
+    for (const IRBlock *block = function->first_block; block; block = block->next) {
+        dump_block_name(block, output);
+        buffer_printf(output, ":");
+        if (block->loop_depth > 0) {
+            buffer_printf(output, " ; loop depth %d", block->loop_depth);
+        }
+        buffer_printf(output, "\n");
+
+        for (const IRInstr *instr = block->first; instr; instr = instr->next) {
+            buffer_printf(output, "    ");
+            if (instr->dst.kind == IR_OPERAND_VREG) {
+                dump_operand(function, instr->dst, output);
+                buffer_printf(output, ":%s = ", type_name(instr->type));
+            }
+
+            buffer_printf(output, "%s", ir_opcode_name(instr->op));
+            if (instr->op == IR_SET || instr->op == IR_BRANCH) {
+                buffer_printf(output, ".%s", ir_condition_name(instr->cond));
+            }
+
+            switch (instr->op) {
+                case IR_STORE:
+                    buffer_printf(output, " ");
+                    dump_operand(function, instr->dst, output);
+                    buffer_printf(output, ", ");
+                    dump_operand(function, instr->a, output);
+                    break;
+                case IR_CALL:
+                case IR_TAIL_CALL:
+                    buffer_printf(output, " %s(", instr->callee);
+                    for (int i = 0; i < instr->arg_count; i++) {
+                        if (i > 0) buffer_printf(output, ", ");
+                        dump_operand(function, instr->args[i], output);
+                    }
+                    buffer_printf(output, ")");
+                    break;
+                case IR_JUMP:
+                    buffer_printf(output, " ");
+                    dump_block_name(instr->target, output);
+                    break;
+                case IR_BRANCH:
+                    buffer_printf(output, " ");
+                    dump_operand(function, instr->a, output);
+                    buffer_printf(output, ", ");
+                    dump_operand(function, instr->b, output);
+                    buffer_printf(output, " -> ");
+                    dump_block_name(instr->target, output);
+                    buffer_printf(output, ", ");
+                    dump_block_name(instr->else_target, output);
+                    break;
+                case IR_LOOP:
+                    buffer_printf(output, " ");
+                    dump_operand(function, instr->dst, output);
+                    buffer_printf(output, " -> ");
+                    dump_block_name(instr->target, output);
+                    buffer_printf(output, ", ");
+                    dump_block_name(instr->else_target, output);
+                    break;
+                default:
+                    if (instr->a.kind != IR_OPERAND_NONE) {
+                        buffer_printf(output, " ");
+                        dump_operand(function, instr->a, output);
+                    }
+                    if (instr->b.kind != IR_OPERAND_NONE) {
+                        buffer_printf(output, ", ");
+                        dump_operand(function, instr->b, output);
+                    }
+                    break;
+            }
+
+            if (instr->flags & IR_FLAG_NON_NEGATIVE) {
+                buffer_printf(output, " ; non-negative");
+            }
+            buffer_printf(output, "\n");
+        }
+    }
+    buffer_printf(output, "end %s\n", function->name);
+}
@@ -0,0 +1,199 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include "arena.h"
+#include "string_buffer.h"
+
+// Linear three-address IR.
+// A function is a list of basic blocks in layout order; each block is a
+// doubly linked list of instructions ending in a terminator (jump, branch,
+// loop, return or tail call). Instructions work on an unlimited supply of
+// virtual registers plus immediates; variables live in bp-relative slots
+// and are only touched through explicit loads and stores. Everything is
+// allocated from the function's arena, and passes rewrite the instruction
+// lists in place.
+
+// Value types
+typedef enum {
+    IR_TYPE_VOID,                // No value (stores, calls, control flow)
+    IR_TYPE_INT,                 // 16-bit signed integer
+    IR_TYPE_BOOL                 // 0 or 1
+} IRType;
+
+// Signed comparison conditions
+typedef enum {
+    IR_COND_EQ,
+    IR_COND_NE,
+    IR_COND_LT,
+    IR_COND_LE,
+    IR_COND_GT,
+    IR_COND_GE
+} IRCondition;
+
+// Operand kinds
+typedef enum {
+    IR_OPERAND_NONE,
+    IR_OPERAND_VREG,             // Virtual register number (from 1)
+    IR_OPERAND_IMM,              // Immediate value
+    IR_OPERAND_SLOT              // Index into the function's slot table
+} IROperandKind;
+
+typedef struct {
+    IROperandKind kind;
+    int value;
+} IROperand;
+
+// Opcodes. "dst = a op b" unless noted otherwise.
+typedef enum {
+    IR_CONST,                    // dst = a (immediate)
+    IR_MOV,                      // dst = a
+    IR_LOAD,                     // dst = slot a
+    IR_STORE,                    // slot dst = a
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,                      // Signed division
+    IR_MOD,                      // Signed remainder
+    IR_UDIV,                     // Division of operands known to be non-negative
+    IR_UMOD,                     // Remainder of operands known to be non-negative
+    IR_MULHI,                    // High word of the 32-bit signed product a * b
+    IR_SHL,                      // dst = a << b (b immediate)
+    IR_SHR,                      // Logical a >> b (b immediate)
+    IR_SAR,                      // Arithmetic a >> b (b immediate)
+    IR_AND,                      // dst = a & b
+    IR_NEG,                      // dst = -a
+    IR_SET,                      // dst = (a cond b) ? 1 : 0
+    IR_LULOG,                    // Print a (runtime call)
+    IR_LULOAD,                   // dst = number read by the runtime
+    IR_CALL,                     // dst = callee(args...)
+    IR_ARG,                      // dst = register argument number a (immediate), at the function entry
+    IR_JUMP,                     // goto target
+    IR_BRANCH,                   // if (a cond b) goto target else goto else_target
+    IR_LOOP,                     // slot dst -= 1; if (slot dst != 0) goto target else goto else_target
+    IR_RET,                      // Return a (if present) from the function
+    IR_TAIL_CALL                 // Return callee(args...), register arguments only, after releasing the frame
+} IROpcode;
+
+// Arguments the calling convention passes in registers; the caller pushes
+// the ones after them
+#define IR_REGISTER_ARGUMENTS 3
+
+// Instruction flags
+#define IR_FLAG_NON_NEGATIVE 0x01   // LULOG: value is known to be >= 0
+
+struct IRBlock;
+
+typedef struct IRInstr {
+    IROpcode op;
+    IRType type;                 // Type of the value produced (VOID if none)
+    IRCondition cond;            // SET and BRANCH
+    IROperand dst;
+    IROperand a;
+    IROperand b;
+    int flags;                   // IR_FLAG_* bits
+    struct IRBlock *target;      // JUMP target, BRANCH/LOOP taken target
+    struct IRBlock *else_target; // BRANCH/LOOP fall-through target
+    const char *callee;          // CALL, TAIL_CALL: function name
+    IROperand *args;             // CALL, TAIL_CALL: arguments (left to right)
+    int arg_count;
+    struct IRInstr *prev;
+    struct IRInstr *next;
+} IRInstr;
+
+typedef struct IRBlock {
+    int id;                      // Number within the function
+    const char *name;            // Assembly label (generated if NULL)
+    int loop_depth;              // Number of enclosing luloops
+    IRInstr *first;
+    IRInstr *last;
+    struct IRBlock *prev;        // Layout order
+    struct IRBlock *next;
+} IRBlock;
+
+// A luloop as laid out by the lowering: preheader jumps to the test, the
+// body starts at `body`, the test block branches back to it or to `exit`.
+// A counted loop (see induction.h) has its test moved in front of the
+// body and closes with IR_LOOP instead.
+typedef struct IRLoop {
+    IRBlock *preheader;          // Block ending in the jump to the test
+    IRBlock *body;               // First block of the body
+    IRBlock *test;               // Block evaluating the condition
+    IRBlock *exit;               // Block after the loop
+    int depth;                   // Nesting depth (1 for outermost)
+    struct IRLoop *parent;       // Enclosing loop
+    struct IRLoop *next;         // Next loop of the function (source order)
+} IRLoop;
+
+// Stack slot of a parameter or local variable. Scopes are numbered in
+// source order as they open and close, so a variable lives in the interval
+// [scope_first, scope_last] and variables of sibling scopes never overlap.
+typedef struct {
+    const char *name;
+    int offset;                  // Offset from bp (0 for a local kept in a register, see frame.h)
+    bool parameter;              // Passed by the caller (positive offset)
+    bool counter;                // Counter of a loop closed by IR_LOOP
+    int scope_first;             // Scope interval of the variable (the whole
+    int scope_last;              // function for parameters and temporaries)
+} IRSlot;
+
+typedef struct {
+    Arena arena;                 // Owns everything below
+    const char *name;
+    IRBlock *first_block;
+    IRBlock *last_block;
+    int block_count;
+    int vreg_count;              // Highest virtual register number in use
+    IRSlot *slots;
+    int slot_count;
+    int slot_capacity;
+    IRLoop *loops;               // All loops in source order
+    IRLoop *last_loop;
+    int frame_size;              // Bytes of locals below bp (set by the frame layout)
+} IRFunction;
+
+// Functions
+IRFunction* create_ir_function(const char *name);
+void free_ir_function(IRFunction *function);
+
+// Blocks
+IRBlock* ir_new_block(IRFunction *function, const char *name);
+void ir_append_block(IRFunction *function, IRBlock *block);
+void ir_insert_block_before(IRFunction *function, IRBlock *position, IRBlock *block);
+void ir_remove_block(IRFunction *function, IRBlock *block);
+
+// Virtual registers and slots
+int ir_new_vreg(IRFunction *function);
+int ir_add_slot(IRFunction *function, const char *name, int offset, bool parameter);
+int ir_add_temporary_slot(IRFunction *function, const char *name);
+
+// Operands
+IROperand ir_none(void);
+IROperand ir_vreg(int vreg);
+IROperand ir_imm(int value);
+IROperand ir_slot(int slot);
+bool ir_is_vreg(IROperand operand, int vreg);
+
+// Instructions
+IRInstr* ir_new_instr(IRFunction *function, IROpcode op, IRType type);
+void ir_append(IRBlock *block, IRInstr *instr);
+void ir_insert_before(IRBlock *block, IRInstr *position, IRInstr *instr);
+void ir_insert_after(IRBlock *block, IRInstr *position, IRInstr *instr);
+void ir_remove(IRBlock *block, IRInstr *instr);
+bool ir_is_terminator(IROpcode op);
+bool ir_is_pure(const IRInstr *instr);
+IRInstr* ir_terminator(IRBlock *block);
+
+// Loops
+IRLoop* ir_new_loop(IRFunction *function);
+
+// Names
+const char* ir_opcode_name(IROpcode op);
+const char* ir_condition_name(IRCondition cond);
+IRCondition ir_negate_condition(IRCondition cond);
+IRCondition ir_swap_condition(IRCondition cond);
+
+// Textual dump (one instruction per line, used by --dump-ir and the tests)
+void dump_ir_function(const IRFunction *function, StringBuffer *output);
+
+#endif // IR_H
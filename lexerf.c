@@ -638,19 +638,15 @@ void initialize_transition_matrix()
     transition_matrix[START]['/'] = COMMENT_SLASH;
     transition_matrix[COMMENT_SLASH]['/'] = SINGLE_LINE_COMMENT;
     
-    // Make COMMENT_SLASH work as an operator when not followed by another '/'
+    // A '/' not followed by another '/' is the division operator on its own:
+    // accept it and lex the next character (space, digit, identifier or '(')
+    // from the start
     for (int i = 0; i < 128; i++) {
-        if (i != '/' && transition_matrix[COMMENT_SLASH][i] == ERROR) {
-            transition_matrix[COMMENT_SLASH][i] = OPERATOR;
+        if (i != '/') {
+            transition_matrix[COMMENT_SLASH][i] = ACCEPT;
         }
     }
     
-    // Explicitly handle spaces and numbers after division operator
-    transition_matrix[COMMENT_SLASH][' '] = OPERATOR;
-    for (int i = '0'; i <= '9'; i++) {
-        transition_matrix[COMMENT_SLASH][i] = NUMBER;  // Changed to NUMBER state
-    }
-    
     // Add transitions from operators to numbers and identifiers
     for (int i = '0'; i <= '9'; i++) {
         transition_matrix[OPERATOR][i] = NUMBER;
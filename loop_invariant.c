@@ -0,0 +1,230 @@
+#include "loop_invariant.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Hoisted expressions remembered per loop, so one that occurs twice shares
+// its temporary
+#define MAX_HOISTED 32
+#define MAX_KEY 256
+
+// State while moving code out of one loop
+typedef struct {
+    IRFunction *function;
+    IRLoop *loop;
+    bool *written;               // Slots stored to anywhere in the loop
+    IRInstr **definition;        // Defining instruction of every virtual register in the loop
+    bool *invariant;             // Virtual registers with the same value in every iteration
+    int vreg_limit;              // Size of the two arrays above
+    int *temporary_count;        // Temporaries of the function so far (for their names)
+    char keys[MAX_HOISTED][MAX_KEY];
+    int slots[MAX_HOISTED];
+    int hoisted_count;
+} LoopMotion;
+
+static bool in_loop(const IRLoop *loop, const IRBlock *block) {
+    return block->loop_depth >= loop->depth;
+}
+
+static bool is_invariant(const LoopMotion *motion, IROperand operand) {
+    if (operand.kind == IR_OPERAND_IMM || operand.kind == IR_OPERAND_NONE) return true;
+    return operand.kind == IR_OPERAND_VREG && operand.value < motion->vreg_limit && motion->invariant[operand.value];
+}
+
+// Find the writes and the invariant values of the loop
+static void analyze_loop(LoopMotion *motion) {
+    const IRLoop *loop = motion->loop;
+    for (IRBlock *block = loop->preheader->next; block && block != loop->exit; block = block->next) {
+        if (!in_loop(loop, block)) continue;
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->op == IR_STORE || instr->op == IR_LOOP) motion->written[instr->dst.value] = true;
+        }
+    }
+
+    for (IRBlock *block = loop->preheader->next; block && block != loop->exit; block = block->next) {
+        if (!in_loop(loop, block)) continue;
+        for (IRInstr *instr = block->first; instr; instr = instr->next) {
+            if (instr->dst.kind != IR_OPERAND_VREG) continue;
+            int vreg = instr->dst.value;
+            motion->definition[vreg] = instr;
+            if (instr->op == IR_LOAD) {
+                motion->invariant[vreg] = !motion->written[instr->a.value];
+            } else {
+                motion->invariant[vreg] = ir_is_pure(instr) && is_invariant(motion, instr->a) &&
+                                          is_invariant(motion, instr->b);
+            }
+        }
+    }
+}
+
+// Work saved per iteration by hoisting the expression of `operand`, in
+// operations (products and quotients count double)
+static int expression_weight(const LoopMotion *motion, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG) return 0;
+    const IRInstr *instr = motion->definition[operand.value];
+    int weight = expression_weight(motion, instr->a) + expression_weight(motion, instr->b);
+    switch (instr->op) {
+        case IR_CONST:
+        case IR_LOAD:
+        case IR_MOV:
+            return weight;
+        case IR_MUL:
+        case IR_MULHI:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_UDIV:
+        case IR_UMOD:
+            return weight + 2;
+        default:
+            return weight + 1;
+    }
+}
+
+// Text identifying an expression; false if it does not fit
+static bool expression_key(const LoopMotion *motion, IROperand operand, char *key, size_t size) {
+    size_t length = strlen(key);
+    if (operand.kind == IR_OPERAND_IMM) {
+        return snprintf(key + length, size - length, " %d", operand.value) < (int)(size - length);
+    }
+    if (operand.kind != IR_OPERAND_VREG) return true;
+
+    const IRInstr *instr = motion->definition[operand.value];
+    if (instr->op == IR_LOAD) {
+        return snprintf(key + length, size - length, " [%d]", instr->a.value) < (int)(size - length);
+    }
+    if (snprintf(key + length, size - length, " (%d.%d", (int)instr->op, (int)instr->cond) >= (int)(size - length) ||
+        !expression_key(motion, instr->a, key, size) || !expression_key(motion, instr->b, key, size)) {
+        return false;
+    }
+    length = strlen(key);
+    return snprintf(key + length, size - length, ")") < (int)(size - length);
+}
+
+// Copy the expression of `operand` in front of `position`
+static IROperand clone_expression(LoopMotion *motion, IROperand operand, IRBlock *block, IRInstr *position) {
+    if (operand.kind != IR_OPERAND_VREG) return operand;
+
+    const IRInstr *instr = motion->definition[operand.value];
+    IRInstr *copy = ir_new_instr(motion->function, instr->op, instr->type);
+    copy->cond = instr->cond;
+    copy->flags = instr->flags;
+    copy->a = clone_expression(motion, instr->a, block, position);
+    copy->b = clone_expression(motion, instr->b, block, position);
+    copy->dst = ir_vreg(ir_new_vreg(motion->function));
+    ir_insert_before(block, position, copy);
+    return copy->dst;
+}
+
+static int vreg_uses(const IRBlock *block, int vreg) {
+    int uses = 0;
+    for (const IRInstr *instr = block->first; instr; instr = instr->next) {
+        uses += ir_is_vreg(instr->a, vreg) + ir_is_vreg(instr->b, vreg);
+        for (int i = 0; i < instr->arg_count; i++) {
+            uses += ir_is_vreg(instr->args[i], vreg);
+        }
+    }
+    return uses;
+}
+
+// Remove what computed an operand once nothing reads it any more
+static void remove_dead_expression(LoopMotion *motion, IRBlock *block, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG || vreg_uses(block, operand.value) > 0) return;
+    IRInstr *instr = motion->definition[operand.value];
+    ir_remove(block, instr);
+    remove_dead_expression(motion, block, instr->a);
+    remove_dead_expression(motion, block, instr->b);
+}
+
+// Compute the expression defining `vreg` in the preheader and load it
+// from its temporary in the loop
+static void hoist(LoopMotion *motion, IRBlock *block, int vreg) {
+    IRInstr *instr = motion->definition[vreg];
+    char key[MAX_KEY] = "";
+    bool keyed = expression_key(motion, instr->dst, key, sizeof(key));
+
+    int slot = -1;
+    for (int i = 0; keyed && i < motion->hoisted_count; i++) {
+        if (strcmp(motion->keys[i], key) == 0) slot = motion->slots[i];
+    }
+    if (slot < 0) {
+        char name[32];
+        snprintf(name, sizeof(name), "inv.%d", ++*motion->temporary_count);
+        slot = ir_add_temporary_slot(motion->function, name);
+
+        IRBlock *preheader = motion->loop->preheader;
+        IRInstr *position = ir_terminator(preheader);
+        IRInstr *store = ir_new_instr(motion->function, IR_STORE, IR_TYPE_VOID);
+        store->dst = ir_slot(slot);
+        store->a = clone_expression(motion, instr->dst, preheader, position);
+        ir_insert_before(preheader, position, store);
+
+        if (keyed && motion->hoisted_count < MAX_HOISTED) {
+            strcpy(motion->keys[motion->hoisted_count], key);
+            motion->slots[motion->hoisted_count++] = slot;
+        }
+    }
+
+    IROperand a = instr->a;
+    IROperand b = instr->b;
+    instr->op = IR_LOAD;
+    instr->a = ir_slot(slot);
+    instr->b = ir_none();
+    remove_dead_expression(motion, block, a);
+    remove_dead_expression(motion, block, b);
+}
+
+// Hoist the largest invariant expressions: those read by something that
+// has to stay in the loop
+static void hoist_block(LoopMotion *motion, IRBlock *block) {
+    for (IRInstr *instr = block->first; instr; instr = instr->next) {
+        if (instr->dst.kind == IR_OPERAND_VREG && is_invariant(motion, instr->dst)) continue;
+
+        IROperand operands[2] = { instr->a, instr->b };
+        for (int i = 0; i < 2 + instr->arg_count; i++) {
+            IROperand operand = i < 2 ? operands[i] : instr->args[i - 2];
+            if (operand.kind != IR_OPERAND_VREG || !is_invariant(motion, operand) ||
+                expression_weight(motion, operand) < 2) {
+                continue;
+            }
+            hoist(motion, block, operand.value);
+            // The value now comes from a load: it stays here
+            motion->invariant[operand.value] = false;
+        }
+    }
+}
+
+static void hoist_loop(IRFunction *function, IRLoop *loop, int *temporary_count) {
+    if (!ir_terminator(loop->preheader) || ir_terminator(loop->preheader)->op != IR_JUMP) return;
+
+    LoopMotion motion;
+    memset(&motion, 0, sizeof(motion));
+    motion.function = function;
+    motion.loop = loop;
+    motion.temporary_count = temporary_count;
+    motion.vreg_limit = function->vreg_count + 1;
+    motion.written = (bool *)calloc(function->slot_count + 1, sizeof(bool));
+    motion.definition = (IRInstr **)calloc(motion.vreg_limit, sizeof(IRInstr *));
+    motion.invariant = (bool *)calloc(motion.vreg_limit, sizeof(bool));
+    if (!motion.written || !motion.definition || !motion.invariant) {
+        fprintf(stderr, "Failed to allocate memory for loop-invariant code motion in '%s'\n", function->name);
+    } else {
+        analyze_loop(&motion);
+        for (IRBlock *block = loop->preheader->next; block && block != loop->exit; block = block->next) {
+            if (in_loop(loop, block)) hoist_block(&motion, block);
+        }
+    }
+
+    free(motion.written);
+    free(motion.definition);
+    free(motion.invariant);
+}
+
+void hoist_loop_invariants(IRFunction *function) {
+    // Loops are recorded outermost first: an expression leaves every loop it
+    // is invariant in at once, and what only an inner loop leaves alone is
+    // hoisted when that loop's turn comes
+    int temporary_count = 0;
+    for (IRLoop *loop = function->loops; loop; loop = loop->next) {
+        hoist_loop(function, loop, &temporary_count);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef LOOP_INVARIANT_H
+#define LOOP_INVARIANT_H
+
+#include "ir.h"
+
+// Loop-invariant code motion.
+// An expression in a luloop body or condition whose variables are not
+// written anywhere in the loop is computed once in the preheader, into a
+// temporary slot the loop then loads. Only pure arithmetic moves: lulog,
+// luload and calls stay where they are, in their order, and a division
+// only moves when its divisor is a constant that cannot fault. An
+// expression moves out of all the nested loops it is invariant in.
+void hoist_loop_invariants(IRFunction *function);
+
+#endif // LOOP_INVARIANT_H
@@ -0,0 +1,606 @@
+#include "lower.h"
+#include "range_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Calls may change every allocatable register (ax, bx, cx, dx, si, di)
+#define CALL_REGISTER_NEED 6
+
+// Buckets of the variable lookup (chains stay short for any function size)
+#define BINDING_BUCKETS 64
+
+// A declared variable and its slot, visible until its scope closes
+typedef struct Binding {
+    const char *name;
+    int slot;
+    int depth;                   // Nesting depth of the declaring scope
+    struct Binding *next;        // Next binding in the same bucket (older, so shadowed)
+    struct Binding *previous;    // Binding declared before this one (innermost first)
+} Binding;
+
+// State while lowering one function
+typedef struct {
+    IRFunction *ir;              // Function being built
+    IRBlock *current;            // Block receiving new instructions
+    int loop_depth;              // Number of enclosing luloops
+    IRLoop *loop;                // Innermost enclosing luloop
+    int label_counter;           // Numbers the named blocks of if/luloop statements
+    Binding *buckets[BINDING_BUCKETS];
+    Binding *declared;           // Most recent visible binding
+    Binding *free_bindings;      // Bindings of closed scopes, for reuse
+    int scope_depth;             // Nesting depth of the current scope (0: function)
+    int scope_clock;             // Numbers scope openings and closings in source order
+    int scope_first;             // Number the current scope opened with
+} LowerContext;
+
+static void lower_block(LowerContext *context, ASTNode *block);
+static IROperand lower_expression(LowerContext *context, ASTNode *expr);
+
+// Create a block named "<prefix>_<function>_<number>"
+static IRBlock* new_named_block(LowerContext *context, const char *prefix, int number) {
+    char name[128];
+    snprintf(name, sizeof(name), "%s_%s_%d", prefix, context->ir->name, number);
+    return ir_new_block(context->ir, name);
+}
+
+// Place a block at the end of the layout and continue emitting into it
+static void start_block(LowerContext *context, IRBlock *block) {
+    block->loop_depth = context->loop_depth;
+    ir_append_block(context->ir, block);
+    context->current = block;
+}
+
+// Append an instruction to the current block. Code following a return goes
+// into a fresh (unreachable) block so that every block keeps a single terminator.
+static IRInstr* emit(LowerContext *context, IROpcode op, IRType type) {
+    if (ir_terminator(context->current)) {
+        start_block(context, ir_new_block(context->ir, NULL));
+    }
+    IRInstr *instr = ir_new_instr(context->ir, op, type);
+    ir_append(context->current, instr);
+    return instr;
+}
+
+// End the current block with a jump unless it already ends in a terminator
+static void emit_jump(LowerContext *context, IRBlock *target) {
+    if (ir_terminator(context->current)) return;
+    IRInstr *jump = ir_new_instr(context->ir, IR_JUMP, IR_TYPE_VOID);
+    jump->target = target;
+    ir_append(context->current, jump);
+}
+
+static unsigned int binding_bucket(const char *name) {
+    unsigned int hash = 5381;
+    while (*name) hash = hash * 33 + (unsigned char)*name++;
+    return hash % BINDING_BUCKETS;
+}
+
+// Give a declared variable (or parameter) a new slot, hiding any variable
+// of the same name until the current scope closes
+static int declare_slot(LowerContext *context, const char *name, int offset, bool parameter) {
+    int slot = ir_add_slot(context->ir, name, offset, parameter);
+    if (!parameter) {
+        context->ir->slots[slot].scope_first = context->scope_first;
+    }
+
+    Binding *binding = context->free_bindings;
+    if (binding) {
+        context->free_bindings = binding->previous;
+    } else {
+        binding = (Binding *)arena_alloc(&context->ir->arena, sizeof(Binding));
+    }
+    unsigned int bucket = binding_bucket(name);
+    binding->name = context->ir->slots[slot].name;
+    binding->slot = slot;
+    binding->depth = context->scope_depth;
+    binding->next = context->buckets[bucket];
+    binding->previous = context->declared;
+    context->buckets[bucket] = binding;
+    context->declared = binding;
+    return slot;
+}
+
+// Slot of the innermost visible variable called `name`
+static int variable_slot(LowerContext *context, const char *name) {
+    for (Binding *binding = context->buckets[binding_bucket(name)]; binding; binding = binding->next) {
+        if (strcmp(binding->name, name) == 0) return binding->slot;
+    }
+    // Semantic analysis rejects undeclared variables; keep going regardless
+    return declare_slot(context, name, 0, false);
+}
+
+// Open a scope; returns the number of the enclosing one for close_scope
+static int open_scope(LowerContext *context) {
+    int enclosing = context->scope_first;
+    context->scope_first = ++context->scope_clock;
+    context->scope_depth++;
+    return enclosing;
+}
+
+// Close the current scope: its variables stop being visible and their
+// slots end their lifetime here
+static void close_scope(LowerContext *context, int enclosing) {
+    int last = ++context->scope_clock;
+    while (context->declared && context->declared->depth == context->scope_depth) {
+        Binding *binding = context->declared;
+        context->ir->slots[binding->slot].scope_last = last;
+        // The innermost binding is also first in its bucket
+        context->buckets[binding_bucket(binding->name)] = binding->next;
+        context->declared = binding->previous;
+        binding->previous = context->free_bindings;
+        context->free_bindings = binding;
+    }
+    context->scope_depth--;
+    context->scope_first = enclosing;
+}
+
+// Emit "dst = a op b" into a new virtual register
+static IROperand emit_value(LowerContext *context, IROpcode op, IRType type, IROperand a, IROperand b) {
+    IRInstr *instr = emit(context, op, type);
+    instr->dst = ir_vreg(ir_new_vreg(context->ir));
+    instr->a = a;
+    instr->b = b;
+    return instr->dst;
+}
+
+// Map a comparison operator to its condition
+static bool comparison_condition(const char *op, IRCondition *cond) {
+    if (strcmp(op, "==") == 0) *cond = IR_COND_EQ;
+    else if (strcmp(op, "!=") == 0) *cond = IR_COND_NE;
+    else if (strcmp(op, "<") == 0) *cond = IR_COND_LT;
+    else if (strcmp(op, "<=") == 0) *cond = IR_COND_LE;
+    else if (strcmp(op, ">") == 0) *cond = IR_COND_GT;
+    else if (strcmp(op, ">=") == 0) *cond = IR_COND_GE;
+    else return false;
+    return true;
+}
+
+// Sethi-Ullman labeling: the number of registers needed to evaluate an
+// expression without spilling. A constant right operand is an immediate and
+// needs no register of its own.
+static int label_register_need(ASTNode *expr) {
+    int need = 1;
+
+    if (expr->type == NODE_BINARY_OP && expr->num_children >= 2) {
+        int left = label_register_need(expr->children[0]);
+        int right = label_register_need(expr->children[1]);
+        if (expr->children[1]->type == NODE_NUMBER) right = 0;
+        need = left == right ? left + 1 : (left > right ? left : right);
+
+        // imul and idiv tie up DX:AX
+        const char *op = expr->value;
+        if ((strcmp(op, "*") == 0 || strcmp(op, "/") == 0 || strcmp(op, "%") == 0) && need < 2) {
+            need = 2;
+        }
+    } else if (expr->type == NODE_EXPR && strcmp(expr->value, "=") != 0) {
+        for (int i = 0; i < expr->num_children; i++) {
+            label_register_need(expr->children[i]);
+        }
+        need = CALL_REGISTER_NEED;
+    }
+
+    expr->register_need = need;
+    return need;
+}
+
+// Lower a binary operation
+static IROperand lower_binary_operation(LowerContext *context, ASTNode *binary_op) {
+    const char *op = binary_op->value;
+    ASTNode *left = binary_op->children[0];
+    ASTNode *right = binary_op->children[1];
+
+    // Comparisons whose outcome range analysis has already decided
+    IRCondition cond;
+    bool comparison = comparison_condition(op, &cond);
+    int known_value;
+    if (comparison && range_is_constant(binary_op, &known_value) && expression_is_pure(binary_op)) {
+        return ir_imm(known_value);
+    }
+
+    // "0 - x" is a negation
+    if (strcmp(op, "-") == 0 && left->type == NODE_NUMBER && atoi(left->value) == 0) {
+        return emit_value(context, IR_NEG, IR_TYPE_INT, lower_expression(context, right), ir_none());
+    }
+
+    // Evaluate the operand that needs more registers first, so the other one
+    // is computed while only one value is held. Operands only trade places if
+    // one of them is pure, which keeps luload calls in source order.
+    if (binary_op->register_need == 0) label_register_need(binary_op);
+    int right_need = right->type == NODE_NUMBER ? 0 : right->register_need;
+    bool right_first = right_need > left->register_need &&
+                       (expression_is_pure(left) || expression_is_pure(right));
+
+    IROperand a, b;
+    if (right_first) {
+        b = lower_expression(context, right);
+        a = lower_expression(context, left);
+    } else {
+        a = lower_expression(context, left);
+        b = lower_expression(context, right);
+    }
+
+    if (comparison) {
+        IRInstr *set = emit(context, IR_SET, IR_TYPE_BOOL);
+        set->dst = ir_vreg(ir_new_vreg(context->ir));
+        set->cond = cond;
+        set->a = a;
+        set->b = b;
+        return set->dst;
+    }
+
+    // Division of two non-negative values can use the cheaper unsigned divide
+    bool unsigned_divide = range_is_non_negative(left) && range_is_non_negative(right);
+
+    IROpcode opcode;
+    if (strcmp(op, "+") == 0) opcode = IR_ADD;
+    else if (strcmp(op, "-") == 0) opcode = IR_SUB;
+    else if (strcmp(op, "*") == 0) opcode = IR_MUL;
+    else if (strcmp(op, "/") == 0) opcode = unsigned_divide ? IR_UDIV : IR_DIV;
+    else if (strcmp(op, "%") == 0) opcode = unsigned_divide ? IR_UMOD : IR_MOD;
+    else {
+        fprintf(stderr, "Unsupported binary operator: %s\n", op);
+        return ir_imm(0);
+    }
+
+    return emit_value(context, opcode, IR_TYPE_INT, a, b);
+}
+
+// Lower a function call; arguments are evaluated right to left
+static IROperand lower_function_call(LowerContext *context, ASTNode *call) {
+    IROperand *args = NULL;
+    if (call->num_children > 0) {
+        args = (IROperand *)arena_alloc(&context->ir->arena, sizeof(IROperand) * call->num_children);
+    }
+
+    for (int i = call->num_children - 1; i >= 0; i--) {
+        args[i] = lower_expression(context, call->children[i]);
+    }
+
+    IRInstr *instr = emit(context, IR_CALL, IR_TYPE_INT);
+    instr->dst = ir_vreg(ir_new_vreg(context->ir));
+    instr->callee = arena_strdup(&context->ir->arena, call->value);
+    instr->args = args;
+    instr->arg_count = call->num_children;
+    return instr->dst;
+}
+
+// Lower an expression to an operand (immediates stay immediates)
+static IROperand lower_expression(LowerContext *context, ASTNode *expr) {
+    switch (expr->type) {
+        case NODE_NUMBER:
+            return ir_imm(atoi(expr->value));
+
+        case NODE_STRING:
+            // String values are not supported; they evaluate to 0
+            return ir_imm(0);
+
+        case NODE_IDENTIFIER: {
+            IRInstr *load = emit(context, IR_LOAD, IR_TYPE_INT);
+            load->dst = ir_vreg(ir_new_vreg(context->ir));
+            load->a = ir_slot(variable_slot(context, expr->value));
+            return load->dst;
+        }
+
+        case NODE_LULOAD: {
+            IRInstr *luload = emit(context, IR_LULOAD, IR_TYPE_INT);
+            luload->dst = ir_vreg(ir_new_vreg(context->ir));
+            return luload->dst;
+        }
+
+        case NODE_BINARY_OP:
+            if (expr->num_children < 2) return ir_imm(0);
+            return lower_binary_operation(context, expr);
+
+        case NODE_EXPR:
+            if (strcmp(expr->value, "=") != 0) {
+                return lower_function_call(context, expr);
+            }
+            // Assignments are statements
+            break;
+
+        default:
+            break;
+    }
+
+    fprintf(stderr, "Unexpected expression type: %d\n", expr->type);
+    return ir_imm(0);
+}
+
+// Store a value in a variable's slot
+static void emit_store(LowerContext *context, const char *name, IROperand value) {
+    IRInstr *store = emit(context, IR_STORE, IR_TYPE_VOID);
+    store->dst = ir_slot(variable_slot(context, name));
+    store->a = value;
+}
+
+// Condition expression of an if or luloop (NULL if missing)
+static ASTNode* condition_expression(ASTNode *statement) {
+    ASTNode *condition = find_child(statement, NODE_CONDITION);
+    return condition && condition->num_children > 0 ? condition->children[0] : NULL;
+}
+
+static bool is_logical_operator(const ASTNode *expr, const char *op) {
+    return expr->type == NODE_BINARY_OP && expr->num_children == 2 && strcmp(expr->value, op) == 0;
+}
+
+// Is the expression "not c", which the parser writes as "c == 0"?
+static bool is_negation(const ASTNode *expr) {
+    IRCondition cond;
+    if (!is_logical_operator(expr, "==")) return false;
+    ASTNode *operand = expr->children[0];
+    ASTNode *zero = expr->children[1];
+    return zero->type == NODE_NUMBER && atoi(zero->value) == 0 && operand->type == NODE_BINARY_OP &&
+           (comparison_condition(operand->value, &cond) || is_logical_operator(operand, "and") ||
+            is_logical_operator(operand, "or"));
+}
+
+// Branch to one of two blocks on a condition. Comparisons become a single
+// compare-and-branch, "and"/"or" short-circuit through an extra block and
+// "not" swaps the targets, so no 0/1 value is ever built.
+static void lower_condition(LowerContext *context, ASTNode *cond_expr,
+                            IRBlock *true_block, IRBlock *false_block) {
+    if (!cond_expr) {
+        emit_jump(context, true_block);
+        return;
+    }
+
+    // Conditions whose outcome range analysis has already decided
+    int known_value;
+    if (expression_is_pure(cond_expr) && range_is_constant(cond_expr, &known_value)) {
+        emit_jump(context, known_value != 0 ? true_block : false_block);
+        return;
+    }
+
+    if (is_logical_operator(cond_expr, "and") || is_logical_operator(cond_expr, "or")) {
+        bool is_and = is_logical_operator(cond_expr, "and");
+        IRBlock *second = ir_new_block(context->ir, NULL);
+        lower_condition(context, cond_expr->children[0], is_and ? second : true_block,
+                        is_and ? false_block : second);
+        start_block(context, second);
+        lower_condition(context, cond_expr->children[1], true_block, false_block);
+        return;
+    }
+
+    if (is_negation(cond_expr)) {
+        lower_condition(context, cond_expr->children[0], false_block, true_block);
+        return;
+    }
+
+    IRInstr *branch;
+    IRCondition cond;
+    if (cond_expr->type == NODE_BINARY_OP && cond_expr->num_children == 2 &&
+        comparison_condition(cond_expr->value, &cond)) {
+        IROperand a = lower_expression(context, cond_expr->children[0]);
+        IROperand b = lower_expression(context, cond_expr->children[1]);
+        branch = emit(context, IR_BRANCH, IR_TYPE_VOID);
+        branch->cond = cond;
+        branch->a = a;
+        branch->b = b;
+    } else {
+        // Any other value: true when non-zero
+        IROperand value = lower_expression(context, cond_expr);
+        if (value.kind == IR_OPERAND_IMM) {
+            emit_jump(context, value.value != 0 ? true_block : false_block);
+            return;
+        }
+        branch = emit(context, IR_BRANCH, IR_TYPE_VOID);
+        branch->cond = IR_COND_NE;
+        branch->a = value;
+        branch->b = ir_imm(0);
+    }
+    branch->target = true_block;
+    branch->else_target = false_block;
+}
+
+// Lower an if statement
+static void lower_if_statement(LowerContext *context, ASTNode *if_stmt) {
+    int number = context->label_counter++;
+    ASTNode *if_block = find_child(if_stmt, NODE_BLOCK);
+    ASTNode *else_node = find_child(if_stmt, NODE_ELSE);
+    ASTNode *else_block = else_node ? find_child(else_node, NODE_BLOCK) : NULL;
+
+    IRBlock *then_target = new_named_block(context, "if", number);
+    IRBlock *else_target = else_block ? new_named_block(context, "else", number) : NULL;
+    IRBlock *end_target = new_named_block(context, "endif", number);
+
+    lower_condition(context, condition_expression(if_stmt), then_target,
+                    else_target ? else_target : end_target);
+
+    start_block(context, then_target);
+    if (if_block) lower_block(context, if_block);
+    emit_jump(context, end_target);
+
+    if (else_target) {
+        start_block(context, else_target);
+        lower_block(context, else_block);
+        emit_jump(context, end_target);
+    }
+
+    start_block(context, end_target);
+}
+
+// Lower a luloop: jump to the test, body, test branching back to the body
+static void lower_luloop_statement(LowerContext *context, ASTNode *luloop) {
+    ASTNode *cond_expr = condition_expression(luloop);
+    ASTNode *body = find_child(luloop, NODE_BLOCK);
+
+    // A loop whose condition range analysis proved false never runs
+    int value;
+    if (cond_expr && expression_is_pure(cond_expr) && range_is_constant(cond_expr, &value) && value == 0) {
+        return;
+    }
+
+    int number = context->label_counter++;
+    IRBlock *start = new_named_block(context, "luloop_start", number);
+    IRBlock *test = new_named_block(context, "luloop_test", number);
+    IRBlock *end = new_named_block(context, "luloop_end", number);
+
+    IRLoop *loop = ir_new_loop(context->ir);
+    loop->preheader = context->current;
+    loop->body = start;
+    loop->test = test;
+    loop->exit = end;
+    loop->parent = context->loop;
+    loop->depth = context->loop_depth + 1;
+
+    emit_jump(context, test);
+    // The jump may have had to open a new block after a return
+    loop->preheader = context->current;
+
+    IRLoop *saved_loop = context->loop;
+    context->loop = loop;
+    context->loop_depth++;
+
+    start_block(context, start);
+    if (body) lower_block(context, body);
+    emit_jump(context, test);
+
+    start_block(context, test);
+    lower_condition(context, cond_expr, start, end);
+
+    context->loop_depth--;
+    context->loop = saved_loop;
+
+    start_block(context, end);
+}
+
+// Lower a single statement
+static void lower_statement(LowerContext *context, ASTNode *stmt) {
+    switch (stmt->type) {
+        case NODE_VAR_DECL: {
+            // The initializer still sees what the new variable hides
+            ASTNode *initializer = NULL;
+            for (int i = 0; i < stmt->num_children; i++) {
+                if (stmt->children[i]->type != NODE_TYPE) {
+                    initializer = stmt->children[i];
+                    break;
+                }
+            }
+            IROperand value = initializer ? lower_expression(context, initializer) : ir_none();
+            int slot = declare_slot(context, stmt->value, 0, false);
+            if (initializer) {
+                IRInstr *store = emit(context, IR_STORE, IR_TYPE_VOID);
+                store->dst = ir_slot(slot);
+                store->a = value;
+            }
+            break;
+        }
+
+        case NODE_EXPR:
+            if (strcmp(stmt->value, "=") == 0) {
+                if (stmt->num_children < 2 || stmt->children[0]->type != NODE_IDENTIFIER) {
+                    fprintf(stderr, "Left side of assignment must be a variable\n");
+                    break;
+                }
+                emit_store(context, stmt->children[0]->value, lower_expression(context, stmt->children[1]));
+            } else {
+                lower_function_call(context, stmt);
+            }
+            break;
+
+        case NODE_RETURN: {
+            IROperand value = stmt->num_children > 0 ? lower_expression(context, stmt->children[0]) : ir_none();
+            IRInstr *ret = emit(context, IR_RET, IR_TYPE_VOID);
+            ret->a = value;
+            break;
+        }
+
+        case NODE_IF:
+            lower_if_statement(context, stmt);
+            break;
+
+        case NODE_LULOOP:
+            lower_luloop_statement(context, stmt);
+            break;
+
+        case NODE_LULOG: {
+            ASTNode *expr = stmt->num_children > 0 ? stmt->children[0] : NULL;
+            IROperand value = expr ? lower_expression(context, expr) : ir_imm(0);
+            IRInstr *lulog = emit(context, IR_LULOG, IR_TYPE_VOID);
+            lulog->a = value;
+            // Values proven non-negative skip the sign handling
+            if (expr && expr->type != NODE_STRING && range_is_non_negative(expr)) {
+                lulog->flags |= IR_FLAG_NON_NEGATIVE;
+            }
+            break;
+        }
+
+        case NODE_LULOAD:
+            lower_expression(context, stmt);
+            break;
+
+        case NODE_BLOCK:
+            lower_block(context, stmt);
+            break;
+
+        default:
+            fprintf(stderr, "Unexpected node type in block: %d\n", stmt->type);
+            break;
+    }
+}
+
+// Lower the statements of a block
+static void lower_block(LowerContext *context, ASTNode *block) {
+    // A function body shares the function scope with the parameters
+    bool scoped = !is_function_body(block);
+    int enclosing = scoped ? open_scope(context) : 0;
+    for (int i = 0; i < block->num_children; i++) {
+        lower_statement(context, block->children[i]);
+    }
+    if (scoped) close_scope(context, enclosing);
+}
+
+// Lower a semantically checked function to IR
+IRFunction* lower_function(ASTNode *function) {
+    if (!function || function->type != NODE_FUNCTION) return NULL;
+
+    IRFunction *ir = create_ir_function(function->value);
+    if (!ir) return NULL;
+
+    LowerContext context;
+    memset(&context, 0, sizeof(context));
+    context.ir = ir;
+
+    start_block(&context, ir_new_block(ir, NULL));
+
+    // The first parameters arrive in registers and are stored into locals
+    // on entry, once all of them are taken; the caller pushes the rest, the
+    // first of those ends up at [bp+4]
+    ASTNode *params = find_child(function, NODE_PARAM);
+    int arguments[IR_REGISTER_ARGUMENTS];
+    IROperand values[IR_REGISTER_ARGUMENTS];
+    int count = 0;
+    int offset = 4;
+    for (int i = 0; params && i < params->num_children; i++) {
+        ASTNode *param = params->children[i];
+        if (param->type != NODE_PARAM && param->type != NODE_VAR_DECL) continue;
+        if (count < IR_REGISTER_ARGUMENTS) {
+            arguments[count] = declare_slot(&context, param->value, 0, false);
+            IRInstr *arg = emit(&context, IR_ARG, IR_TYPE_INT);
+            arg->dst = ir_vreg(ir_new_vreg(ir));
+            arg->a = ir_imm(count);
+            values[count++] = arg->dst;
+        } else {
+            declare_slot(&context, param->value, offset, true);
+            offset += 2;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        IRInstr *store = emit(&context, IR_STORE, IR_TYPE_VOID);
+        store->dst = ir_slot(arguments[i]);
+        store->a = values[i];
+    }
+
+    ASTNode *body = find_child(function, NODE_BLOCK);
+    if (body) lower_block(&context, body);
+
+    // Falling off the end returns
+    if (!ir_terminator(context.current)) {
+        IRInstr *ret = emit(&context, IR_RET, IR_TYPE_VOID);
+        ret->a = ir_none();
+    }
+
+    // The locals get their offsets from the frame layout (see frame.h)
+    return ir;
+}
@@ -0,0 +1,14 @@
+#ifndef LOWER_H
+#define LOWER_H
+
+#include "parser.h"
+#include "ir.h"
+
+// Lower a semantically checked function to IR.
+// Range analysis results on the AST are used to pick unsigned division,
+// the unsigned lulog entry and to drop branches whose outcome is known.
+// Every declaration gets a slot of its own, recording the scopes it lives
+// in; the slots get their offsets later, from the frame layout.
+IRFunction* lower_function(ASTNode *function);
+
+#endif // LOWER_H
@@ -86,6 +86,10 @@ ASTNode* create_node(NodeType type, const char* value) {
     node->capacity = 10;  // Initial capacity
     node->children = malloc(node->capacity * sizeof(ASTNode*));
     node->parent = NULL;
+    node->range.min = 0;
+    node->range.max = 0;
+    node->range.known = false;
+    node->register_need = 0;
     
     if (!node->children) {
         free(node->value);
@@ -127,6 +131,30 @@ void free_node(ASTNode* node) {
     free(node);
 }
 
+// Find the first child of the given type
+ASTNode* find_child(ASTNode* node, NodeType type) {
+    if (!node) return NULL;
+    
+    for (int i = 0; i < node->num_children; i++) {
+        if (node->children[i]->type == type) {
+            return node->children[i];
+        }
+    }
+    return NULL;
+}
+
+// Get the declared type of a function, variable or parameter from its NODE_TYPE child
+const char* get_declared_type(ASTNode* node, const char* default_type) {
+    ASTNode* type = find_child(node, NODE_TYPE);
+    return type ? type->value : default_type;
+}
+
+// A function body shares the function's scope instead of opening a new one
+bool is_function_body(ASTNode* block) {
+    return block && block->type == NODE_BLOCK &&
+           block->parent && block->parent->type == NODE_FUNCTION;
+}
+
 // Print an AST for debugging
 void print_ast(ASTNode* node, int indent) {
     if (!node) return;
@@ -260,6 +288,7 @@ ASTNode* parse_if_statement(Parser* parser);
 ASTNode* parse_luloop_statement(Parser* parser);
 ASTNode* parse_lulog_statement(Parser* parser);
 ASTNode* parse_luload_statement(Parser* parser);
+static ASTNode* parse_call(Parser* parser, const char* name);
 
 // Parse a program
 ASTNode* parse_program(Parser* parser) {
@@ -758,11 +787,29 @@ ASTNode* parse_statement(Parser* parser) {
         return parse_luload_statement(parser);
     }
     
-    // Assignment statement
+    // Assignment statement or function call
     if (is_token_type(parser, IDENTIFIER_TOKEN)) {
         ASTNode* id = create_node(NODE_IDENTIFIER, current_token(parser)->value);
         advance(parser);
         
+        if (is_token_type(parser, SEPARATOR_TOKEN) && strcmp(current_token(parser)->value, "(") == 0) {
+            ASTNode* call = parse_call(parser, id->value);
+            free_node(id);
+            if (!call) return NULL;
+            
+            // Expect semicolon
+            if (!is_token_type(parser, SEPARATOR_TOKEN) ||
+                strcmp(current_token(parser)->value, ";") != 0) {
+                fprintf(stderr, "Expected ';' after function call\n");
+                fprintf(stderr, "FATAL: Syntax error in statement - semicolon might be missing\n");
+                free_node(call);
+                exit(1); // Immediate exit on syntax error
+                return NULL;
+            }
+            advance(parser);
+            return call;
+        }
+        
         if (is_token_type(parser, EQUAL_TOKEN)) {
             #ifdef DEBUG_PARSER
             printf("DEBUG: Found assignment with '=' token\n");
@@ -906,63 +953,170 @@ ASTNode* parse_return(Parser* parser) {
     return ret;
 }
 
-// Parse a condition expression (for if statements and luloop)
+static bool is_logical_op(Parser* parser, const char* op) {
+    return is_token_type(parser, LOGICAL_OP_TOKEN) && strcmp(current_token(parser)->value, op) == 0;
+}
+
+static bool is_separator(Parser* parser, const char* separator) {
+    return is_token_type(parser, SEPARATOR_TOKEN) && strcmp(current_token(parser)->value, separator) == 0;
+}
+
+static ASTNode* parse_logical_or(Parser* parser);
+
+// Parse the arguments of a call to `name`, starting at its '('. The call is
+// a NODE_EXPR named after the function with one child per argument.
+static ASTNode* parse_call(Parser* parser, const char* name) {
+    ASTNode* call = create_node(NODE_EXPR, name);
+    advance(parser); // Consume '('
+    
+    if (is_separator(parser, ")")) {
+        advance(parser);
+        return call;
+    }
+    
+    while (true) {
+        ASTNode* argument = parse_expression(parser);
+        if (!argument) {
+            fprintf(stderr, "Failed to parse argument of '%s'\n", name);
+            free_node(call);
+            return NULL;
+        }
+        add_child(call, argument);
+        
+        if (is_separator(parser, ",")) {
+            advance(parser);
+            continue;
+        }
+        if (is_separator(parser, ")")) {
+            advance(parser);
+            return call;
+        }
+        
+        fprintf(stderr, "Expected ',' or ')' in arguments of '%s'\n", name);
+        free_node(call);
+        return NULL;
+    }
+}
+
+// Parse a comparison: identifier or number, operator, identifier or number
+static ASTNode* parse_comparison(Parser* parser) {
+    // Left side of condition
+    if (!is_token_type(parser, IDENTIFIER_TOKEN) && !is_token_type(parser, NUMBER_TOKEN)) {
+        fprintf(stderr, "Expected identifier as first part of condition\n");
+        return NULL;
+    }
+    ASTNode* left = create_node(is_token_type(parser, NUMBER_TOKEN) ? NODE_NUMBER : NODE_IDENTIFIER,
+                                current_token(parser)->value);
+    advance(parser);
+
+    // Comparison operator
+    if (!is_token_type(parser, EQUAL_TOKEN) && !is_token_type(parser, OPERATOR_TOKEN)) {
+        fprintf(stderr, "Expected comparison operator in condition\n");
+        free_node(left);
+        return NULL;
+    }
+    ASTNode* op = create_node(NODE_BINARY_OP, current_token(parser)->value);
+    add_child(op, left);
+    advance(parser);
+
+    // Right side of condition
+    ASTNode* right;
+    if (is_token_type(parser, NUMBER_TOKEN)) {
+        right = create_node(NODE_NUMBER, current_token(parser)->value);
+        advance(parser);
+    } else if (is_token_type(parser, IDENTIFIER_TOKEN)) {
+        right = create_node(NODE_IDENTIFIER, current_token(parser)->value);
+        advance(parser);
+    } else {
+        fprintf(stderr, "Expected expression after comparison operator\n");
+        free_node(op);
+        return NULL;
+    }
+
+    add_child(op, right);
+    return op;
+}
+
+// Parse "not" conditions and parenthesized conditions.
+// "not c" is represented as "c == 0".
+static ASTNode* parse_logical_not(Parser* parser) {
+    if (is_logical_op(parser, "not")) {
+        advance(parser);
+        ASTNode* operand = parse_logical_not(parser);
+        if (!operand) return NULL;
+
+        ASTNode* op = create_node(NODE_BINARY_OP, "==");
+        add_child(op, operand);
+        add_child(op, create_node(NODE_NUMBER, "0"));
+        return op;
+    }
+
+    if (is_separator(parser, "(")) {
+        advance(parser);
+        ASTNode* inner = parse_logical_or(parser);
+        if (!inner) return NULL;
+
+        if (!is_separator(parser, ")")) {
+            fprintf(stderr, "Expected ')' in condition\n");
+            free_node(inner);
+            return NULL;
+        }
+        advance(parser);
+        return inner;
+    }
+
+    return parse_comparison(parser);
+}
+
+// Parse a chain of one logical operator ("and" binds tighter than "or")
+static ASTNode* parse_logical_chain(Parser* parser, const char* logical_op,
+                                    ASTNode* (*parse_operand)(Parser*)) {
+    ASTNode* left = parse_operand(parser);
+    if (!left) return NULL;
+
+    while (is_logical_op(parser, logical_op)) {
+        advance(parser);
+        ASTNode* right = parse_operand(parser);
+        if (!right) {
+            free_node(left);
+            return NULL;
+        }
+
+        ASTNode* op = create_node(NODE_BINARY_OP, logical_op);
+        add_child(op, left);
+        add_child(op, right);
+        left = op;
+    }
+    return left;
+}
+
+static ASTNode* parse_logical_and(Parser* parser) {
+    return parse_logical_chain(parser, "and", parse_logical_not);
+}
+
+static ASTNode* parse_logical_or(Parser* parser) {
+    return parse_logical_chain(parser, "or", parse_logical_and);
+}
+
+// Parse a condition expression (for if statements and luloop):
+// comparisons combined with "and", "or", "not" and parentheses
 ASTNode* parse_condition(Parser* parser) {
     // Open parenthesis
-    if (!is_token_type(parser, SEPARATOR_TOKEN) || 
-        strcmp(current_token(parser)->value, "(") != 0) {
+    if (!is_separator(parser, "(")) {
         fprintf(stderr, "Expected '(' after if/luloop\n");
         return NULL;
     }
     advance(parser);
     
+    ASTNode* expr = parse_logical_or(parser);
+    if (!expr) return NULL;
+
     // Create condition node
     ASTNode* condition = create_node(NODE_CONDITION, NULL);
-    
-    // Left side of condition
-    if (is_token_type(parser, IDENTIFIER_TOKEN)) {
-        ASTNode* left = create_node(NODE_IDENTIFIER, current_token(parser)->value);
-        add_child(condition, left);
-        advance(parser);
-        
-        // Comparison operator
-        if (is_token_type(parser, EQUAL_TOKEN) || is_token_type(parser, OPERATOR_TOKEN)) {
-            // Create a binary op node for the comparison
-            ASTNode* op = create_node(NODE_BINARY_OP, current_token(parser)->value);
-            add_child(op, left);
-            advance(parser);
-            
-            // Right side of condition
-            ASTNode* right;
-            if (is_token_type(parser, NUMBER_TOKEN)) {
-                right = create_node(NODE_NUMBER, current_token(parser)->value);
-                advance(parser);
-            } else if (is_token_type(parser, IDENTIFIER_TOKEN)) {
-                right = create_node(NODE_IDENTIFIER, current_token(parser)->value);
-                advance(parser);
-            } else {
-                fprintf(stderr, "Expected expression after comparison operator\n");
-                free_node(condition);
-                return NULL;
-            }
-            
-            add_child(op, right);
-            // Replace the direct left child with the operator node that contains both operands
-            condition->children[0] = op;
-        } else {
-            fprintf(stderr, "Expected comparison operator in condition\n");
-            free_node(condition);
-            return NULL;
-        }
-    } else {
-        fprintf(stderr, "Expected identifier as first part of condition\n");
-        free_node(condition);
-        return NULL;
-    }
+    add_child(condition, expr);
     
     // Close parenthesis
-    if (!is_token_type(parser, SEPARATOR_TOKEN) || 
-        strcmp(current_token(parser)->value, ")") != 0) {
+    if (!is_separator(parser, ")")) {
         fprintf(stderr, "Expected ')' after condition\n");
         free_node(condition);
         return NULL;
@@ -1091,12 +1245,17 @@ ASTNode* parse_expression(Parser* parser) {
         printf("DEBUG: Found identifier in expression: %s\n", current_token(parser)->value);
         #endif
         
-        // Save the identifier value for potential function call
         const char* identifier_value = current_token(parser)->value;
-        ASTNode* id = create_node(NODE_IDENTIFIER, identifier_value);
+        ASTNode* id;
         advance(parser);
         
-        // Not handling function calls in this version
+        // An identifier followed by '(' calls a function
+        if (is_separator(parser, "(")) {
+            id = parse_call(parser, identifier_value);
+            if (!id) return NULL;
+        } else {
+            id = create_node(NODE_IDENTIFIER, identifier_value);
+        }
 
         if (is_token_type(parser, OPERATOR_TOKEN)) {
             #ifdef DEBUG_PARSER
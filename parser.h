@@ -28,6 +28,13 @@ typedef enum {
     NODE_CONDITION // Condition expression
 } NodeType;
 
+// Value range of an expression (filled in by range analysis)
+typedef struct {
+    int min;                 // Smallest possible 16-bit signed value
+    int max;                 // Largest possible 16-bit signed value
+    bool known;              // False until range analysis has visited the node
+} ValueRange;
+
 // AST node
 typedef struct ASTNode {
     NodeType type;
@@ -36,6 +43,8 @@ typedef struct ASTNode {
     int num_children;
     int capacity;
     struct ASTNode* parent;  // Parent node for scope tracking
+    ValueRange range;        // Value range of the expression (if analyzed)
+    int register_need;       // Registers needed to evaluate the expression (0 until labeled)
 } ASTNode;
 
 // Parser
@@ -55,6 +64,11 @@ void add_child(ASTNode* parent, ASTNode* child);
 void free_node(ASTNode* node);
 void print_ast(ASTNode* node, int indent);
 
+// AST queries shared by the later passes
+ASTNode* find_child(ASTNode* node, NodeType type);
+const char* get_declared_type(ASTNode* node, const char* default_type);
+bool is_function_body(ASTNode* block);
+
 // Parser management
 Parser* create_parser(Token* tokens);
 void free_parser(Parser* parser);
@@ -0,0 +1,311 @@
+#include "peephole.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PEEPHOLE_WINDOW 4          // Largest window any rule looks at
+#define PEEPHOLE_MAX_PASSES 16     // Stop even if rules keep enabling each other
+#define PEEPHOLE_MAX_OPERAND 64
+
+typedef enum {
+    LINE_INSTRUCTION,
+    LINE_LABEL,
+    LINE_COMMENT,
+    LINE_OTHER                     // Blank lines and anything not understood
+} LineKind;
+
+// One line of assembly
+typedef struct {
+    LineKind kind;
+    const char *text;              // Original text (without the newline)
+    size_t length;
+    int indent;                    // Leading spaces of an instruction
+    bool deleted;
+    bool modified;                 // Rebuild from mnemonic and operands
+    char mnemonic[16];
+    char operands[2][PEEPHOLE_MAX_OPERAND];
+    int operand_count;
+} PeepholeLine;
+
+// A rule looks at the first `count` lines of a window and rewrites them
+typedef bool (*PeepholeRuleFunction)(PeepholeLine **window, int count);
+
+typedef struct {
+    const char *name;
+    int size;                      // Lines needed before the rule is tried
+    PeepholeRuleFunction apply;
+} PeepholeRule;
+
+// Line classification
+
+static bool is_instruction(const PeepholeLine *line, const char *mnemonic) {
+    return line->kind == LINE_INSTRUCTION && strcmp(line->mnemonic, mnemonic) == 0;
+}
+
+static bool is_register(const char *operand) {
+    static const char *registers[] = { "ax", "bx", "cx", "dx", "si", "di", "bp", "sp" };
+    for (size_t i = 0; i < sizeof(registers) / sizeof(registers[0]); i++) {
+        if (strcmp(operand, registers[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool is_memory(const char *operand) {
+    return strchr(operand, '[') != NULL;
+}
+
+// Memory operand without its size prefix ("word ptr [bp-2]" -> "[bp-2]")
+static const char* memory_address(const char *operand) {
+    const char *bracket = strchr(operand, '[');
+    return bracket ? bracket : operand;
+}
+
+// Line editing
+
+static void delete_line(PeepholeLine *line) {
+    line->deleted = true;
+}
+
+static void set_instruction(PeepholeLine *line, const char *mnemonic, const char *first, const char *second) {
+    char operands[2][PEEPHOLE_MAX_OPERAND];
+    // The operands may point into this line
+    snprintf(operands[0], sizeof(operands[0]), "%s", first ? first : "");
+    snprintf(operands[1], sizeof(operands[1]), "%s", second ? second : "");
+
+    snprintf(line->mnemonic, sizeof(line->mnemonic), "%s", mnemonic);
+    memcpy(line->operands, operands, sizeof(operands));
+    line->operand_count = second ? 2 : first ? 1 : 0;
+    line->modified = true;
+}
+
+// Rules
+
+// mov M, R / mov R2, M  ->  mov M, R / mov R2, R (dropped if R2 is R)
+static bool rule_store_load(PeepholeLine **window, int count) {
+    (void)count;
+    if (!is_instruction(window[0], "mov") || !is_instruction(window[1], "mov")) return false;
+
+    const char *memory = window[0]->operands[0];
+    const char *value = window[0]->operands[1];
+    const char *target = window[1]->operands[0];
+    if (!is_memory(memory) || is_memory(value) || !is_register(target)) return false;
+    if (strcmp(memory_address(memory), memory_address(window[1]->operands[1])) != 0) return false;
+
+    if (strcmp(value, target) == 0) {
+        delete_line(window[1]);
+    } else {
+        set_instruction(window[1], "mov", target, value);
+    }
+    return true;
+}
+
+// Flags are dead after window[0] if a later instruction in the window
+// overwrites them before anything can read them
+static bool flags_dead_after(PeepholeLine **window, int count) {
+    static const char *transparent[] = { "mov", "push", "pop", "lea", "cwd", "xchg", "inc", "dec" };
+    static const char *writers[] = {
+        "cmp", "test", "add", "sub", "and", "or", "xor", "neg",
+        "mul", "imul", "div", "idiv", "call", "ret", "int"
+    };
+
+    for (int i = 1; i < count; i++) {
+        const PeepholeLine *line = window[i];
+        if (line->kind != LINE_INSTRUCTION) return false;
+
+        bool known = false;
+        for (size_t j = 0; j < sizeof(writers) / sizeof(writers[0]); j++) {
+            if (strcmp(line->mnemonic, writers[j]) == 0) return true;
+        }
+        for (size_t j = 0; j < sizeof(transparent) / sizeof(transparent[0]); j++) {
+            if (strcmp(line->mnemonic, transparent[j]) == 0) known = true;
+        }
+        // Jumps and anything unknown may read the flags
+        if (!known) return false;
+    }
+    return false;
+}
+
+// mov R, 0  ->  xor R, R when the flags are dead
+static bool rule_zero_register(PeepholeLine **window, int count) {
+    if (!is_instruction(window[0], "mov")) return false;
+
+    const char *reg = window[0]->operands[0];
+    if (!is_register(reg) || strcmp(reg, "sp") == 0 || strcmp(window[0]->operands[1], "0") != 0) return false;
+    if (!flags_dead_after(window, count)) return false;
+
+    set_instruction(window[0], "xor", reg, reg);
+    return true;
+}
+
+// jmp/jcc L directly followed by label L  ->  nothing
+static bool rule_jump_to_next(PeepholeLine **window, int count) {
+    const PeepholeLine *jump = window[0];
+    if (jump->kind != LINE_INSTRUCTION || jump->mnemonic[0] != 'j' || jump->operand_count != 1) return false;
+
+    const char *target = jump->operands[0];
+    size_t target_length = strlen(target);
+    for (int i = 1; i < count && window[i]->kind == LINE_LABEL; i++) {
+        // Label lines are "name:"
+        if (window[i]->length == target_length + 1 && strncmp(window[i]->text, target, target_length) == 0) {
+            delete_line(window[0]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Rules in the order they are tried at each position
+static const PeepholeRule peephole_rules[] = {
+    { "jump-to-next",     2, rule_jump_to_next },
+    { "store-load",       2, rule_store_load },
+    { "zero-register",    2, rule_zero_register }
+};
+
+// Parsing
+
+static void parse_line(PeepholeLine *line, const char *text, size_t length) {
+    memset(line, 0, sizeof(*line));
+    line->text = text;
+    line->length = length;
+    line->kind = LINE_OTHER;
+
+    size_t i = 0;
+    while (i < length && text[i] == ' ') i++;
+    if (i == length) return;
+
+    if (text[i] == ';') {
+        line->kind = LINE_COMMENT;
+        return;
+    }
+    if (i == 0) {
+        if (text[length - 1] == ':') line->kind = LINE_LABEL;
+        return;
+    }
+
+    line->indent = (int)i;
+
+    // Mnemonic
+    size_t start = i;
+    while (i < length && !isspace((unsigned char)text[i])) i++;
+    if (i - start >= sizeof(line->mnemonic)) return;
+    memcpy(line->mnemonic, text + start, i - start);
+    line->mnemonic[i - start] = '\0';
+
+    // Operands, ignoring a trailing comment
+    size_t end = length;
+    for (size_t j = i; j < length; j++) {
+        if (text[j] == ';' || text[j] == '\'') {
+            // Leave lines with comments or quoted characters alone
+            return;
+        }
+    }
+
+    while (i < end) {
+        while (i < end && text[i] == ' ') i++;
+        if (i == end) break;
+        if (line->operand_count == 2) return;
+
+        size_t operand_start = i;
+        while (i < end && text[i] != ',') i++;
+        size_t operand_end = i;
+        while (operand_end > operand_start && text[operand_end - 1] == ' ') operand_end--;
+        if (operand_end - operand_start >= PEEPHOLE_MAX_OPERAND) return;
+
+        char *operand = line->operands[line->operand_count++];
+        memcpy(operand, text + operand_start, operand_end - operand_start);
+        operand[operand_end - operand_start] = '\0';
+        if (i < end) i++;   // Skip the comma
+    }
+
+    line->kind = LINE_INSTRUCTION;
+}
+
+static void append_line(StringBuffer *output, const PeepholeLine *line) {
+    if (!line->modified) {
+        buffer_append(output, line->text, line->length);
+        buffer_append(output, "\n", 1);
+        return;
+    }
+
+    for (int i = 0; i < line->indent; i++) {
+        buffer_append(output, " ", 1);
+    }
+    buffer_append(output, line->mnemonic, strlen(line->mnemonic));
+    for (int i = 0; i < line->operand_count; i++) {
+        buffer_append(output, i == 0 ? " " : ", ", i == 0 ? 1 : 2);
+        buffer_append(output, line->operands[i], strlen(line->operands[i]));
+    }
+    buffer_append(output, "\n", 1);
+}
+
+// Collect up to PEEPHOLE_WINDOW live lines starting at `start`, skipping comments
+static int build_window(PeepholeLine *lines, int line_count, int start, PeepholeLine **window) {
+    int count = 0;
+    for (int i = start; i < line_count && count < PEEPHOLE_WINDOW; i++) {
+        if (lines[i].deleted || lines[i].kind == LINE_COMMENT) continue;
+        if (lines[i].kind == LINE_OTHER) break;
+        window[count++] = &lines[i];
+    }
+    return count;
+}
+
+// Optimize the function text in `code` in place
+int peephole_optimize(StringBuffer *code) {
+    if (!code || code->length == 0) return 0;
+
+    int line_count = 0;
+    for (size_t i = 0; i < code->length; i++) {
+        if (code->data[i] == '\n') line_count++;
+    }
+    if (code->data[code->length - 1] != '\n') line_count++;
+
+    PeepholeLine *lines = (PeepholeLine *)malloc(sizeof(PeepholeLine) * line_count);
+    if (!lines) {
+        fprintf(stderr, "Failed to allocate memory for peephole optimization\n");
+        return 0;
+    }
+
+    int n = 0;
+    size_t line_start = 0;
+    for (size_t i = 0; i <= code->length && n < line_count; i++) {
+        if (i == code->length || code->data[i] == '\n') {
+            parse_line(&lines[n++], code->data + line_start, i - line_start);
+            line_start = i + 1;
+        }
+    }
+
+    int rewrites = 0;
+    for (int pass = 0; pass < PEEPHOLE_MAX_PASSES; pass++) {
+        int pass_rewrites = 0;
+        for (int i = 0; i < line_count; i++) {
+            if (lines[i].deleted || lines[i].kind != LINE_INSTRUCTION) continue;
+
+            PeepholeLine *window[PEEPHOLE_WINDOW];
+            int count = build_window(lines, line_count, i, window);
+            for (size_t r = 0; r < sizeof(peephole_rules) / sizeof(peephole_rules[0]); r++) {
+                if (count >= peephole_rules[r].size && peephole_rules[r].apply(window, count)) {
+                    pass_rewrites++;
+                    break;
+                }
+            }
+        }
+        rewrites += pass_rewrites;
+        if (pass_rewrites == 0) break;
+    }
+
+    if (rewrites > 0) {
+        StringBuffer output;
+        init_string_buffer(&output);
+        buffer_reserve(&output, code->length);
+        for (int i = 0; i < line_count; i++) {
+            if (!lines[i].deleted) append_line(&output, &lines[i]);
+        }
+        free_string_buffer(code);
+        *code = output;
+    }
+
+    free(lines);
+    return rewrites;
+}
@@ -0,0 +1,16 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "string_buffer.h"
+
+// Peephole optimizer over emitted 8086 assembly.
+// Slides a small window over the instructions of one function and applies
+// the rules of a table until none matches any more. Comments are skipped
+// when building a window; labels end it, except for the jump rule that
+// looks at them.
+
+// Optimize the function text in `code` in place.
+// Returns the number of rewrites made.
+int peephole_optimize(StringBuffer *code);
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,694 @@
+#include "range_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Loop iterations before changing bounds are widened to the type limits
+#define RANGE_WIDEN_AFTER 3
+// Loop iterations after which every variable is given the full range
+#define RANGE_GIVE_UP_AFTER 16
+
+// Range of every variable at one program point. Variables are told apart
+// by their declaration, so a shadowing variable gets a range of its own.
+typedef struct {
+    const ASTNode **variables;   // Declaration (or parameter) node of each variable
+    ValueRange *ranges;          // Current range of each variable
+    int count;
+    int capacity;
+    bool reachable;              // False after a return or on an impossible branch
+} RangeEnv;
+
+// A declared name and the declaration it stands for until its block ends
+typedef struct {
+    const char *name;
+    const ASTNode *declaration;
+} RangeBinding;
+
+// State of the analysis for one function
+typedef struct {
+    SemanticContext *context;
+    RangeBinding *bindings;      // Visible declarations, innermost last
+    int binding_count;
+    int binding_capacity;
+    bool report_errors;          // Disabled while a loop is iterated to its fixed point
+    bool success;
+} RangeAnalyzer;
+
+static ValueRange eval_expression(RangeAnalyzer *analyzer, ASTNode *expr, RangeEnv *env);
+static void analyze_statement(RangeAnalyzer *analyzer, ASTNode *stmt, RangeEnv *env);
+static void analyze_block_ranges(RangeAnalyzer *analyzer, ASTNode *block, RangeEnv *env);
+
+// Range helpers
+
+static ValueRange make_range(int min, int max) {
+    ValueRange range;
+    range.min = min;
+    range.max = max;
+    range.known = true;
+    return range;
+}
+
+static ValueRange full_range(void) {
+    return make_range(RANGE_INT_MIN, RANGE_INT_MAX);
+}
+
+// Build a range from exact bounds, falling back to the full range when the
+// result does not fit in 16 bits (the value wraps around at runtime)
+static ValueRange checked_range(long min, long max) {
+    if (min < RANGE_INT_MIN || max > RANGE_INT_MAX) {
+        return full_range();
+    }
+    return make_range((int)min, (int)max);
+}
+
+static ValueRange join_ranges(ValueRange a, ValueRange b) {
+    return make_range(a.min < b.min ? a.min : b.min, a.max > b.max ? a.max : b.max);
+}
+
+static bool is_comparison(const char *op) {
+    return strcmp(op, "<") == 0 || strcmp(op, ">") == 0 ||
+           strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0 ||
+           strcmp(op, "==") == 0 || strcmp(op, "!=") == 0;
+}
+
+static bool is_logical(const char *op) {
+    return strcmp(op, "and") == 0 || strcmp(op, "or") == 0;
+}
+
+// Environment management
+
+static void env_init(RangeEnv *env) {
+    env->variables = NULL;
+    env->ranges = NULL;
+    env->count = 0;
+    env->capacity = 0;
+    env->reachable = true;
+}
+
+static void env_free(RangeEnv *env) {
+    free(env->variables);
+    free(env->ranges);
+    env_init(env);
+}
+
+static void env_copy(RangeEnv *dst, const RangeEnv *src) {
+    env_free(dst);
+    dst->capacity = src->count > 0 ? src->count : 1;
+    dst->variables = malloc(dst->capacity * sizeof(ASTNode *));
+    dst->ranges = malloc(dst->capacity * sizeof(ValueRange));
+    if (!dst->variables || !dst->ranges) {
+        fprintf(stderr, "Failed to allocate memory for range analysis\n");
+        exit(1);
+    }
+    if (src->count > 0) {
+        memcpy(dst->variables, src->variables, src->count * sizeof(ASTNode *));
+        memcpy(dst->ranges, src->ranges, src->count * sizeof(ValueRange));
+    }
+    dst->count = src->count;
+    dst->reachable = src->reachable;
+}
+
+static int env_find(const RangeEnv *env, const ASTNode *variable) {
+    for (int i = 0; i < env->count; i++) {
+        if (env->variables[i] == variable) return i;
+    }
+    return -1;
+}
+
+static ValueRange env_lookup(const RangeEnv *env, const ASTNode *variable) {
+    int index = env_find(env, variable);
+    return index >= 0 ? env->ranges[index] : full_range();
+}
+
+static void env_set(RangeEnv *env, const ASTNode *variable, ValueRange range) {
+    if (!variable) return;
+    int index = env_find(env, variable);
+    if (index >= 0) {
+        env->ranges[index] = range;
+        return;
+    }
+
+    if (env->count >= env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 8;
+        env->variables = realloc(env->variables, env->capacity * sizeof(ASTNode *));
+        env->ranges = realloc(env->ranges, env->capacity * sizeof(ValueRange));
+        if (!env->variables || !env->ranges) {
+            fprintf(stderr, "Failed to allocate memory for range analysis\n");
+            exit(1);
+        }
+    }
+    env->variables[env->count] = variable;
+    env->ranges[env->count] = range;
+    env->count++;
+}
+
+// Merge the state of another control-flow path into dst
+static void env_join(RangeEnv *dst, const RangeEnv *src) {
+    if (!src->reachable) return;
+    if (!dst->reachable) {
+        env_copy(dst, src);
+        return;
+    }
+
+    // A variable only known on one path holds an unknown value on the other
+    for (int i = 0; i < dst->count; i++) {
+        int index = env_find(src, dst->variables[i]);
+        dst->ranges[i] = index >= 0 ? join_ranges(dst->ranges[i], src->ranges[index]) : full_range();
+    }
+    for (int i = 0; i < src->count; i++) {
+        if (env_find(dst, src->variables[i]) < 0) {
+            env_set(dst, src->variables[i], full_range());
+        }
+    }
+}
+
+static bool env_equal(const RangeEnv *a, const RangeEnv *b) {
+    if (a->reachable != b->reachable || a->count != b->count) return false;
+    for (int i = 0; i < a->count; i++) {
+        int index = env_find(b, a->variables[i]);
+        if (index < 0 ||
+            a->ranges[i].min != b->ranges[index].min ||
+            a->ranges[i].max != b->ranges[index].max) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Push bounds that are still moving straight to the type limits so loops terminate
+static void env_widen(RangeEnv *next, const RangeEnv *previous) {
+    for (int i = 0; i < next->count; i++) {
+        int index = env_find(previous, next->variables[i]);
+        if (index < 0) continue;
+        if (next->ranges[i].min < previous->ranges[index].min) next->ranges[i].min = RANGE_INT_MIN;
+        if (next->ranges[i].max > previous->ranges[index].max) next->ranges[i].max = RANGE_INT_MAX;
+    }
+}
+
+// Name resolution
+
+// Make `name` stand for `declaration` until the enclosing block ends
+static void bind_variable(RangeAnalyzer *analyzer, const char *name, const ASTNode *declaration) {
+    if (analyzer->binding_count >= analyzer->binding_capacity) {
+        analyzer->binding_capacity = analyzer->binding_capacity ? analyzer->binding_capacity * 2 : 8;
+        analyzer->bindings = realloc(analyzer->bindings, analyzer->binding_capacity * sizeof(RangeBinding));
+        if (!analyzer->bindings) {
+            fprintf(stderr, "Failed to allocate memory for range analysis\n");
+            exit(1);
+        }
+    }
+    analyzer->bindings[analyzer->binding_count].name = name;
+    analyzer->bindings[analyzer->binding_count].declaration = declaration;
+    analyzer->binding_count++;
+}
+
+// Declaration of the innermost visible variable called `name`, NULL for
+// an undeclared one (semantic analysis reports those)
+static const ASTNode* resolve_variable(const RangeAnalyzer *analyzer, const char *name) {
+    for (int i = analyzer->binding_count - 1; i >= 0; i--) {
+        if (strcmp(analyzer->bindings[i].name, name) == 0) return analyzer->bindings[i].declaration;
+    }
+    return NULL;
+}
+
+// Expression evaluation
+
+static ValueRange divide_ranges(ValueRange a, ValueRange b) {
+    long lo = 0, hi = 0;
+    bool any = false;
+
+    // Split the divisor into its negative and positive parts; inside each part
+    // truncating division is monotonic, so the extremes are at the corners
+    long parts[2][2] = {
+        { b.min, b.max < -1 ? b.max : -1 },
+        { b.min > 1 ? b.min : 1, b.max }
+    };
+    for (int p = 0; p < 2; p++) {
+        if (parts[p][0] > parts[p][1]) continue;
+        long corners[4] = {
+            (long)a.min / parts[p][0], (long)a.min / parts[p][1],
+            (long)a.max / parts[p][0], (long)a.max / parts[p][1]
+        };
+        for (int i = 0; i < 4; i++) {
+            if (!any || corners[i] < lo) lo = corners[i];
+            if (!any || corners[i] > hi) hi = corners[i];
+            any = true;
+        }
+    }
+
+    return any ? checked_range(lo, hi) : full_range();
+}
+
+static ValueRange modulo_ranges(ValueRange a, ValueRange b) {
+    // The remainder takes the sign of the dividend and is smaller than |divisor|
+    long max_divisor = labs(b.min) > labs(b.max) ? labs(b.min) : labs(b.max);
+    long limit = max_divisor > 0 ? max_divisor - 1 : 0;
+
+    if (a.min >= 0) {
+        return make_range(0, (int)(a.max < limit ? a.max : limit));
+    }
+    if (a.max <= 0) {
+        return make_range((int)(a.min > -limit ? a.min : -limit), 0);
+    }
+    return make_range((int)-limit, (int)limit);
+}
+
+// "and"/"or" of two conditions: 1 if the outcome is decided, 0 or 1 otherwise
+static ValueRange logical_ranges(const char *op, ValueRange a, ValueRange b) {
+    bool a_true = a.min > 0 || a.max < 0;
+    bool b_true = b.min > 0 || b.max < 0;
+    bool a_false = a.min == 0 && a.max == 0;
+    bool b_false = b.min == 0 && b.max == 0;
+
+    if (strcmp(op, "and") == 0) {
+        if (a_false || b_false) return make_range(0, 0);
+        if (a_true && b_true) return make_range(1, 1);
+    } else {
+        if (a_true || b_true) return make_range(1, 1);
+        if (a_false && b_false) return make_range(0, 0);
+    }
+    return make_range(0, 1);
+}
+
+static ValueRange compare_ranges(const char *op, ValueRange a, ValueRange b) {
+    bool always_true = false;
+    bool always_false = false;
+
+    if (strcmp(op, "<") == 0) {
+        always_true = a.max < b.min;
+        always_false = a.min >= b.max;
+    } else if (strcmp(op, "<=") == 0) {
+        always_true = a.max <= b.min;
+        always_false = a.min > b.max;
+    } else if (strcmp(op, ">") == 0) {
+        always_true = a.min > b.max;
+        always_false = a.max <= b.min;
+    } else if (strcmp(op, ">=") == 0) {
+        always_true = a.min >= b.max;
+        always_false = a.max < b.min;
+    } else if (strcmp(op, "==") == 0) {
+        always_true = a.min == a.max && b.min == b.max && a.min == b.min;
+        always_false = a.max < b.min || b.max < a.min;
+    } else if (strcmp(op, "!=") == 0) {
+        always_true = a.max < b.min || b.max < a.min;
+        always_false = a.min == a.max && b.min == b.max && a.min == b.min;
+    }
+
+    if (always_true) return make_range(1, 1);
+    if (always_false) return make_range(0, 0);
+    return make_range(0, 1);
+}
+
+static ValueRange eval_binary_operation(RangeAnalyzer *analyzer, ASTNode *binary_op, RangeEnv *env) {
+    if (binary_op->num_children < 2) return full_range();
+
+    ValueRange a = eval_expression(analyzer, binary_op->children[0], env);
+    ValueRange b = eval_expression(analyzer, binary_op->children[1], env);
+    const char *op = binary_op->value;
+
+    if (strcmp(op, "+") == 0) {
+        return checked_range((long)a.min + b.min, (long)a.max + b.max);
+    }
+    if (strcmp(op, "-") == 0) {
+        return checked_range((long)a.min - b.max, (long)a.max - b.min);
+    }
+    if (strcmp(op, "*") == 0) {
+        long corners[4] = {
+            (long)a.min * b.min, (long)a.min * b.max,
+            (long)a.max * b.min, (long)a.max * b.max
+        };
+        long lo = corners[0], hi = corners[0];
+        for (int i = 1; i < 4; i++) {
+            if (corners[i] < lo) lo = corners[i];
+            if (corners[i] > hi) hi = corners[i];
+        }
+        return checked_range(lo, hi);
+    }
+    if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+        if (b.min == 0 && b.max == 0) {
+            // Only report when the division is actually reached
+            if (analyzer->report_errors && env->reachable) {
+                char msg[128];
+                snprintf(msg, sizeof(msg), "Divisor of '%s' is always zero", op);
+                report_semantic_error(analyzer->context, SEM_ERROR_DIVISION_BY_ZERO, msg, 0);
+                analyzer->success = false;
+            }
+            return full_range();
+        }
+        return op[0] == '/' ? divide_ranges(a, b) : modulo_ranges(a, b);
+    }
+    if (is_comparison(op)) {
+        return compare_ranges(op, a, b);
+    }
+    if (is_logical(op)) {
+        return logical_ranges(op, a, b);
+    }
+
+    return full_range();
+}
+
+static ValueRange eval_expression(RangeAnalyzer *analyzer, ASTNode *expr, RangeEnv *env) {
+    if (!expr) return full_range();
+
+    ValueRange range = full_range();
+
+    switch (expr->type) {
+        case NODE_NUMBER: {
+            // Literals are stored in 16 bits, so large ones wrap around
+            short value = (short)atol(expr->value);
+            range = make_range(value, value);
+            break;
+        }
+
+        case NODE_STRING:
+            // Strings are emitted as the value 0
+            range = make_range(0, 0);
+            break;
+
+        case NODE_IDENTIFIER:
+            range = env_lookup(env, resolve_variable(analyzer, expr->value));
+            break;
+
+        case NODE_BINARY_OP:
+            range = eval_binary_operation(analyzer, expr, env);
+            break;
+
+        case NODE_EXPR:
+            // Function calls: the arguments are evaluated, the result is unknown
+            for (int i = 0; i < expr->num_children; i++) {
+                eval_expression(analyzer, expr->children[i], env);
+            }
+            break;
+
+        case NODE_LULOAD:
+        default:
+            break;
+    }
+
+    expr->range = range;
+    return range;
+}
+
+// Condition refinement
+
+// Mirror an operator so the variable can be treated as the left operand
+static const char* swap_comparison(const char *op) {
+    if (strcmp(op, "<") == 0) return ">";
+    if (strcmp(op, ">") == 0) return "<";
+    if (strcmp(op, "<=") == 0) return ">=";
+    if (strcmp(op, ">=") == 0) return "<=";
+    return op;
+}
+
+static const char* negate_comparison(const char *op) {
+    if (strcmp(op, "<") == 0) return ">=";
+    if (strcmp(op, ">") == 0) return "<=";
+    if (strcmp(op, "<=") == 0) return ">";
+    if (strcmp(op, ">=") == 0) return "<";
+    if (strcmp(op, "==") == 0) return "!=";
+    return "==";
+}
+
+static void refine_variable(RangeAnalyzer *analyzer, RangeEnv *env, ASTNode *var, const char *op, ValueRange other) {
+    const ASTNode *variable = resolve_variable(analyzer, var->value);
+    ValueRange range = env_lookup(env, variable);
+    long lo = range.min, hi = range.max;
+
+    if (strcmp(op, "<") == 0) {
+        if (other.max - 1L < hi) hi = other.max - 1L;
+    } else if (strcmp(op, "<=") == 0) {
+        if (other.max < hi) hi = other.max;
+    } else if (strcmp(op, ">") == 0) {
+        if (other.min + 1L > lo) lo = other.min + 1L;
+    } else if (strcmp(op, ">=") == 0) {
+        if (other.min > lo) lo = other.min;
+    } else if (strcmp(op, "==") == 0) {
+        if (other.min > lo) lo = other.min;
+        if (other.max < hi) hi = other.max;
+    } else if (strcmp(op, "!=") == 0 && other.min == other.max) {
+        if (lo == other.min) lo++;
+        if (hi == other.min) hi--;
+    }
+
+    if (lo > hi) {
+        env->reachable = false;
+        return;
+    }
+    env_set(env, variable, make_range((int)lo, (int)hi));
+}
+
+// Narrow variable ranges on the path where the condition has the given outcome
+static void refine_condition(RangeAnalyzer *analyzer, RangeEnv *env, ASTNode *cond_expr, bool outcome) {
+    if (!env->reachable || !cond_expr) return;
+
+    if (cond_expr->range.known && cond_expr->range.min == cond_expr->range.max &&
+        (cond_expr->range.min != 0) != outcome) {
+        env->reachable = false;
+        return;
+    }
+
+    if (cond_expr->type != NODE_BINARY_OP || cond_expr->num_children < 2) {
+        return;
+    }
+
+    // Both sides of "and" hold when it is true, both sides of "or" fail
+    // when it is false
+    if (is_logical(cond_expr->value)) {
+        if ((strcmp(cond_expr->value, "and") == 0) == outcome) {
+            refine_condition(analyzer, env, cond_expr->children[0], outcome);
+            refine_condition(analyzer, env, cond_expr->children[1], outcome);
+        }
+        return;
+    }
+
+    // "not c" is parsed as "c == 0"
+    ASTNode *operand = cond_expr->children[0];
+    if (strcmp(cond_expr->value, "==") == 0 && cond_expr->children[1]->type == NODE_NUMBER &&
+        atoi(cond_expr->children[1]->value) == 0 && operand->type == NODE_BINARY_OP &&
+        operand->num_children == 2 && (is_comparison(operand->value) || is_logical(operand->value))) {
+        refine_condition(analyzer, env, operand, !outcome);
+        return;
+    }
+
+    if (!is_comparison(cond_expr->value)) {
+        return;
+    }
+
+    const char *op = outcome ? cond_expr->value : negate_comparison(cond_expr->value);
+    ASTNode *left = cond_expr->children[0];
+    ASTNode *right = cond_expr->children[1];
+    ValueRange left_range = left->range.known ? left->range : full_range();
+    ValueRange right_range = right->range.known ? right->range : full_range();
+
+    if (left->type == NODE_IDENTIFIER) {
+        refine_variable(analyzer, env, left, op, right_range);
+    }
+    if (right->type == NODE_IDENTIFIER && env->reachable) {
+        refine_variable(analyzer, env, right, swap_comparison(op), left_range);
+    }
+}
+
+static ASTNode* condition_expression(ASTNode *statement) {
+    ASTNode *condition = find_child(statement, NODE_CONDITION);
+    return (condition && condition->num_children > 0) ? condition->children[0] : NULL;
+}
+
+// Statements
+
+static void analyze_if_ranges(RangeAnalyzer *analyzer, ASTNode *if_stmt, RangeEnv *env) {
+    ASTNode *cond_expr = condition_expression(if_stmt);
+    if (cond_expr) eval_expression(analyzer, cond_expr, env);
+
+    RangeEnv then_env, else_env;
+    env_init(&then_env);
+    env_init(&else_env);
+    env_copy(&then_env, env);
+    env_copy(&else_env, env);
+    refine_condition(analyzer, &then_env, cond_expr, true);
+    refine_condition(analyzer, &else_env, cond_expr, false);
+
+    ASTNode *if_block = find_child(if_stmt, NODE_BLOCK);
+    if (if_block) analyze_block_ranges(analyzer, if_block, &then_env);
+
+    ASTNode *else_node = find_child(if_stmt, NODE_ELSE);
+    if (else_node) {
+        ASTNode *else_block = find_child(else_node, NODE_BLOCK);
+        if (else_block) analyze_block_ranges(analyzer, else_block, &else_env);
+    }
+
+    env_copy(env, &then_env);
+    env_join(env, &else_env);
+
+    env_free(&then_env);
+    env_free(&else_env);
+}
+
+// Iterate the loop body until the ranges at the loop test stop changing
+static void analyze_luloop_ranges(RangeAnalyzer *analyzer, ASTNode *luloop, RangeEnv *env) {
+    ASTNode *cond_expr = condition_expression(luloop);
+    ASTNode *body = find_child(luloop, NODE_BLOCK);
+    bool saved_report = analyzer->report_errors;
+
+    RangeEnv head, body_env, next;
+    env_init(&head);
+    env_init(&body_env);
+    env_init(&next);
+    env_copy(&head, env);
+
+    analyzer->report_errors = false;
+    for (int iteration = 0; ; iteration++) {
+        if (cond_expr) eval_expression(analyzer, cond_expr, &head);
+        env_copy(&body_env, &head);
+        refine_condition(analyzer, &body_env, cond_expr, true);
+        if (body) analyze_block_ranges(analyzer, body, &body_env);
+
+        // The test is reached from the loop entry and from the end of the body
+        env_copy(&next, env);
+        env_join(&next, &body_env);
+        if (iteration >= RANGE_WIDEN_AFTER) {
+            env_widen(&next, &head);
+        }
+        if (iteration >= RANGE_GIVE_UP_AFTER) {
+            for (int i = 0; i < next.count; i++) next.ranges[i] = full_range();
+            env_copy(&head, &next);
+            break;
+        }
+        if (env_equal(&next, &head)) break;
+        env_copy(&head, &next);
+    }
+    analyzer->report_errors = saved_report;
+
+    // Final pass over the stable state records sound ranges and reports errors
+    if (cond_expr) eval_expression(analyzer, cond_expr, &head);
+    env_copy(&body_env, &head);
+    refine_condition(analyzer, &body_env, cond_expr, true);
+    if (body) analyze_block_ranges(analyzer, body, &body_env);
+
+    env_copy(env, &head);
+    refine_condition(analyzer, env, cond_expr, false);
+
+    env_free(&head);
+    env_free(&body_env);
+    env_free(&next);
+}
+
+static void analyze_statement(RangeAnalyzer *analyzer, ASTNode *stmt, RangeEnv *env) {
+    switch (stmt->type) {
+        case NODE_VAR_DECL: {
+            // Without an initializer the stack slot holds an unknown value
+            ValueRange range = full_range();
+            for (int i = 0; i < stmt->num_children; i++) {
+                if (stmt->children[i]->type != NODE_TYPE) {
+                    range = eval_expression(analyzer, stmt->children[i], env);
+                    break;
+                }
+            }
+            // The initializer still sees what the new variable hides
+            bind_variable(analyzer, stmt->value, stmt);
+            env_set(env, stmt, range);
+            break;
+        }
+
+        case NODE_EXPR:
+            if (strcmp(stmt->value, "=") == 0 && stmt->num_children >= 2) {
+                ValueRange range = eval_expression(analyzer, stmt->children[1], env);
+                env_set(env, resolve_variable(analyzer, stmt->children[0]->value), range);
+            } else {
+                eval_expression(analyzer, stmt, env);
+            }
+            break;
+
+        case NODE_RETURN:
+            if (stmt->num_children > 0) {
+                eval_expression(analyzer, stmt->children[0], env);
+            }
+            env->reachable = false;
+            break;
+
+        case NODE_LULOG:
+            if (stmt->num_children > 0) {
+                eval_expression(analyzer, stmt->children[0], env);
+            }
+            break;
+
+        case NODE_IF:
+            analyze_if_ranges(analyzer, stmt, env);
+            break;
+
+        case NODE_LULOOP:
+            analyze_luloop_ranges(analyzer, stmt, env);
+            break;
+
+        case NODE_BLOCK:
+            analyze_block_ranges(analyzer, stmt, env);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// The declarations of a block go out of sight at its end (the function
+// body shares the function scope with the parameters)
+static void analyze_block_ranges(RangeAnalyzer *analyzer, ASTNode *block, RangeEnv *env) {
+    int visible = analyzer->binding_count;
+    for (int i = 0; i < block->num_children; i++) {
+        analyze_statement(analyzer, block->children[i], env);
+    }
+    analyzer->binding_count = visible;
+}
+
+// Run interval analysis over a function body
+bool analyze_value_ranges(SemanticContext *context, ASTNode *function) {
+    if (!context || !function || function->type != NODE_FUNCTION) return false;
+
+    RangeAnalyzer analyzer;
+    analyzer.context = context;
+    analyzer.report_errors = true;
+    analyzer.success = true;
+    analyzer.bindings = NULL;
+    analyzer.binding_count = 0;
+    analyzer.binding_capacity = 0;
+
+    // Parameters start with the full range, which is what lookups default to
+    RangeEnv env;
+    env_init(&env);
+    ASTNode *params = find_child(function, NODE_PARAM);
+    for (int i = 0; params && i < params->num_children; i++) {
+        ASTNode *param = params->children[i];
+        if (param->type == NODE_PARAM || param->type == NODE_VAR_DECL) {
+            bind_variable(&analyzer, param->value, param);
+        }
+    }
+
+    ASTNode *body = find_child(function, NODE_BLOCK);
+    if (body) {
+        analyze_block_ranges(&analyzer, body, &env);
+    }
+
+    env_free(&env);
+    free(analyzer.bindings);
+    return analyzer.success;
+}
+
+// Range queries used by the code generator
+
+bool range_is_non_negative(const ASTNode *expr) {
+    return expr && expr->range.known && expr->range.min >= 0;
+}
+
+bool range_is_constant(const ASTNode *expr, int *value) {
+    if (!expr || !expr->range.known || expr->range.min != expr->range.max) return false;
+    if (value) *value = expr->range.min;
+    return true;
+}
+
+bool expression_is_pure(const ASTNode *expr) {
+    if (!expr) return true;
+    if (expr->type == NODE_LULOAD) return false;
+    if (expr->type == NODE_EXPR && strcmp(expr->value, "=") != 0) return false;
+    for (int i = 0; i < expr->num_children; i++) {
+        if (!expression_is_pure(expr->children[i])) return false;
+    }
+    return true;
+}
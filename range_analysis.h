@@ -0,0 +1,23 @@
+#ifndef RANGE_ANALYSIS_H
+#define RANGE_ANALYSIS_H
+
+#include "parser.h"
+#include "semantic.h"
+
+// Limits of the 16-bit signed integers used by the target
+#define RANGE_INT_MIN (-32768)
+#define RANGE_INT_MAX 32767
+
+// Run interval analysis over a function body.
+// Every expression node gets its ValueRange filled in, and a division or
+// modulo whose divisor is provably zero is reported as a semantic error.
+bool analyze_value_ranges(SemanticContext *context, ASTNode *function);
+
+// Range queries used by the code generator
+bool range_is_non_negative(const ASTNode *expr);
+bool range_is_constant(const ASTNode *expr, int *value);
+
+// True if evaluating the expression has no side effects (no input or calls)
+bool expression_is_pure(const ASTNode *expr);
+
+#endif // RANGE_ANALYSIS_H
@@ -0,0 +1,322 @@
+#include "regalloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Accesses in a loop count this many times more than outside it
+#define LOOP_WEIGHT 10
+#define MAX_WEIGHTED_DEPTH 4
+
+// Slots accessed less often gain nothing from a register
+#define MIN_WEIGHT 2
+
+// Per-block slot sets, one byte per slot
+typedef struct {
+    bool *use;                   // Read before any write in the block
+    bool *def;                   // Written in the block
+    bool *live_in;
+    bool *live_out;
+    int first;                   // Number of the first instruction
+    int last;                    // Number of the last instruction (first - 1 if empty)
+} BlockLiveness;
+
+static int depth_weight(int depth) {
+    int weight = 1;
+    for (int i = 0; i < depth && i < MAX_WEIGHTED_DEPTH; i++) {
+        weight *= LOOP_WEIGHT;
+    }
+    return weight;
+}
+
+// Extend the live range of a slot to cover `position`
+static void extend(SlotAllocation *allocation, int slot, int position) {
+    if (allocation->start[slot] < 0 || position < allocation->start[slot]) {
+        allocation->start[slot] = position;
+    }
+    if (position > allocation->end[slot]) {
+        allocation->end[slot] = position;
+    }
+}
+
+// Successors of a block: the targets of its terminator, or the next block
+// when it falls through
+static int successors(const IRBlock *block, const IRBlock *out[2]) {
+    IRInstr *last = block->last;
+    if (!last || !ir_is_terminator(last->op)) {
+        out[0] = block->next;
+        return block->next ? 1 : 0;
+    }
+    switch (last->op) {
+        case IR_JUMP:
+            out[0] = last->target;
+            return 1;
+        case IR_BRANCH:
+        case IR_LOOP:
+            out[0] = last->target;
+            out[1] = last->else_target;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// Backward data flow until nothing changes
+static void compute_liveness(const IRFunction *function, BlockLiveness *blocks) {
+    int slot_count = function->slot_count;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const IRBlock *block = function->last_block; block; block = block->prev) {
+            BlockLiveness *info = &blocks[block->id];
+
+            const IRBlock *next[2];
+            int count = successors(block, next);
+            for (int i = 0; i < count; i++) {
+                const bool *in = blocks[next[i]->id].live_in;
+                for (int slot = 0; slot < slot_count; slot++) {
+                    if (in[slot] && !info->live_out[slot]) {
+                        info->live_out[slot] = true;
+                        changed = true;
+                    }
+                }
+            }
+
+            for (int slot = 0; slot < slot_count; slot++) {
+                bool live = info->use[slot] || (info->live_out[slot] && !info->def[slot]);
+                if (live && !info->live_in[slot]) {
+                    info->live_in[slot] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+// Number the instructions, collect the per-block sets and the slot weights
+static void scan_accesses(const IRFunction *function, BlockLiveness *blocks, SlotAllocation *allocation) {
+    int position = 0;
+    for (const IRBlock *block = function->first_block; block; block = block->next) {
+        BlockLiveness *info = &blocks[block->id];
+        info->first = position;
+        int weight = depth_weight(block->loop_depth);
+
+        for (const IRInstr *instr = block->first; instr; instr = instr->next, position++) {
+            int slot;
+            if (instr->op == IR_LOAD) {
+                slot = instr->a.value;
+                if (!info->def[slot]) info->use[slot] = true;
+            } else if (instr->op == IR_STORE) {
+                slot = instr->dst.value;
+                info->def[slot] = true;
+            } else if (instr->op == IR_LOOP) {
+                // Reads and writes the counter
+                slot = instr->dst.value;
+                if (!info->def[slot]) info->use[slot] = true;
+                info->def[slot] = true;
+            } else {
+                continue;
+            }
+            extend(allocation, slot, position);
+            allocation->weight[slot] += weight;
+        }
+        info->last = position - 1;
+    }
+}
+
+// Does an instruction in [start, end] need DX:AX and a third register?
+static bool range_has_multiply(const IRFunction *function, int start, int end) {
+    int position = 0;
+    for (const IRBlock *block = function->first_block; block; block = block->next) {
+        for (const IRInstr *instr = block->first; instr; instr = instr->next, position++) {
+            if (position < start || position > end) continue;
+            switch (instr->op) {
+                case IR_MUL:
+                case IR_MULHI:
+                case IR_DIV:
+                case IR_MOD:
+                case IR_UDIV:
+                case IR_UMOD:
+                    return true;
+                default:
+                    break;
+            }
+        }
+    }
+    return false;
+}
+
+// Loop counters go first to the counter register, the heaviest first, as
+// long as their ranges do not overlap. With SI/DI/BX taken by variables,
+// a multiply or divide in the range would be left without a register for
+// its operand, so such counters stay with the linear scan.
+static void assign_counter_register(const IRFunction *function, SlotAllocation *allocation,
+                                    int register_count, int *order) {
+    int count = 0;
+    for (int slot = 0; slot < allocation->slot_count; slot++) {
+        const IRSlot *info = &function->slots[slot];
+        if (info->counter && !info->parameter && allocation->start[slot] >= 0 &&
+            !range_has_multiply(function, allocation->start[slot], allocation->end[slot])) {
+            order[count++] = slot;
+        }
+    }
+    for (int i = 1; i < count; i++) {
+        int slot = order[i];
+        int j = i;
+        while (j > 0 && allocation->weight[order[j - 1]] < allocation->weight[slot]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = slot;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int slot = order[i];
+        bool overlaps = false;
+        for (int j = 0; j < i; j++) {
+            int other = order[j];
+            if (allocation->assignment[other] == register_count &&
+                allocation->start[other] <= allocation->end[slot] && allocation->start[slot] <= allocation->end[other]) {
+                overlaps = true;
+            }
+        }
+        if (!overlaps) allocation->assignment[slot] = register_count;
+    }
+}
+
+// Linear scan: walk the ranges by start, freeing the registers of ranges that
+// ended; when none is free, the lightest of the active ranges and the new
+// one goes back to memory
+static void linear_scan(SlotAllocation *allocation, int register_count, int *order, int *active) {
+    if (register_count == 0) return;
+
+    int count = 0;
+    for (int slot = 0; slot < allocation->slot_count; slot++) {
+        if (allocation->start[slot] >= 0 && allocation->weight[slot] >= MIN_WEIGHT &&
+            allocation->assignment[slot] < 0) {
+            order[count++] = slot;
+        }
+    }
+    // Sort by start (insertion sort: there are few slots, and the slot
+    // order breaks ties)
+    for (int i = 1; i < count; i++) {
+        int slot = order[i];
+        int j = i;
+        while (j > 0 && allocation->start[order[j - 1]] > allocation->start[slot]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = slot;
+    }
+
+    for (int reg = 0; reg < register_count; reg++) {
+        active[reg] = -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int slot = order[i];
+        int chosen = -1;
+        for (int reg = 0; reg < register_count; reg++) {
+            if (active[reg] >= 0 && allocation->end[active[reg]] < allocation->start[slot]) {
+                active[reg] = -1;
+            }
+            if (active[reg] < 0 && chosen < 0) chosen = reg;
+        }
+
+        if (chosen < 0) {
+            int lightest = 0;
+            for (int reg = 1; reg < register_count; reg++) {
+                if (allocation->weight[active[reg]] < allocation->weight[active[lightest]]) lightest = reg;
+            }
+            if (allocation->weight[active[lightest]] >= allocation->weight[slot]) {
+                continue;
+            }
+            allocation->assignment[active[lightest]] = -1;
+            chosen = lightest;
+        }
+
+        active[chosen] = slot;
+        allocation->assignment[slot] = chosen;
+    }
+}
+
+bool allocate_slot_registers(const IRFunction *function, int register_count, SlotAllocation *allocation) {
+    int slot_count = function->slot_count;
+    memset(allocation, 0, sizeof(SlotAllocation));
+    allocation->slot_count = slot_count;
+    allocation->assignment = (int *)malloc(sizeof(int) * (slot_count + 1));
+    allocation->start = (int *)malloc(sizeof(int) * (slot_count + 1));
+    allocation->end = (int *)malloc(sizeof(int) * (slot_count + 1));
+    allocation->weight = (int *)calloc(slot_count + 1, sizeof(int));
+
+    allocation->live_out = (bool *)calloc((size_t)(function->block_count + 1) * (slot_count + 1), sizeof(bool));
+
+    BlockLiveness *blocks = (BlockLiveness *)calloc(function->block_count + 1, sizeof(BlockLiveness));
+    bool *sets = (bool *)calloc((size_t)(function->block_count + 1) * 3 * (slot_count + 1), sizeof(bool));
+    int *order = (int *)malloc(sizeof(int) * (slot_count + 1));
+    int *active = (int *)malloc(sizeof(int) * (register_count + 1));
+
+    if (!allocation->assignment || !allocation->start || !allocation->end || !allocation->weight ||
+        !allocation->live_out || !blocks || !sets || !order || !active) {
+        fprintf(stderr, "Failed to allocate memory for register allocation of '%s'\n", function->name);
+        free(blocks);
+        free(sets);
+        free(order);
+        free(active);
+        free_slot_allocation(allocation);
+        return false;
+    }
+
+    for (int slot = 0; slot < slot_count; slot++) {
+        allocation->assignment[slot] = -1;
+        allocation->start[slot] = -1;
+        allocation->end[slot] = -1;
+    }
+    for (int i = 0; i < function->block_count; i++) {
+        bool *base = sets + (size_t)i * 3 * (slot_count + 1);
+        blocks[i].use = base;
+        blocks[i].def = base + (slot_count + 1);
+        blocks[i].live_in = base + 2 * (slot_count + 1);
+        blocks[i].live_out = allocation->live_out + (size_t)i * (slot_count + 1);
+    }
+
+    scan_accesses(function, blocks, allocation);
+    compute_liveness(function, blocks);
+
+    // A slot live into or out of a block covers the whole block
+    for (const IRBlock *block = function->first_block; block; block = block->next) {
+        const BlockLiveness *info = &blocks[block->id];
+        for (int slot = 0; slot < slot_count; slot++) {
+            if (info->live_in[slot]) extend(allocation, slot, info->first);
+            if (info->live_out[slot] && info->last >= info->first) extend(allocation, slot, info->last);
+        }
+    }
+
+    if (register_count > 0) assign_counter_register(function, allocation, register_count, order);
+    linear_scan(allocation, register_count, order, active);
+
+    free(blocks);
+    free(sets);
+    free(order);
+    free(active);
+    return true;
+}
+
+bool slot_live_after(const SlotAllocation *allocation, const IRBlock *block, const IRInstr *instr, int slot) {
+    // The next access in the block decides; without one, the block's live-out set
+    for (const IRInstr *next = instr->next; next; next = next->next) {
+        if ((next->op == IR_LOAD && next->a.value == slot) || (next->op == IR_LOOP && next->dst.value == slot)) {
+            return true;
+        }
+        if (next->op == IR_STORE && next->dst.value == slot) return false;
+    }
+    return allocation->live_out[(size_t)block->id * (allocation->slot_count + 1) + slot];
+}
+
+void free_slot_allocation(SlotAllocation *allocation) {
+    free(allocation->assignment);
+    free(allocation->start);
+    free(allocation->end);
+    free(allocation->weight);
+    free(allocation->live_out);
+    memset(allocation, 0, sizeof(SlotAllocation));
+}
@@ -0,0 +1,38 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include <stdbool.h>
+#include "ir.h"
+
+// Register allocation of variables (IR slots).
+// Slot liveness is computed over the blocks of a function, every slot gets
+// one live range from the first to the last instruction where it is live,
+// and a linear scan over the ranges hands out a small set of registers.
+// When the registers run out, the range with the lowest use count weighted
+// by loop depth stays in memory. Counters of loops closed by IR_LOOP can
+// also get one extra register, index `register_count`, kept for them.
+
+// Result of the allocation. Instructions are numbered in layout order from 0.
+typedef struct {
+    int slot_count;
+    int *assignment;             // Register index of every slot (-1: stays in memory,
+                                 // register_count: the counter register)
+    int *start;                  // First instruction of the live range (-1 if never accessed)
+    int *end;                    // Last instruction of the live range
+    int *weight;                 // Accesses weighted by loop depth
+    bool *live_out;              // Slots live at the end of every block,
+                                 // slot_count + 1 entries per block id
+} SlotAllocation;
+
+// Allocate `register_count` registers, plus the counter register when
+// there are any, to the slots of `function`.
+// Returns false if memory runs out.
+bool allocate_slot_registers(const IRFunction *function, int register_count, SlotAllocation *allocation);
+
+// Is the value of `slot` read after `instr`, the instruction of `block`
+// being emitted, before it is written again?
+bool slot_live_after(const SlotAllocation *allocation, const IRBlock *block, const IRInstr *instr, int slot);
+
+void free_slot_allocation(SlotAllocation *allocation);
+
+#endif // REGALLOC_H
@@ -0,0 +1,509 @@
+#include "runtime.h"
+#include "target.h"
+#include <stdio.h>
+
+// Runtime output buffer for lulog, and the longest number it prints ("-32768\r\n")
+#define OUTPUT_BUFFER_SIZE 256
+#define LULOG_MAX_LENGTH 8
+
+// Runtime input buffer luload parses from (one DOS read fills it)
+#define INPUT_BUFFER_SIZE 512
+
+// One separately emitted piece of the runtime
+typedef struct {
+    unsigned requires;           // Fragments its code calls or jumps to
+    unsigned requires_buffered;  // Further ones with buffered output
+    void (*generate_data)(CodeGenContext *context); // NULL if it owns no data
+    void (*generate_code)(CodeGenContext *context);
+} RuntimeFragmentInfo;
+
+// Decimal places above the ones, highest first
+static const int decimal_powers[] = { 10000, 1000, 100, 10 };
+#define DECIMAL_POWER_COUNT 4
+
+// Digits by division are only worth it where the divider is fast: one
+// division per digit against about three subtract-and-branch steps (the
+// digit range is halved with a compare first)
+//
+// 8086 clocks of the conversion alone (Intel timings, div averaged to 153
+// as in target.c; the call, the sign and CR LF are not counted), against
+// the division loop used before, which pushed every remainder and popped
+// the digits back in order (237 clocks per digit, less 17):
+//
+//   digits  division  subtraction (lowest-highest, average)
+//   1            220   44
+//   2            457   107-203, 160
+//   3            694   170-362, 271
+//   4            931   233-521, 382
+//   5           1168   303-614, 460
+//
+// A place costs 59 + 23 * digit clocks for digits 0-4 and 55 + 23 *
+// (digit - 5) for 5-9; finding the first place costs 20-44. Over every
+// value of a signed lulog, -32768 to 32767, the average is 1088 clocks
+// by division and 432 by subtraction. tests/lulog_range_test.lx prints
+// the whole range, for measuring it under an emulator.
+static bool divide_digits(const TargetCosts *costs) {
+    int subtract = 3 * (costs->alu + costs->alu + costs->branch) + 3 * costs->alu;
+    int divide = costs->unsigned_divide + 2 * costs->alu + costs->branch;
+    return divide < subtract;
+}
+
+// Store the decimal digits of AX (unsigned) at buffer[DI] onwards, each
+// in its final place, and leave DI after the last one. Changes AX, BX,
+// CX and DX. Without a fast divider every place subtracts its power of
+// ten; otherwise the number of digits is found first, and division by 10
+// fills them in from the right.
+static void generate_decimal_digits(CodeGenContext *context, const char *buffer) {
+    if (!divide_digits(target_costs(context->target))) {
+        // Start at the highest place the value reaches: no leading zeros
+        for (int i = DECIMAL_POWER_COUNT - 1; i >= 0; i--) {
+            write_instruction(context, "cmp ax, %d", decimal_powers[i]);
+            write_instruction(context, "jb lulog_place_%d", i == DECIMAL_POWER_COUNT - 1 ? 1 : decimal_powers[i + 1]);
+        }
+        for (int i = 0; i < DECIMAL_POWER_COUNT; i++) {
+            int power = decimal_powers[i];
+            write_label(context, "lulog_place_%d", power);
+            write_instruction(context, "mov dl, '0' - 1");
+            write_instruction(context, "cmp ax, %d", 5 * power);
+            write_instruction(context, "jb lulog_count_%d", power);
+            write_instruction(context, "sub ax, %d", 5 * power);
+            write_instruction(context, "mov dl, '5' - 1");
+            write_label(context, "lulog_count_%d", power);
+            write_instruction(context, "inc dl");
+            write_instruction(context, "sub ax, %d", power);
+            write_instruction(context, "jae lulog_count_%d", power);
+            write_instruction(context, "add ax, %d", power);
+            write_instruction(context, "mov %s[di], dl", buffer);
+            write_instruction(context, "inc di");
+        }
+        write_label(context, "lulog_place_1");
+        write_instruction(context, "add al, '0'");
+        write_instruction(context, "mov %s[di], al", buffer);
+        write_instruction(context, "inc di");
+        return;
+    }
+
+    // DI moves past as many digits as the value has
+    for (int i = DECIMAL_POWER_COUNT - 1; i >= 0; i--) {
+        write_instruction(context, "cmp ax, %d", decimal_powers[i]);
+        write_instruction(context, "jb lulog_length_%d", DECIMAL_POWER_COUNT - i);
+    }
+    for (int length = DECIMAL_POWER_COUNT + 1; length >= 1; length--) {
+        if (length <= DECIMAL_POWER_COUNT) write_label(context, "lulog_length_%d", length);
+        write_instruction(context, "inc di");
+    }
+    write_instruction(context, "mov cx, di");
+    write_instruction(context, "mov bx, 10");
+    write_label(context, "lulog_divide");
+    write_instruction(context, "xor dx, dx");
+    write_instruction(context, "div bx");
+    write_instruction(context, "add dl, '0'");
+    write_instruction(context, "dec di");
+    write_instruction(context, "mov %s[di], dl", buffer);
+    write_instruction(context, "test ax, ax");
+    write_instruction(context, "jnz lulog_divide");
+    write_instruction(context, "mov di, cx");
+}
+
+// Console lulog: signed entry, continuing in lulog_unsigned's code
+static void generate_console_lulog(CodeGenContext *context) {
+    write_comment(context, "Print the number in AX");
+    write_label(context, "lulog");
+    write_instruction(context, "xor di, di");
+    write_instruction(context, "test ax, ax");
+    write_instruction(context, "jns lulog_digits");
+    write_instruction(context, "neg ax");              // -32768 stays 8000h, read as unsigned
+    write_instruction(context, "mov number_buffer[di], '-'");
+    write_instruction(context, "inc di");
+    write_instruction(context, "jmp lulog_digits");
+}
+
+static void generate_console_lulog_data(CodeGenContext *context) {
+    write_line(context, "number_buffer db %d dup(?) ; Text of the number lulog prints", LULOG_MAX_LENGTH + 1);
+}
+
+// Console lulog_unsigned: the number is formatted in number_buffer and
+// printed with one DOS call (--unbuffered-output)
+static void generate_console_lulog_unsigned(CodeGenContext *context) {
+    // Entry point for values that range analysis proved non-negative
+    write_comment(context, "Entry for non-negative values (no sign handling)");
+    write_label(context, "lulog_unsigned");
+    write_instruction(context, "xor di, di");
+
+    write_label(context, "lulog_digits");
+    generate_decimal_digits(context, "number_buffer");
+    write_instruction(context, "mov word ptr number_buffer[di], 0A0Dh"); // CR, LF
+    write_instruction(context, "mov number_buffer[di+2], '$'");
+    write_instruction(context, "mov ah, 9");           // DOS function 9: print string
+    write_instruction(context, "mov dx, offset number_buffer");
+    write_instruction(context, "int 21h");
+    write_instruction(context, "ret");
+}
+
+// Buffered lulog: signed entry, continuing in lulog_unsigned's code
+static void generate_buffered_lulog(CodeGenContext *context) {
+    write_comment(context, "Print the number in AX (buffered)");
+    write_label(context, "lulog");
+    write_instruction(context, "call reserve_output");  // DI = free position
+    write_instruction(context, "test ax, ax");
+    write_instruction(context, "jns lulog_digits");
+    write_instruction(context, "neg ax");              // -32768 stays 8000h, read as unsigned
+    write_instruction(context, "mov output_buffer[di], '-'");
+    write_instruction(context, "inc di");
+    write_instruction(context, "jmp lulog_digits");
+}
+
+// Buffered lulog_unsigned, formatting into output_buffer, which
+// flush_output writes with one DOS call when it is nearly full, before
+// luload reads and at exit
+static void generate_buffered_lulog_unsigned(CodeGenContext *context) {
+    // Entry point for values that range analysis proved non-negative
+    write_comment(context, "Entry for non-negative values (no sign handling)");
+    write_label(context, "lulog_unsigned");
+    write_instruction(context, "call reserve_output");
+
+    write_label(context, "lulog_digits");
+    generate_decimal_digits(context, "output_buffer");
+    write_instruction(context, "mov word ptr output_buffer[di], 0A0Dh"); // CR, LF
+    write_instruction(context, "add di, 2");
+    write_instruction(context, "mov output_length, di");
+    write_instruction(context, "ret");
+}
+
+static void generate_lulog(CodeGenContext *context) {
+    if (context->buffered_output) {
+        generate_buffered_lulog(context);
+    } else {
+        generate_console_lulog(context);
+    }
+}
+
+static void generate_lulog_unsigned_data(CodeGenContext *context) {
+    if (!context->buffered_output) {
+        generate_console_lulog_data(context);
+    }
+}
+
+static void generate_lulog_unsigned(CodeGenContext *context) {
+    if (context->buffered_output) {
+        generate_buffered_lulog_unsigned(context);
+    } else {
+        generate_console_lulog_unsigned(context);
+    }
+}
+
+// DI = output_length, after flushing if a number might not fit
+static void generate_reserve_output(CodeGenContext *context) {
+    write_label(context, "reserve_output");
+    write_instruction(context, "mov di, output_length");
+    write_instruction(context, "cmp di, %d", OUTPUT_BUFFER_SIZE - LULOG_MAX_LENGTH);
+    write_instruction(context, "jbe reserve_output_done");
+    write_instruction(context, "call flush_output");
+    write_instruction(context, "xor di, di");
+    write_label(context, "reserve_output_done");
+    write_instruction(context, "ret");
+}
+
+static void generate_output_data(CodeGenContext *context) {
+    write_line(context, "output_length dw 0 ; Bytes waiting in output_buffer");
+    write_line(context, "output_buffer db %d dup(?)", OUTPUT_BUFFER_SIZE);
+}
+
+// Write the buffer to stdout with one DOS call; all registers survive
+static void generate_flush_output(CodeGenContext *context) {
+    write_label(context, "flush_output");
+    write_instruction(context, "push ax");
+    write_instruction(context, "push bx");
+    write_instruction(context, "push cx");
+    write_instruction(context, "push dx");
+    write_instruction(context, "mov cx, output_length");
+    write_instruction(context, "jcxz flush_output_done");
+    write_instruction(context, "mov ah, 40h");         // DOS function 40h: write to handle
+    write_instruction(context, "mov bx, 1");           // Standard output
+    write_instruction(context, "mov dx, offset output_buffer");
+    write_instruction(context, "int 21h");
+    write_instruction(context, "mov output_length, 0");
+    write_label(context, "flush_output_done");
+    write_instruction(context, "pop dx");
+    write_instruction(context, "pop cx");
+    write_instruction(context, "pop bx");
+    write_instruction(context, "pop ax");
+    write_instruction(context, "ret");
+}
+
+// Append `count` bytes from `bytes` to output_buffer (buffered output only)
+static void write_buffered_bytes(CodeGenContext *context, const char *bytes, int count) {
+    write_instruction(context, "push di");
+    write_instruction(context, "call reserve_output");
+    for (int i = 0; i < count; i++) {
+        char index[8] = "di";
+        if (i > 0) snprintf(index, sizeof(index), "di+%d", i);
+        if (bytes[i] >= ' ' && bytes[i] != '\'') {
+            write_instruction(context, "mov output_buffer[%s], '%c'", index, bytes[i]);
+        } else {
+            write_instruction(context, "mov output_buffer[%s], %d", index, bytes[i]);
+        }
+    }
+    write_instruction(context, "add di, %d", count);
+    write_instruction(context, "mov output_length, di");
+    write_instruction(context, "pop di");
+}
+
+// print_text: print the '$'-terminated string at offset AX (lulog of
+// constants formatted at compile time). Buffered output copies it into
+// output_buffer, flushing whenever the buffer fills up.
+static void generate_print_text(CodeGenContext *context) {
+    write_comment(context, "Print a constant string");
+    write_label(context, "print_text");
+    if (!context->buffered_output) {
+        write_instruction(context, "mov dx, ax");
+        write_instruction(context, "mov ah, 9");       // DOS function 9: print string
+        write_instruction(context, "int 21h");
+        write_instruction(context, "ret");
+        return;
+    }
+
+    write_instruction(context, "mov si, ax");
+    write_instruction(context, "mov di, output_length");
+    write_label(context, "print_text_next");
+    write_instruction(context, "mov al, [si]");
+    write_instruction(context, "cmp al, '$'");
+    write_instruction(context, "je print_text_done");
+    write_instruction(context, "cmp di, %d", OUTPUT_BUFFER_SIZE);
+    write_instruction(context, "jb print_text_store");
+    write_instruction(context, "mov output_length, di");
+    write_instruction(context, "call flush_output");
+    write_instruction(context, "xor di, di");
+    write_label(context, "print_text_store");
+    write_instruction(context, "mov output_buffer[di], al");
+    write_instruction(context, "inc di");
+    write_instruction(context, "inc si");
+    write_instruction(context, "jmp print_text_next");
+    write_label(context, "print_text_done");
+    write_instruction(context, "mov output_length, di");
+    write_instruction(context, "ret");
+}
+
+static void generate_luload_data(CodeGenContext *context) {
+    // The buffered prompt is stored byte by byte instead
+    if (!context->buffered_output) {
+        write_line(context, "input_prompt db '? $'");
+    }
+}
+
+// luload: parse a number from the next line of input. Input is read into
+// input_buffer a block at a time, so most calls need no DOS call at all.
+// A leading '-' negates the number, other characters that are not digits
+// are skipped, the line ends at CR (the LF after it is skipped by the next
+// call) and the end of input reads as an empty line (0).
+static void generate_luload(CodeGenContext *context) {
+    write_comment(context, "Read an integer from the next input line into AX");
+    write_label(context, "luload");
+
+    // Prompt (buffered output reaches the screen before input is read)
+    if (context->buffered_output) {
+        write_buffered_bytes(context, "? ", 2);
+    } else {
+        write_instruction(context, "mov ah, 9");   // DOS function 9: print string
+        write_instruction(context, "mov dx, offset input_prompt");
+        write_instruction(context, "int 21h");
+    }
+
+    write_instruction(context, "xor bx, bx");      // BX = value so far
+    write_instruction(context, "xor cx, cx");      // CX = 1 for a negative number
+    write_label(context, "luload_start");
+    write_instruction(context, "call read_input");
+    write_instruction(context, "cmp al, 10");      // LF left over from the previous line
+    write_instruction(context, "je luload_start");
+    write_instruction(context, "cmp al, '-'");
+    write_instruction(context, "jne luload_char");
+    write_instruction(context, "mov cx, 1");
+    write_label(context, "luload_next");
+    write_instruction(context, "call read_input");
+    write_label(context, "luload_char");
+    write_instruction(context, "cmp al, 13");      // CR ends the number
+    write_instruction(context, "je luload_done");
+    write_instruction(context, "cmp al, '0'");     // Anything else but a digit is skipped
+    write_instruction(context, "jb luload_next");
+    write_instruction(context, "cmp al, '9'");
+    write_instruction(context, "ja luload_next");
+    write_instruction(context, "sub al, '0'");
+    write_instruction(context, "mov ah, 0");
+    write_instruction(context, "xchg ax, bx");     // AX = value, BX = digit
+    write_instruction(context, "mov dx, 10");
+    write_instruction(context, "mul dx");
+    write_instruction(context, "add bx, ax");      // BX = value * 10 + digit
+    write_instruction(context, "jmp luload_next");
+
+    // Move to the next line, then apply the sign
+    write_label(context, "luload_done");
+    if (context->buffered_output) {
+        write_buffered_bytes(context, "\r\n", 2);
+    } else {
+        write_instruction(context, "mov ah, 2");   // DOS function 2: output character
+        write_instruction(context, "mov dl, 13");
+        write_instruction(context, "int 21h");
+        write_instruction(context, "mov dl, 10");
+        write_instruction(context, "int 21h");
+    }
+    write_instruction(context, "mov ax, bx");
+    write_instruction(context, "jcxz luload_return");
+    write_instruction(context, "neg ax");
+    write_label(context, "luload_return");
+    write_instruction(context, "ret");
+}
+
+static void generate_input_data(CodeGenContext *context) {
+    write_line(context, "input_length dw 0 ; Bytes read into input_buffer");
+    write_line(context, "input_position dw 0 ; Next byte luload parses");
+    write_line(context, "input_buffer db %d dup(?)", INPUT_BUFFER_SIZE);
+}
+
+// AL = next input character (CR at the end of input); only AX changes.
+// Characters already in input_buffer cost no more than saving SI.
+static void generate_read_input(CodeGenContext *context) {
+    write_label(context, "read_input");
+    write_instruction(context, "push si");
+    write_instruction(context, "mov si, input_position");
+    write_instruction(context, "cmp si, input_length");
+    write_instruction(context, "jb read_input_take");
+    if (context->buffered_output) {
+        write_instruction(context, "call flush_output");
+    }
+    write_instruction(context, "push bx");
+    write_instruction(context, "push cx");
+    write_instruction(context, "push dx");
+    write_instruction(context, "mov ah, 3Fh");     // DOS function 3Fh: read from handle
+    write_instruction(context, "xor bx, bx");      // Standard input
+    write_instruction(context, "mov cx, %d", INPUT_BUFFER_SIZE);
+    write_instruction(context, "mov dx, offset input_buffer");
+    write_instruction(context, "int 21h");
+    write_instruction(context, "pop dx");          // pop and mov keep the carry
+    write_instruction(context, "pop cx");
+    write_instruction(context, "pop bx");
+    write_instruction(context, "mov si, 0");
+    write_instruction(context, "jc read_input_end");
+    write_instruction(context, "mov input_length, ax");
+    write_instruction(context, "test ax, ax");
+    write_instruction(context, "jnz read_input_take");
+    write_label(context, "read_input_end");
+    write_instruction(context, "mov input_length, 0");
+    write_instruction(context, "mov input_position, 0");
+    write_instruction(context, "mov al, 13");
+    write_instruction(context, "jmp read_input_done");
+    write_label(context, "read_input_take");
+    write_instruction(context, "mov al, input_buffer[si]");
+    write_instruction(context, "inc si");
+    write_instruction(context, "mov input_position, si");
+    write_label(context, "read_input_done");
+    write_instruction(context, "pop si");
+    write_instruction(context, "ret");
+}
+
+// Fragments are emitted in this order: lulog jumps into lulog_unsigned's
+// code, so the two stay together
+static const RuntimeFragmentInfo runtime_fragments[RUNTIME_FRAGMENT_COUNT] = {
+    [RUNTIME_LULOG] = {
+        .requires = RUNTIME_BIT(RUNTIME_LULOG_UNSIGNED),
+        .requires_buffered = RUNTIME_BIT(RUNTIME_RESERVE_OUTPUT),
+        .generate_data = NULL, .generate_code = generate_lulog
+    },
+    [RUNTIME_LULOG_UNSIGNED] = {
+        .requires = 0,
+        .requires_buffered = RUNTIME_BIT(RUNTIME_RESERVE_OUTPUT),
+        .generate_data = generate_lulog_unsigned_data, .generate_code = generate_lulog_unsigned
+    },
+    [RUNTIME_PRINT_TEXT] = {
+        .requires = 0,
+        .requires_buffered = RUNTIME_BIT(RUNTIME_FLUSH_OUTPUT),
+        .generate_data = NULL, .generate_code = generate_print_text
+    },
+    [RUNTIME_LULOAD] = {
+        .requires = RUNTIME_BIT(RUNTIME_READ_INPUT),
+        .requires_buffered = RUNTIME_BIT(RUNTIME_RESERVE_OUTPUT),
+        .generate_data = generate_luload_data, .generate_code = generate_luload
+    },
+    [RUNTIME_READ_INPUT] = {
+        .requires = 0,
+        .requires_buffered = RUNTIME_BIT(RUNTIME_FLUSH_OUTPUT),
+        .generate_data = generate_input_data, .generate_code = generate_read_input
+    },
+    [RUNTIME_RESERVE_OUTPUT] = {
+        .requires = RUNTIME_BIT(RUNTIME_FLUSH_OUTPUT),
+        .requires_buffered = 0,
+        .generate_data = NULL, .generate_code = generate_reserve_output
+    },
+    [RUNTIME_FLUSH_OUTPUT] = {
+        .requires = 0,
+        .requires_buffered = 0,
+        .generate_data = generate_output_data, .generate_code = generate_flush_output
+    }
+};
+
+void use_runtime(CodeGenContext *context, RuntimeFragment fragment) {
+    context->runtime_used |= RUNTIME_BIT(fragment);
+}
+
+int runtime_clobbers(const CodeGenContext *context, RuntimeFragment fragment) {
+    switch (fragment) {
+        case RUNTIME_LULOG:
+        case RUNTIME_LULOG_UNSIGNED: {
+            int clobbers = REG_BIT(REG_AX) | REG_BIT(REG_DX) | REG_BIT(REG_DI);
+            if (divide_digits(target_costs(context->target))) clobbers |= REG_BIT(REG_BX) | REG_BIT(REG_CX);
+            return clobbers;
+        }
+        case RUNTIME_PRINT_TEXT:
+            return context->buffered_output ? REG_BIT(REG_AX) | REG_BIT(REG_SI) | REG_BIT(REG_DI)
+                                            : REG_BIT(REG_AX) | REG_BIT(REG_DX);
+        case RUNTIME_LULOAD:
+            return REG_BIT(REG_AX) | REG_BIT(REG_BX) | REG_BIT(REG_CX) | REG_BIT(REG_DX);
+        case RUNTIME_READ_INPUT:
+            return REG_BIT(REG_AX);
+        case RUNTIME_RESERVE_OUTPUT:
+            return REG_BIT(REG_DI);
+        default:
+            return 0;
+    }
+}
+
+void resolve_runtime(CodeGenContext *context) {
+    unsigned used = context->runtime_used;
+    unsigned previous;
+    do {
+        previous = used;
+        for (int i = 0; i < RUNTIME_FRAGMENT_COUNT; i++) {
+            if (!(used & RUNTIME_BIT(i))) continue;
+            used |= runtime_fragments[i].requires;
+            if (context->buffered_output) used |= runtime_fragments[i].requires_buffered;
+        }
+    } while (used != previous);
+    context->runtime_used = used;
+}
+
+void generate_runtime_data(CodeGenContext *context) {
+    for (int i = 0; i < RUNTIME_FRAGMENT_COUNT; i++) {
+        if ((context->runtime_used & RUNTIME_BIT(i)) && runtime_fragments[i].generate_data) {
+            runtime_fragments[i].generate_data(context);
+        }
+    }
+}
+
+void generate_runtime_code(CodeGenContext *context) {
+    // Initialize the data segment, run main, then write what is still
+    // buffered and exit to DOS
+    write_label(context, "main_init");
+    write_instruction(context, "mov ax, data");
+    write_instruction(context, "mov ds, ax");
+    write_instruction(context, "call main");
+    if (context->runtime_used & RUNTIME_BIT(RUNTIME_FLUSH_OUTPUT)) {
+        write_instruction(context, "call flush_output");
+    }
+    write_instruction(context, "mov ax, 4c00h"); // DOS exit with code 0
+    write_instruction(context, "int 21h");       // Call DOS
+
+    for (int i = 0; i < RUNTIME_FRAGMENT_COUNT; i++) {
+        if (context->runtime_used & RUNTIME_BIT(i)) {
+            runtime_fragments[i].generate_code(context);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "codegen.h"
+
+// Runtime library linked into every program as assembly fragments.
+// Generated code records each routine it calls with use_runtime; once all
+// functions are generated only those fragments, the ones they call in
+// turn, and the data they own are emitted.
+typedef enum {
+    RUNTIME_LULOG,               // lulog: print a signed number and a newline
+    RUNTIME_LULOG_UNSIGNED,      // lulog_unsigned: the same for a value known to be non-negative
+    RUNTIME_PRINT_TEXT,          // print_text: print the '$'-terminated string at AX
+    RUNTIME_LULOAD,              // luload: read a number from the next input line
+    RUNTIME_READ_INPUT,          // read_input: next input character, refilling input_buffer
+    RUNTIME_RESERVE_OUTPUT,      // reserve_output: room for a number in output_buffer
+    RUNTIME_FLUSH_OUTPUT,        // flush_output: write output_buffer to stdout
+    RUNTIME_FRAGMENT_COUNT
+} RuntimeFragment;
+
+#define RUNTIME_BIT(fragment) (1u << (fragment))
+
+// Record that the code being generated calls `fragment`
+void use_runtime(CodeGenContext *context, RuntimeFragment fragment);
+
+// Registers a call of `fragment` may change (REG_BIT set); every other
+// register keeps its value. The argument (lulog, print_text) is passed in
+// AX and the result (luload) comes back in AX: nothing goes on the stack.
+int runtime_clobbers(const CodeGenContext *context, RuntimeFragment fragment);
+
+// Add the fragments the recorded ones depend on to context->runtime_used
+void resolve_runtime(CodeGenContext *context);
+
+// Data of the used fragments (inside the data segment)
+void generate_runtime_data(CodeGenContext *context);
+
+// Program entry (main_init) and the code of the used fragments
+void generate_runtime_code(CodeGenContext *context);
+
+#endif // RUNTIME_H
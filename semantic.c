@@ -1,4 +1,6 @@
 #include "semantic.h"
+#include "range_analysis.h"
+#include "constant_fold.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,10 +17,22 @@ static bool analyze_luload_statement(SemanticContext *context, ASTNode *luload);
 static bool analyze_return_statement(SemanticContext *context, ASTNode *ret);
 static bool analyze_condition(SemanticContext *context, ASTNode *cond);
 static bool analyze_function_call(SemanticContext *context, ASTNode *call);
+static const char* function_call_type(SemanticContext *context, ASTNode *call);
 static bool analyze_binary_operation(SemanticContext *context, ASTNode *binary_op);
 static bool check_assignment_type(SemanticContext *context, const char *var_type, 
                                  const char *expr_type, int line);
 
+// Set up a context with no function, errors or pool
+static void init_semantic_context(SemanticContext *context, SymbolTable *symbol_table) {
+    context->symbol_table = symbol_table;
+    context->current_function = NULL;
+    context->current_function_return_type = NULL;
+    context->error_count = 0;
+    context->error_message[0] = '\0';
+    context->defer_errors = false;
+    context->pool = NULL;
+}
+
 // Initialize semantic analyzer
 SemanticContext* initialize_semantic_analyzer(SymbolTable *symbol_table) {
     SemanticContext *context = (SemanticContext *)malloc(sizeof(SemanticContext));
@@ -27,12 +41,7 @@ SemanticContext* initialize_semantic_analyzer(SymbolTable *symbol_table) {
         return NULL;
     }
     
-    context->symbol_table = symbol_table;
-    context->current_function = NULL;
-    context->current_function_return_type = NULL;
-    context->error_count = 0;
-    context->error_message[0] = '\0';
-    
+    init_semantic_context(context, symbol_table);
     return context;
 }
 
@@ -49,6 +58,13 @@ void free_semantic_analyzer(SemanticContext *context) {
     }
 }
 
+// Print the first recorded semantic error and stop compilation
+static void exit_on_semantic_error(SemanticContext *context) {
+    fprintf(stderr, "FATAL: %s\n", context->error_message);
+    fprintf(stderr, "       Please fix the semantic errors before continuing.\n");
+    exit(1);
+}
+
 // Report a semantic error
 void report_semantic_error(SemanticContext *context, SemanticErrorType error, 
                          const char *message, int line) {
@@ -83,11 +99,6 @@ void report_semantic_error(SemanticContext *context, SemanticErrorType error,
             break;
     }
     
-    fprintf(stderr, "FATAL: Semantic error [%s] at line %d: %s\n", error_type_str, line, message);
-    fprintf(stderr, "       Please fix the semantic errors before continuing.\n");
-    
-    // Immediately exit on semantic error
-    exit(1);
     context->error_count++;
     
     // Store the error message if it's the first one
@@ -95,6 +106,40 @@ void report_semantic_error(SemanticContext *context, SemanticErrorType error,
         snprintf(context->error_message, sizeof(context->error_message), 
                  "Semantic error [%s] at line %d: %s", error_type_str, line, message);
     }
+    
+    // Per-function analysis reports its first error once the earlier functions are done
+    if (context->defer_errors) return;
+    
+    // Immediately exit on semantic error
+    exit_on_semantic_error(context);
+}
+
+// Analysis of one function body, run as a pool task
+typedef struct {
+    SemanticContext context;     // Private context (errors deferred)
+    SemanticContext *parent;     // Context of the whole program
+    ASTNode *function;           // Function to analyze
+    SymbolTable *locals;         // Parameters and locals of the function
+    StringBuffer trace;          // Trace output of the function
+    StringBuffer errors;         // Error output of the function
+    bool success;
+} FunctionAnalysis;
+
+// Analyze one function against a local table layered on the global one
+static void analyze_function_task(void *item) {
+    FunctionAnalysis *task = (FunctionAnalysis *)item;
+    
+    task->locals = create_local_symbol_table(task->parent->symbol_table);
+    if (!task->locals) {
+        task->success = false;
+        return;
+    }
+    task->locals->trace_output = &task->trace;
+    task->locals->error_output = &task->errors;
+    
+    init_semantic_context(&task->context, task->locals);
+    task->context.defer_errors = true;
+    task->success = analyze_function(&task->context, task->function);
 }
 
 // Perform semantic analysis on the AST
@@ -106,17 +151,66 @@ bool analyze_semantics(SemanticContext *context, ASTNode *root) {
         return false;
     }
     
-    // Analyze each function in the program
-    bool success = true;
+    // Declare every function first; the bodies then only read the global scope
+    int function_count = 0;
     for (int i = 0; i < root->num_children; i++) {
         ASTNode *child = root->children[i];
         if (child->type == NODE_FUNCTION) {
-            if (!analyze_function(context, child)) {
-                success = false;
-            }
+            declare_function(context->symbol_table, child);
+            function_count++;
+        }
+    }
+    
+    FunctionAnalysis *tasks = (FunctionAnalysis *)calloc(function_count ? function_count : 1, sizeof(FunctionAnalysis));
+    void **items = (void **)malloc(sizeof(void *) * (function_count ? function_count : 1));
+    if (!tasks || !items) {
+        fprintf(stderr, "Failed to allocate memory for semantic analysis\n");
+        free(tasks);
+        free(items);
+        return false;
+    }
+    
+    int n = 0;
+    for (int i = 0; i < root->num_children; i++) {
+        if (root->children[i]->type == NODE_FUNCTION) {
+            tasks[n].parent = context;
+            tasks[n].function = root->children[i];
+            init_string_buffer(&tasks[n].trace);
+            init_string_buffer(&tasks[n].errors);
+            items[n] = &tasks[n];
+            n++;
         }
     }
     
+    // Analyze each function in the program
+    thread_pool_run(context->pool, analyze_function_task, items, function_count);
+    
+    // Report the results in source order, stopping at the first failing function
+    bool success = true;
+    for (int i = 0; i < function_count; i++) {
+        FunctionAnalysis *task = &tasks[i];
+        
+        fflush(stdout);
+        write_string_buffer(&task->trace, stdout);
+        fflush(stdout);
+        write_string_buffer(&task->errors, stderr);
+        free_string_buffer(&task->trace);
+        free_string_buffer(&task->errors);
+        
+        merge_symbol_table(context->symbol_table, task->locals);
+        
+        if (task->context.error_count > 0) {
+            context->error_count += task->context.error_count;
+            memcpy(context->error_message, task->context.error_message, sizeof(context->error_message));
+            exit_on_semantic_error(context);
+        }
+        if (!task->success) {
+            success = false;
+        }
+    }
+    
+    free(tasks);
+    free(items);
     return success && (context->error_count == 0);
 }
 
@@ -130,19 +224,19 @@ static bool are_types_compatible(const char *type1, const char *type2) {
 }
 
 // Get the type of an expression
-char* get_expression_type(SemanticContext *context, ASTNode *expr) {
+const char* get_expression_type(SemanticContext *context, ASTNode *expr) {
     if (!context || !expr) return NULL;
     
     switch (expr->type) {
         case NODE_NUMBER:
-            return strdup("int");
+            return "int";
             
         case NODE_STRING:
-            return strdup("string");
+            return "string";
             
         case NODE_LULOAD:
             // luload returns an integer value
-            return strdup("int");
+            return "int";
             
         case NODE_IDENTIFIER: {
             Symbol *symbol = lookup_symbol(context->symbol_table, expr->value);
@@ -152,32 +246,24 @@ char* get_expression_type(SemanticContext *context, ASTNode *expr) {
                 report_semantic_error(context, SEM_ERROR_UNDEFINED_VARIABLE, msg, 0);
                 return NULL;
             }
-            return strdup(symbol->data_type);
+            return symbol->data_type;
         }
         
         case NODE_BINARY_OP: {
-            char *left_type = get_expression_type(context, expr->children[0]);
-            char *right_type = get_expression_type(context, expr->children[1]);
+            const char *left_type = get_expression_type(context, expr->children[0]);
+            const char *right_type = get_expression_type(context, expr->children[1]);
             
-            if (!left_type || !right_type) {
-                free(left_type);
-                free(right_type);
-                return NULL;
-            }
+            if (!left_type || !right_type) return NULL;
             
             // Type checking for binary operations
             if (strcmp(left_type, "int") != 0 || strcmp(right_type, "int") != 0) {
                 char msg[128];
                 snprintf(msg, sizeof(msg), "Binary operation '%s' requires int operands", expr->value);
                 report_semantic_error(context, SEM_ERROR_TYPE_MISMATCH, msg, 0);
-                free(left_type);
-                free(right_type);
                 return NULL;
             }
             
-            free(left_type);
-            free(right_type);
-            return strdup("int");
+            return "int";
         }
         
         case NODE_EXPR: {
@@ -203,7 +289,7 @@ char* get_expression_type(SemanticContext *context, ASTNode *expr) {
                 }
                 
                 // Check the type of the right side
-                char *right_type = get_expression_type(context, expr->children[1]);
+                const char *right_type = get_expression_type(context, expr->children[1]);
                 if (!right_type) return NULL;
                 
                 // Check if types are compatible
@@ -211,18 +297,14 @@ char* get_expression_type(SemanticContext *context, ASTNode *expr) {
                     char msg[128];
                     snprintf(msg, sizeof(msg), "Cannot assign %s to %s", right_type, symbol->data_type);
                     report_semantic_error(context, SEM_ERROR_TYPE_MISMATCH, msg, 0);
-                    free(right_type);
                     return NULL;
                 }
                 
-                free(right_type);
-                return strdup(symbol->data_type);
+                return symbol->data_type;
             } 
             // Function call
             else {
-                // TODO: Implement function call type determination
-                // For now, we'll assume int return type
-                return strdup("int");
+                return function_call_type(context, expr);
             }
         }
         
@@ -247,38 +329,158 @@ static bool check_assignment_type(SemanticContext *context, const char *var_type
     return true;
 }
 
-// Analyze a function declaration
+// A declaration seen by the unused-variable check
+typedef struct {
+    ASTNode *declaration;
+    bool warn;                   // Locals only: parameters are part of the signature
+    bool read;
+} VariableUse;
+
+// Names resolve the way the lowering binds them: each block's declarations
+// hide outer ones until the block ends, and an initializer still sees the
+// variable the new one hides
+typedef struct {
+    VariableUse *uses;           // Every declaration, in source order
+    int use_count;
+    int use_capacity;
+    int *visible;                // Indices into `uses`, innermost last
+    int visible_count;
+    bool failed;
+} UseWalk;
+
+static void bind_use(UseWalk *walk, ASTNode *declaration, bool warn) {
+    if (walk->failed) return;
+    if (walk->use_count >= walk->use_capacity) {
+        int capacity = walk->use_capacity ? walk->use_capacity * 2 : 16;
+        VariableUse *uses = (VariableUse *)realloc(walk->uses, sizeof(VariableUse) * capacity);
+        int *visible = (int *)realloc(walk->visible, sizeof(int) * capacity);
+        if (uses) walk->uses = uses;
+        if (visible) walk->visible = visible;
+        if (!uses || !visible) {
+            fprintf(stderr, "Failed to allocate memory for the unused variable check\n");
+            walk->failed = true;
+            return;
+        }
+        walk->use_capacity = capacity;
+    }
+    walk->uses[walk->use_count].declaration = declaration;
+    walk->uses[walk->use_count].warn = warn;
+    walk->uses[walk->use_count].read = false;
+    walk->visible[walk->visible_count++] = walk->use_count++;
+}
+
+// Declaration `name` refers to here, or NULL
+static VariableUse* resolve_use(UseWalk *walk, const char *name) {
+    for (int i = walk->visible_count - 1; i >= 0; i--) {
+        VariableUse *use = &walk->uses[walk->visible[i]];
+        if (strcmp(use->declaration->value, name) == 0) return use;
+    }
+    return NULL;
+}
+
+// Mark the declarations read below `node`. The target of an assignment is
+// written, not read, and a read that only computes the variable's own next
+// value (`x = x + 1`, `updated` is x) does not count either.
+static void mark_reads(UseWalk *walk, ASTNode *node, VariableUse *updated) {
+    if (walk->failed) return;
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            VariableUse *use = resolve_use(walk, node->value);
+            if (use && use != updated) use->read = true;
+            return;
+        }
+
+        case NODE_BLOCK: {
+            int visible = walk->visible_count;
+            for (int i = 0; i < node->num_children; i++) {
+                mark_reads(walk, node->children[i], NULL);
+            }
+            walk->visible_count = visible;
+            return;
+        }
+
+        case NODE_VAR_DECL:
+            for (int i = 0; i < node->num_children; i++) {
+                mark_reads(walk, node->children[i], NULL);
+            }
+            bind_use(walk, node, true);
+            return;
+
+        default:
+            break;
+    }
+
+    bool assignment = node->type == NODE_EXPR && node->value && strcmp(node->value, "=") == 0 &&
+                      node->num_children > 0 && node->children[0]->type == NODE_IDENTIFIER;
+    if (assignment) updated = resolve_use(walk, node->children[0]->value);
+    for (int i = assignment ? 1 : 0; i < node->num_children; i++) {
+        mark_reads(walk, node->children[i], updated);
+    }
+}
+
+// Warn about each local variable of the function that is never read. A
+// variable is checked on its own: another variable of the same name being
+// read elsewhere does not count.
+static void warn_unused_variables(SemanticContext *context, ASTNode *function, ASTNode *body) {
+    UseWalk walk;
+    memset(&walk, 0, sizeof(walk));
+
+    ASTNode *params = find_child(function, NODE_PARAM);
+    for (int i = 0; params && i < params->num_children; i++) {
+        ASTNode *param = params->children[i];
+        if (param->type == NODE_PARAM || param->type == NODE_VAR_DECL) bind_use(&walk, param, false);
+    }
+    mark_reads(&walk, body, NULL);
+
+    for (int i = 0; !walk.failed && i < walk.use_count; i++) {
+        if (walk.uses[i].warn && !walk.uses[i].read) {
+            symbol_table_error(context->symbol_table, "Warning: variable '%s' in function '%s' is never read\n",
+                               walk.uses[i].declaration->value, context->current_function);
+        }
+    }
+    free(walk.uses);
+    free(walk.visible);
+}
+
+// Analyze a function declaration.
+// Parameters and locals are declared as the walk reaches them, so the
+// symbol table is built and checked in this single traversal.
 static bool analyze_function(SemanticContext *context, ASTNode *function) {
     if (!context || !function || function->type != NODE_FUNCTION) return false;
     
+    SymbolTable *table = context->symbol_table;
+    
     // Save current function context
     char *prev_func = context->current_function;
     char *prev_return_type = context->current_function_return_type;
     
     // Set current function context
     context->current_function = strdup(function->value);
+    context->current_function_return_type = strdup(get_declared_type(function, "void"));
     
-    // Get return type
-    const char *return_type = "void";  // Default if not found
-    for (int i = 0; i < function->num_children; i++) {
-        if (function->children[i]->type == NODE_TYPE) {
-            return_type = function->children[i]->value;
-            break;
-        }
-    }
-    context->current_function_return_type = strdup(return_type);
-    
-    // Process parameters (already added to symbol table during symbol table construction)
+    // Parameters live in the function scope, which the body shares
+    enter_scope(table);
+    symbol_table_trace(table, "Entered function scope %d for %s\n", table->scope_level, function->value);
+    declare_parameters(table, function);
     
     // Process function body
     bool success = true;
-    for (int i = 0; i < function->num_children; i++) {
-        if (function->children[i]->type == NODE_BLOCK) {
-            if (!analyze_block(context, function->children[i])) {
-                success = false;
-            }
-            break;
-        }
+    ASTNode *body = find_child(function, NODE_BLOCK);
+    if (body && !analyze_block(context, body)) {
+        success = false;
+    }
+    
+    symbol_table_trace(table, "Exiting function scope %d for %s\n", table->scope_level, function->value);
+    exit_scope(table);
+    
+    // Simplify the expressions once the body is known to be well-typed, then
+    // compute value ranges on the folded trees
+    if (success) {
+        if (body) warn_unused_variables(context, function, body);
+        fold_constants(function);
+    }
+    if (success && !analyze_value_ranges(context, function)) {
+        success = false;
     }
     
     // Restore previous function context
@@ -294,6 +496,15 @@ static bool analyze_function(SemanticContext *context, ASTNode *function) {
 static bool analyze_block(SemanticContext *context, ASTNode *block) {
     if (!context || !block || block->type != NODE_BLOCK) return false;
     
+    // A function body shares the function scope; any other block opens its own
+    bool function_body = is_function_body(block);
+    if (!function_body) {
+        enter_scope(context->symbol_table);
+        symbol_table_trace(context->symbol_table, "Entered block scope %d\n", context->symbol_table->scope_level);
+    } else {
+        symbol_table_trace(context->symbol_table, "Processing function body without new scope: %d\n", context->symbol_table->scope_level);
+    }
+    
     bool success = true;
     for (int i = 0; i < block->num_children; i++) {
         ASTNode *stmt = block->children[i];
@@ -348,12 +559,17 @@ static bool analyze_block(SemanticContext *context, ASTNode *block) {
                 break;
                 
             default:
-                fprintf(stderr, "Unexpected node type in block: %d\n", stmt->type);
+                symbol_table_error(context->symbol_table, "Unexpected node type in block: %d\n", stmt->type);
                 success = false;
                 break;
         }
     }
     
+    if (!function_body) {
+        symbol_table_trace(context->symbol_table, "Exiting block scope %d\n", context->symbol_table->scope_level);
+        exit_scope(context->symbol_table);
+    }
+    
     return success;
 }
 
@@ -361,31 +577,20 @@ static bool analyze_block(SemanticContext *context, ASTNode *block) {
 static bool analyze_variable_declaration(SemanticContext *context, ASTNode *var_decl) {
     if (!context || !var_decl || var_decl->type != NODE_VAR_DECL) return false;
     
-    const char *var_name = var_decl->value;
-    
-    // Get variable type
-    const char *var_type = "int";  // Default
-    for (int i = 0; i < var_decl->num_children; i++) {
-        if (var_decl->children[i]->type == NODE_TYPE) {
-            var_type = var_decl->children[i]->value;
-            break;
-        }
-    }
+    const char *var_type = get_declared_type(var_decl, "int");
     
-    // Check initializer if present
+    // Check initializer if present (before the variable itself is in scope)
     for (int i = 0; i < var_decl->num_children; i++) {
         ASTNode *child = var_decl->children[i];
         if (child->type != NODE_TYPE) {
-            char *expr_type = get_expression_type(context, child);
+            const char *expr_type = get_expression_type(context, child);
             if (!expr_type) return false;
             
-            bool result = check_assignment_type(context, var_type, expr_type, 0);
-            free(expr_type);
-            
-            if (!result) return false;
+            if (!check_assignment_type(context, var_type, expr_type, 0)) return false;
         }
     }
     
+    declare_variable(context->symbol_table, var_decl);
     return true;
 }
 
@@ -418,13 +623,10 @@ static bool analyze_expression(SemanticContext *context, ASTNode *expr) {
                 
                 // Check the right side
                 ASTNode *right = expr->children[1];
-                char *right_type = get_expression_type(context, right);
+                const char *right_type = get_expression_type(context, right);
                 if (!right_type) return false;
                 
-                bool result = check_assignment_type(context, symbol->data_type, right_type, 0);
-                free(right_type);
-                
-                return result;
+                return check_assignment_type(context, symbol->data_type, right_type, 0);
             }
             // Function call
             else {
@@ -521,12 +723,11 @@ static bool analyze_lulog_statement(SemanticContext *context, ASTNode *lulog) {
     // lulog can output any expression, so we just need to check that the expression is valid
     if (lulog->num_children > 0) {
         ASTNode *expr = lulog->children[0];
-        char *expr_type = get_expression_type(context, expr);
+        const char *expr_type = get_expression_type(context, expr);
         
         if (!expr_type) return false;
         
         // lulog can handle any type
-        free(expr_type);
         return true;
     }
     
@@ -575,7 +776,7 @@ static bool analyze_return_statement(SemanticContext *context, ASTNode *ret) {
     
     // Check the type of the returned expression
     ASTNode *expr = ret->children[0];
-    char *expr_type = get_expression_type(context, expr);
+    const char *expr_type = get_expression_type(context, expr);
     if (!expr_type) return false;
     
     if (!are_types_compatible(expected_type, expr_type)) {
@@ -583,11 +784,9 @@ static bool analyze_return_statement(SemanticContext *context, ASTNode *ret) {
         snprintf(msg, sizeof(msg), "Cannot return %s from function with return type %s",
                  expr_type, expected_type);
         report_semantic_error(context, SEM_ERROR_RETURN_TYPE_MISMATCH, msg, 0);
-        free(expr_type);
         return false;
     }
     
-    free(expr_type);
     return true;
 }
 
@@ -599,7 +798,7 @@ static bool analyze_condition(SemanticContext *context, ASTNode *cond) {
     
     // Conditions typically have a binary operation
     ASTNode *expr = cond->children[0];
-    char *expr_type = get_expression_type(context, expr);
+    const char *expr_type = get_expression_type(context, expr);
     
     if (!expr_type) return false;
     
@@ -608,22 +807,56 @@ static bool analyze_condition(SemanticContext *context, ASTNode *cond) {
         char msg[128];
         snprintf(msg, sizeof(msg), "Condition must be of type int, got %s", expr_type);
         report_semantic_error(context, SEM_ERROR_TYPE_MISMATCH, msg, 0);
-        free(expr_type);
         return false;
     }
     
-    free(expr_type);
     return true;
 }
 
+// Check a call against the declaration of the function: one argument of
+// the declared type per parameter. Returns the return type of the function
+// (NULL after an error).
+static const char* function_call_type(SemanticContext *context, ASTNode *call) {
+    Symbol *symbol = lookup_symbol(context->symbol_table, call->value);
+    if (!symbol || symbol->type != SYMBOL_FUNCTION) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Undefined function '%s'", call->value);
+        report_semantic_error(context, SEM_ERROR_UNDEFINED_FUNCTION, msg, 0);
+        return NULL;
+    }
+    
+    ASTNode *params = symbol->declaration ? find_child(symbol->declaration, NODE_PARAM) : NULL;
+    int expected = params ? params->num_children : 0;
+    if (call->num_children != expected) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Function '%s' expects %d argument(s), got %d",
+                 call->value, expected, call->num_children);
+        report_semantic_error(context, SEM_ERROR_PARAMETER_COUNT, msg, 0);
+        return NULL;
+    }
+    
+    for (int i = 0; i < call->num_children; i++) {
+        const char *argument_type = get_expression_type(context, call->children[i]);
+        if (!argument_type) return NULL;
+        
+        const char *param_type = get_declared_type(params->children[i], "int");
+        if (!are_types_compatible(param_type, argument_type)) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "Argument %d of '%s' must be %s, got %s",
+                     i + 1, call->value, param_type, argument_type);
+            report_semantic_error(context, SEM_ERROR_TYPE_MISMATCH, msg, 0);
+            return NULL;
+        }
+    }
+    
+    return symbol->data_type;
+}
+
 // Analyze a function call
 static bool analyze_function_call(SemanticContext *context, ASTNode *call) {
     if (!context || !call) return false;
     
-    // TODO: Implement function call analysis with parameter checking
-    // For now, we'll assume all function calls are valid
-    
-    return true;
+    return function_call_type(context, call) != NULL;
 }
 
 // Analyze a binary operation
@@ -632,14 +865,10 @@ static bool analyze_binary_operation(SemanticContext *context, ASTNode *binary_o
     
     if (binary_op->num_children < 2) return false;
     
-    char *left_type = get_expression_type(context, binary_op->children[0]);
-    char *right_type = get_expression_type(context, binary_op->children[1]);
+    const char *left_type = get_expression_type(context, binary_op->children[0]);
+    const char *right_type = get_expression_type(context, binary_op->children[1]);
     
-    if (!left_type || !right_type) {
-        free(left_type);
-        free(right_type);
-        return false;
-    }
+    if (!left_type || !right_type) return false;
     
     const char *op = binary_op->value;
     
@@ -649,8 +878,6 @@ static bool analyze_binary_operation(SemanticContext *context, ASTNode *binary_o
         strcmp(binary_op->children[1]->value, "0") == 0) {
         report_semantic_error(context, SEM_ERROR_DIVISION_BY_ZERO,
                             "Division by zero", 0);
-        free(left_type);
-        free(right_type);
         return false;
     }
     
@@ -660,12 +887,8 @@ static bool analyze_binary_operation(SemanticContext *context, ASTNode *binary_o
         snprintf(msg, sizeof(msg), "Binary operation '%s' requires int operands, got %s and %s",
                 op, left_type, right_type);
         report_semantic_error(context, SEM_ERROR_TYPE_MISMATCH, msg, 0);
-        free(left_type);
-        free(right_type);
         return false;
     }
     
-    free(left_type);
-    free(right_type);
     return true;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "parser.h"
 #include "symbol_table.h"
+#include "thread_pool.h"
 
 // Semantic error types
 typedef enum {
@@ -24,6 +25,8 @@ typedef struct {
     char *current_function_return_type;
     int error_count;
     char error_message[256];
+    bool defer_errors;           // Record errors instead of exiting (set for per-function analysis)
+    ThreadPool *pool;            // Workers for per-function analysis (NULL analyzes serially)
 } SemanticContext;
 
 // Initialize semantic analyzer
@@ -32,11 +35,16 @@ SemanticContext* initialize_semantic_analyzer(SymbolTable *symbol_table);
 // Free semantic analyzer
 void free_semantic_analyzer(SemanticContext *context);
 
-// Perform semantic analysis on the AST
+// Perform semantic analysis on the AST, declaring symbols in the context's
+// symbol table as they are encountered.
+// Functions are declared globally first; their bodies are then analyzed as
+// independent tasks on the context's pool against local symbol tables, and
+// the results (traces, errors, local symbols) are reported in source order.
 bool analyze_semantics(SemanticContext *context, ASTNode *root);
 
-// Check types of an expression
-char* get_expression_type(SemanticContext *context, ASTNode *expr);
+// Check types of an expression (the result is a static string or a symbol's
+// data type, so callers must not free it)
+const char* get_expression_type(SemanticContext *context, ASTNode *expr);
 
 // Report a semantic error
 void report_semantic_error(SemanticContext *context, SemanticErrorType error, 
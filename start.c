@@ -6,11 +6,19 @@
 #include "semantic.h"
 #include "symbol_table.h"
 #include "codegen.h"
+#include "inline.h"
+#include "thread_pool.h"
 
 int main(int argc, char** argv) {
     const char* version = "1.0";
     const char* input_file = NULL;
     const char* output_file = NULL;
+    int jobs = 1;
+    bool dump_ir = false;
+    bool buffered_output = true;
+    int optimization_level = 1;
+    int inline_limit = DEFAULT_INLINE_LIMIT;
+    TargetCPU target = TARGET_8086;
     
     // Process command line arguments
     for (int i = 1; i < argc; i++) {
@@ -19,6 +27,12 @@ int main(int argc, char** argv) {
             printf("Usage: %s [options] <source_file.lx>\n\n", argv[0]);
             printf("Options:\n");
             printf("  -o <file>       Specify output file name (default: source_file_name.asm)\n");
+            printf("  -j <N>          Analyze and generate functions on N threads (default: 1)\n");
+            printf("  -O<level>       Optimization level 0-2 (default: 1); -O2 is currently the same as -O1\n");
+            printf("  -finline-limit=<n>  Instructions inlining may add to a function, beyond calls of functions called once and of small leaf functions (default: %d)\n", DEFAULT_INLINE_LIMIT);
+            printf("  --march=<cpu>   Target processor: 8086, 186 or 286 (default: 8086)\n");
+            printf("  --dump-ir       Print the intermediate representation of every function\n");
+            printf("  --unbuffered-output  Print every lulog character at once instead of collecting the output (for interactive programs)\n");
             printf("  --help          Display this help message\n");
             printf("  --version       Display compiler version information\n");
             return 0;
@@ -34,6 +48,50 @@ int main(int argc, char** argv) {
                 printf("Error: Missing filename after -o option\n");
                 return 1;
             }
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            dump_ir = true;
+        } else if (strcmp(argv[i], "--unbuffered-output") == 0) {
+            buffered_output = false;
+        } else if (strncmp(argv[i], "--march=", 8) == 0) {
+            if (!parse_target(argv[i] + 8, &target)) {
+                printf("Error: Unknown target processor '%s'\n", argv[i] + 8);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-finline-limit=", 15) == 0) {
+            const char* limit = argv[i] + 15;
+            char* end;
+            long value = strtol(limit, &end, 10);
+            if (*limit == '\0' || *end != '\0' || value < 0 || value > 100000) {
+                printf("Error: Invalid inline limit '%s'\n", limit);
+                return 1;
+            }
+            inline_limit = (int)value;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            // Accept both "-j N" and "-jN"
+            const char* count = argv[i] + 2;
+            if (*count == '\0') {
+                if (i + 1 >= argc) {
+                    printf("Error: Missing thread count after -j option\n");
+                    return 1;
+                }
+                count = argv[++i];
+            }
+            jobs = atoi(count);
+            if (jobs < 1) {
+                printf("Error: Invalid thread count '%s'\n", count);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            // "-O" alone means -O1
+            const char* level = argv[i] + 2;
+            if (*level == '\0') {
+                optimization_level = 1;
+            } else if (level[0] >= '0' && level[0] <= '2' && level[1] == '\0') {
+                optimization_level = level[0] - '0';
+            } else {
+                printf("Error: Invalid optimization level '%s'\n", argv[i]);
+                return 1;
+            }
         } else if (argv[i][0] == '-') {
             printf("Error: Unknown option '%s'\n", argv[i]);
             printf("Use --help for more information\n");
@@ -278,8 +336,8 @@ int main(int argc, char** argv) {
     printf("Abstract Syntax Tree:\n");
     print_ast(parser->root, 0);
     
-    // Create symbol table
-    printf("\nBuilding symbol table...\n");
+    // Create symbol table (filled in during semantic analysis)
+    printf("\nBuilding symbol table and performing semantic analysis...\n");
     SymbolTable* symbol_table = create_symbol_table(100);
     if (!symbol_table) {
         printf("Failed to create symbol table\n");
@@ -287,29 +345,32 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    build_symbol_table(symbol_table, parser->root);
-    print_symbol_table(symbol_table);
+    // Functions are analyzed and generated as independent tasks on this pool
+    ThreadPool* pool = create_thread_pool(jobs);
     
-    // Semantic analysis
-    printf("\nPerforming semantic analysis...\n");
+    // Semantic analysis declares symbols as it walks the AST
     SemanticContext* semantic_context = initialize_semantic_analyzer(symbol_table);
     if (!semantic_context) {
         printf("Failed to initialize semantic analyzer\n");
+        free_thread_pool(pool);
         free_symbol_table(symbol_table);
         free_parser(parser);
         return 1;
     }
     
+    semantic_context->pool = pool;
     bool semantic_ok = analyze_semantics(semantic_context, parser->root);
     if (!semantic_ok) {
         printf("FATAL: Semantic analysis failed: %s\n", semantic_context->error_message);
         printf("       Please fix the semantic errors before continuing.\n");
         free_semantic_analyzer(semantic_context);
+        free_thread_pool(pool);
         free_symbol_table(symbol_table);
         free_parser(parser);
         return 1;
     }
     
+    print_symbol_table(symbol_table);
     printf("Semantic analysis successful\n");
     
     // Code generation
@@ -318,16 +379,24 @@ int main(int argc, char** argv) {
     if (!generator) {
         printf("Failed to initialize code generator\n");
         free_semantic_analyzer(semantic_context);
+        free_thread_pool(pool);
         free_symbol_table(symbol_table);
         free_parser(parser);
         return 1;
     }
     
+    generator->pool = pool;
+    generator->dump_ir = dump_ir;
+    generator->buffered_output = buffered_output;
+    generator->optimization_level = optimization_level;
+    generator->inline_limit = inline_limit;
+    generator->target = target;
     bool codegen_ok = generate_code(generator, parser->root);
     if (!codegen_ok) {
         printf("Code generation failed\n");
         free_code_generator(generator);
         free_semantic_analyzer(semantic_context);
+        free_thread_pool(pool);
         free_symbol_table(symbol_table);
         free_parser(parser);
         return 1;
@@ -339,6 +408,7 @@ int main(int argc, char** argv) {
     // Clean up
     free_code_generator(generator);
     free_semantic_analyzer(semantic_context);
+    free_thread_pool(pool);
     free_symbol_table(symbol_table);
     free_parser(parser);
     free_tokens(tokens);
@@ -0,0 +1,321 @@
+#include "strength_reduce.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Instructions built in place of one multiply or divide. Every candidate is
+// first built with `emit` off, which only adds up its cost.
+typedef struct {
+    IRFunction *function;
+    IRBlock *block;
+    IRInstr *position;           // New instructions go in front of it
+    const TargetCosts *costs;
+    IROperand source;            // Left operand of the replaced instruction
+    bool non_negative;           // Unsigned division: both operands are >= 0
+    bool emit;
+    int cost;                    // Clocks of the instructions built so far
+} Sequence;
+
+// Builds "x op constant" into a sequence and returns the result
+typedef IROperand (*Strategy)(Sequence *seq, IROperand x, int constant);
+
+static int wrap16(long value) {
+    return (short)(unsigned short)(value & 0xFFFF);
+}
+
+// log2 of a power of two, -1 for anything else
+static int power_of_two(int value) {
+    if (value <= 0 || (value & (value - 1)) != 0) return -1;
+    int shift = 0;
+    while ((1 << shift) != value) shift++;
+    return shift;
+}
+
+// imul/idiv/div with an immediate operand, as the code generator emits them
+static int multiply_cost(const TargetCosts *costs) {
+    if (costs->immediate_multiply) return costs->multiply_immediate;
+    return costs->move + costs->move_immediate + costs->multiply;
+}
+
+static int divide_cost(const TargetCosts *costs, bool non_negative) {
+    int setup = costs->move + costs->move_immediate;
+    // cwd, or xor dx, dx for the unsigned divide
+    if (non_negative) return setup + costs->alu + costs->unsigned_divide;
+    return setup + costs->sign_extend + costs->divide;
+}
+
+static int instruction_cost(const Sequence *seq, IROpcode op, IROperand a, IROperand b) {
+    const TargetCosts *costs = seq->costs;
+    int cost;
+    switch (op) {
+        case IR_MUL:   return multiply_cost(costs);
+        case IR_DIV:
+        case IR_MOD:   return divide_cost(costs, false);
+        case IR_UDIV:
+        case IR_UMOD:  return divide_cost(costs, true);
+        // The left operand moves into ax, the high word comes out in dx
+        case IR_MULHI: return costs->move + costs->move_immediate + costs->multiply;
+        case IR_SHL:   select_shift(costs, SHIFT_LEFT, b.value, &cost); break;
+        case IR_SHR:   select_shift(costs, SHIFT_RIGHT, b.value, &cost); break;
+        case IR_SAR:   select_shift(costs, SHIFT_RIGHT_ARITHMETIC, b.value, &cost); break;
+        default:       cost = costs->alu; break;
+    }
+    // The code is two-address: a source that is read again is copied first
+    if (a.kind == IR_OPERAND_VREG && ir_is_vreg(seq->source, a.value)) cost += costs->move;
+    return cost;
+}
+
+// Add "a op b" to the sequence
+static IROperand build(Sequence *seq, IROpcode op, IROperand a, IROperand b) {
+    seq->cost += instruction_cost(seq, op, a, b);
+    if (!seq->emit) return ir_vreg(0);
+
+    IRInstr *instr = ir_new_instr(seq->function, op, IR_TYPE_INT);
+    instr->dst = ir_vreg(ir_new_vreg(seq->function));
+    instr->a = a;
+    instr->b = b;
+    ir_insert_before(seq->block, seq->position, instr);
+    return instr->dst;
+}
+
+// Cost of a strategy, without building anything
+static int strategy_cost(const Sequence *seq, Strategy strategy, IROperand x, int constant) {
+    Sequence trial = *seq;
+    trial.emit = false;
+    trial.cost = 0;
+    strategy(&trial, x, constant);
+    return trial.cost;
+}
+
+// Multiplication
+
+// x * c as shifts and adds. In signed-digit (non-adjacent) form the
+// constant has the fewest non-zero digits; Horner's rule walks them from
+// the top, so only x and the partial result are live.
+static IROperand multiply_shift_add(Sequence *seq, IROperand x, int constant) {
+    int digits[17];
+    long value = (unsigned short)constant;
+    for (int bit = 0; bit < 17; bit++) {
+        digits[bit] = 0;
+        if (value & 1) {
+            digits[bit] = 2 - (int)(value & 3);
+            value -= digits[bit];
+        }
+        value >>= 1;
+    }
+
+    // A digit at bit 16 falls off the 16-bit result
+    IROperand result = ir_none();
+    int last = 0;
+    for (int bit = 15; bit >= 0; bit--) {
+        if (digits[bit] == 0) continue;
+        if (result.kind == IR_OPERAND_NONE) {
+            result = digits[bit] > 0 ? x : build(seq, IR_NEG, x, ir_none());
+        } else {
+            result = build(seq, IR_SHL, result, ir_imm(last - bit));
+            result = build(seq, digits[bit] > 0 ? IR_ADD : IR_SUB, result, x);
+        }
+        last = bit;
+    }
+    if (last > 0) result = build(seq, IR_SHL, result, ir_imm(last));
+    return result;
+}
+
+// x * c as -(x * -c)
+static IROperand multiply_negated(Sequence *seq, IROperand x, int constant) {
+    IROperand product = multiply_shift_add(seq, x, wrap16(-(long)constant));
+    return build(seq, IR_NEG, product, ir_none());
+}
+
+static IROperand multiply_keep(Sequence *seq, IROperand x, int constant) {
+    return build(seq, IR_MUL, x, ir_imm(constant));
+}
+
+// The cheapest way to compute x * c
+static IROperand build_multiply(Sequence *seq, IROperand x, int constant) {
+    Strategy strategies[] = { multiply_keep, multiply_shift_add, multiply_negated };
+    Strategy best = multiply_keep;
+    int best_cost = strategy_cost(seq, multiply_keep, x, constant);
+    for (int i = 1; i < 3; i++) {
+        int cost = strategy_cost(seq, strategies[i], x, constant);
+        if (cost < best_cost) {
+            best = strategies[i];
+            best_cost = cost;
+        }
+    }
+    return best(seq, x, constant);
+}
+
+// Division by a power of two
+
+// 2^k - 1 for a negative x, else 0: added before an arithmetic shift by k,
+// it makes the shift round towards zero like idiv
+static IROperand rounding_bias(Sequence *seq, IROperand x, int shift) {
+    if (shift == 1) return build(seq, IR_SHR, x, ir_imm(15));
+    IROperand sign = build(seq, IR_SAR, x, ir_imm(15));
+    return build(seq, IR_AND, sign, ir_imm((1 << shift) - 1));
+}
+
+static IROperand divide_power_of_two(Sequence *seq, IROperand x, int divisor) {
+    int shift = power_of_two(abs(divisor));
+    if (seq->non_negative) return build(seq, IR_SHR, x, ir_imm(shift));
+
+    IROperand bias = rounding_bias(seq, x, shift);
+    IROperand quotient = build(seq, IR_SAR, build(seq, IR_ADD, bias, x), ir_imm(shift));
+    return divisor < 0 ? build(seq, IR_NEG, quotient, ir_none()) : quotient;
+}
+
+// The remainder takes the sign of x, whatever the sign of the divisor:
+// ((x + bias) & (2^k - 1)) - bias
+static IROperand modulo_power_of_two(Sequence *seq, IROperand x, int divisor) {
+    int shift = power_of_two(abs(divisor));
+    int mask = (1 << shift) - 1;
+    if (seq->non_negative) return build(seq, IR_AND, x, ir_imm(mask));
+
+    IROperand bias = rounding_bias(seq, x, shift);
+    IROperand low = build(seq, IR_AND, build(seq, IR_ADD, bias, x), ir_imm(mask));
+    return build(seq, IR_SUB, low, bias);
+}
+
+// Division by other constants
+
+// Multiplier and shift for signed division by `divisor` (2 <= |divisor| <
+// 2^15), from Hacker's Delight, chapter 10: x / d is the high word of
+// x * multiplier, corrected by x when the multiplier's sign is off, shifted
+// right and rounded towards zero
+static void magic_number(int divisor, int *multiplier, int *shift) {
+    const unsigned two15 = 0x8000;
+    unsigned absolute = divisor < 0 ? -divisor : divisor;
+    unsigned t = two15 + (divisor < 0);
+    unsigned absolute_nc = t - 1 - t % absolute;    // |nc|, the largest dividend that needs no rounding
+    int p = 15;
+    unsigned q1 = two15 / absolute_nc, r1 = two15 - q1 * absolute_nc;
+    unsigned q2 = two15 / absolute, r2 = two15 - q2 * absolute;
+    unsigned delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= absolute_nc) {
+            q1++;
+            r1 -= absolute_nc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= absolute) {
+            q2++;
+            r2 -= absolute;
+        }
+        delta = absolute - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    int magic = wrap16(q2 + 1);
+    *multiplier = divisor < 0 ? wrap16(-(long)magic) : magic;
+    *shift = p - 16;
+}
+
+static IROperand divide_magic(Sequence *seq, IROperand x, int divisor) {
+    int multiplier, shift;
+    magic_number(divisor, &multiplier, &shift);
+
+    IROperand quotient = build(seq, IR_MULHI, x, ir_imm(multiplier));
+    if (divisor > 0 && multiplier < 0) quotient = build(seq, IR_ADD, quotient, x);
+    if (divisor < 0 && multiplier > 0) quotient = build(seq, IR_SUB, quotient, x);
+    if (shift > 0) quotient = build(seq, IR_SAR, quotient, ir_imm(shift));
+    if (seq->non_negative) return quotient;
+
+    // A negative quotient is one too small: add its sign bit. The quotient
+    // is read twice, so the shift works on a copy.
+    seq->cost += seq->costs->move;
+    IROperand sign = build(seq, IR_SHR, quotient, ir_imm(15));
+    return build(seq, IR_ADD, quotient, sign);
+}
+
+// x - (x / d) * d
+static IROperand modulo_magic(Sequence *seq, IROperand x, int divisor) {
+    IROperand quotient = divide_magic(seq, x, divisor);
+    return build(seq, IR_SUB, x, build_multiply(seq, quotient, divisor));
+}
+
+// Replacing an instruction
+
+static void reduce_instruction(IRFunction *function, IRBlock *block, IRInstr *instr, const TargetCosts *costs) {
+    // A constant left operand of a product goes to the right
+    if (instr->op == IR_MUL && instr->a.kind == IR_OPERAND_IMM && instr->b.kind == IR_OPERAND_VREG) {
+        IROperand swap = instr->a;
+        instr->a = instr->b;
+        instr->b = swap;
+    }
+    if (instr->a.kind != IR_OPERAND_VREG || instr->b.kind != IR_OPERAND_IMM) return;
+
+    int constant = instr->b.value;
+    Strategy candidates[2];
+    int candidate_count = 0;
+    switch (instr->op) {
+        case IR_MUL:
+            if (constant == 0) return;
+            candidates[candidate_count++] = multiply_shift_add;
+            candidates[candidate_count++] = multiply_negated;
+            break;
+        case IR_DIV:
+        case IR_UDIV:
+        case IR_MOD:
+        case IR_UMOD: {
+            // 0 is an error left to the program, and -1 and -32768 (where
+            // idiv can overflow) are rare enough to keep
+            if (constant == 0 || constant == 1 || constant == -1 || constant == -32768) return;
+            bool divide = instr->op == IR_DIV || instr->op == IR_UDIV;
+            if (power_of_two(abs(constant)) > 0) {
+                candidates[candidate_count++] = divide ? divide_power_of_two : modulo_power_of_two;
+            } else {
+                candidates[candidate_count++] = divide ? divide_magic : modulo_magic;
+            }
+            break;
+        }
+        default:
+            return;
+    }
+
+    Sequence seq = {
+        .function = function, .block = block, .position = instr, .costs = costs,
+        .source = instr->a, .non_negative = instr->op == IR_UDIV || instr->op == IR_UMOD,
+        .emit = false, .cost = 0
+    };
+
+    // The instruction stays unless a candidate is cheaper
+    Strategy best = NULL;
+    int best_cost = instruction_cost(&seq, instr->op, instr->a, instr->b);
+    for (int i = 0; i < candidate_count; i++) {
+        int cost = strategy_cost(&seq, candidates[i], instr->a, constant);
+        if (cost < best_cost) {
+            best = candidates[i];
+            best_cost = cost;
+        }
+    }
+    if (!best) return;
+
+    seq.emit = true;
+    IROperand result = best(&seq, instr->a, constant);
+
+    // The last instruction built defines the original result
+    IRInstr *last = instr->prev;
+    if (last && ir_is_vreg(last->dst, result.value) && result.kind == IR_OPERAND_VREG &&
+        !ir_is_vreg(instr->a, result.value)) {
+        last->dst = instr->dst;
+    } else {
+        IRInstr *move = ir_new_instr(function, IR_MOV, IR_TYPE_INT);
+        move->dst = instr->dst;
+        move->a = result;
+        ir_insert_before(block, instr, move);
+    }
+    ir_remove(block, instr);
+}
+
+void reduce_strength(IRFunction *function, const TargetCosts *costs) {
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        IRInstr *next;
+        for (IRInstr *instr = block->first; instr; instr = next) {
+            next = instr->next;
+            reduce_instruction(function, block, instr, costs);
+        }
+    }
+}
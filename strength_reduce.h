@@ -0,0 +1,16 @@
+#ifndef STRENGTH_REDUCE_H
+#define STRENGTH_REDUCE_H
+
+#include "ir.h"
+#include "target.h"
+
+// Strength reduction of multiplication, division and modulo by constants.
+// A product becomes shifts and adds/subtracts (the signed-digit form of the
+// constant), division and modulo by a power of two become shift and mask
+// sequences that round towards zero like idiv, and division by any other
+// constant multiplies by a "magic" reciprocal and keeps the high word.
+// Every candidate is priced with the target's clock counts and only
+// replaces the instruction if it is cheaper.
+void reduce_strength(IRFunction *function, const TargetCosts *costs);
+
+#endif // STRENGTH_REDUCE_H
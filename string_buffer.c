@@ -0,0 +1,79 @@
+#include "string_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Initialize an empty buffer
+void init_string_buffer(StringBuffer *buffer) {
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+// Free the buffer's storage
+void free_string_buffer(StringBuffer *buffer) {
+    if (!buffer) return;
+    free(buffer->data);
+    init_string_buffer(buffer);
+}
+
+// Make room for at least `extra` more characters plus the terminator
+bool buffer_reserve(StringBuffer *buffer, size_t extra) {
+    size_t needed = buffer->length + extra + 1;
+    if (needed <= buffer->capacity) return true;
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 256;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    char *data = (char *)realloc(buffer->data, capacity);
+    if (!data) {
+        fprintf(stderr, "Memory allocation failed for output buffer\n");
+        return false;
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+// Append text to the buffer
+bool buffer_append(StringBuffer *buffer, const char *text, size_t length) {
+    if (!buffer) return false;
+    if (length == 0) return true;   // `text` may be NULL then
+    if (!buffer_reserve(buffer, length)) return false;
+
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+    return true;
+}
+
+// Append formatted text to the buffer
+void buffer_vprintf(StringBuffer *buffer, const char *format, va_list args) {
+    if (!buffer) return;
+
+    // Measure first so the text can be formatted straight into the buffer
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+
+    if (length < 0 || !buffer_reserve(buffer, (size_t)length)) return;
+
+    vsnprintf(buffer->data + buffer->length, (size_t)length + 1, format, args);
+    buffer->length += (size_t)length;
+}
+
+void buffer_printf(StringBuffer *buffer, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    buffer_vprintf(buffer, format, args);
+    va_end(args);
+}
+
+// Write the buffer's contents to a file
+void write_string_buffer(const StringBuffer *buffer, FILE *file) {
+    if (!buffer || !file || buffer->length == 0) return;
+    fwrite(buffer->data, 1, buffer->length, file);
+}
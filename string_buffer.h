@@ -0,0 +1,35 @@
+#ifndef STRING_BUFFER_H
+#define STRING_BUFFER_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Growable text buffer for output that is collected now and written later
+typedef struct {
+    char *data;                  // Text (always NUL-terminated once allocated)
+    size_t length;               // Number of characters in use
+    size_t capacity;             // Allocated size of data
+} StringBuffer;
+
+// Initialize an empty buffer (no allocation until the first append)
+void init_string_buffer(StringBuffer *buffer);
+
+// Free the buffer's storage and leave it empty
+void free_string_buffer(StringBuffer *buffer);
+
+// Make room for at least `extra` more characters
+bool buffer_reserve(StringBuffer *buffer, size_t extra);
+
+// Append text to the buffer
+bool buffer_append(StringBuffer *buffer, const char *text, size_t length);
+
+// Append formatted text to the buffer
+void buffer_printf(StringBuffer *buffer, const char *format, ...);
+void buffer_vprintf(StringBuffer *buffer, const char *format, va_list args);
+
+// Write the buffer's contents to a file
+void write_string_buffer(const StringBuffer *buffer, FILE *file);
+
+#endif // STRING_BUFFER_H
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
 // Simple hash function for strings
 static unsigned int hash(const char *str, int size) {
@@ -29,10 +30,47 @@ SymbolTable* create_symbol_table(int size) {
     
     table->size = size;
     table->scope_level = 0;  // Start at global scope (level 0)
+    table->parent = NULL;
+    table->trace_output = NULL;
+    table->error_output = NULL;
     
     return table;
 }
 
+// Create a table for one function's locals
+SymbolTable* create_local_symbol_table(SymbolTable *parent) {
+    if (!parent) return NULL;
+    
+    // Same size as the parent so the bucket chains can be spliced when merging
+    SymbolTable *table = create_symbol_table(parent->size);
+    if (!table) return NULL;
+    
+    table->parent = parent;
+    table->scope_level = parent->scope_level;
+    return table;
+}
+
+// Move every symbol of a local table into its parent
+void merge_symbol_table(SymbolTable *parent, SymbolTable *local) {
+    if (!parent || !local) return;
+    
+    for (int i = 0; i < local->size; i++) {
+        Symbol *chain = local->buckets[i];
+        if (!chain) continue;
+        
+        // Put the local chain in front, as if the symbols had been added to the parent
+        Symbol *last = chain;
+        while (last->next) {
+            last = last->next;
+        }
+        last->next = parent->buckets[i];
+        parent->buckets[i] = chain;
+        local->buckets[i] = NULL;
+    }
+    
+    free_symbol_table(local);
+}
+
 // Free a symbol table
 void free_symbol_table(SymbolTable *table) {
     if (!table) return;
@@ -99,7 +137,7 @@ bool add_symbol(SymbolTable *table, const char *name, SymbolType type, const cha
     
     while (current) {
         if (current->scope_level == table->scope_level && strcmp(current->name, name) == 0) {
-            fprintf(stderr, "Symbol '%s' already defined at line %d\n", name, current->line_declared);
+            symbol_table_error(table, "Symbol '%s' already defined at line %d\n", name, current->line_declared);
             return false;
         }
         current = current->next;
@@ -117,6 +155,7 @@ bool add_symbol(SymbolTable *table, const char *name, SymbolType type, const cha
     new_symbol->type = type;
     new_symbol->scope_level = table->scope_level;
     new_symbol->line_declared = line;
+    new_symbol->declaration = NULL;
     
     // Add to beginning of list for this bucket
     new_symbol->next = table->buckets[index];
@@ -143,9 +182,38 @@ Symbol* lookup_symbol(SymbolTable *table, const char *name) {
         current = current->next;
     }
     
+    // Fall back to the enclosing table
+    if (!best_match && table->parent) {
+        return lookup_symbol(table->parent, name);
+    }
+    
     return best_match;
 }
 
+// Write a trace message for the table
+void symbol_table_trace(SymbolTable *table, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (table && table->trace_output) {
+        buffer_vprintf(table->trace_output, format, args);
+    } else {
+        vprintf(format, args);
+    }
+    va_end(args);
+}
+
+// Write an error message for the table
+void symbol_table_error(SymbolTable *table, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (table && table->error_output) {
+        buffer_vprintf(table->error_output, format, args);
+    } else {
+        vfprintf(stderr, format, args);
+    }
+    va_end(args);
+}
+
 // Print the symbol table (for debugging)
 void print_symbol_table(SymbolTable *table) {
     if (!table) return;
@@ -180,170 +248,52 @@ void print_symbol_table(SymbolTable *table) {
     printf("====================\n\n");
 }
 
-// Helper function to process function declarations
-static void process_function(SymbolTable *table, ASTNode *function_node) {
-    if (!table || !function_node || function_node->type != NODE_FUNCTION) return;
+// Declare a function in the current scope
+bool declare_function(SymbolTable *table, ASTNode *function_node) {
+    if (!table || !function_node || function_node->type != NODE_FUNCTION) return false;
     
-    // Get function name
     const char *function_name = function_node->value;
-    
-    // Find the return type
-    const char *return_type = "void";  // Default
-    for (int i = 0; i < function_node->num_children; i++) {
-        if (function_node->children[i]->type == NODE_TYPE) {
-            return_type = function_node->children[i]->value;
-            break;
-        }
-    }
+    const char *return_type = get_declared_type(function_node, "void");
     
     // Add function to symbol table
-    add_symbol(table, function_name, SYMBOL_FUNCTION, return_type, 0);  // Line number not available
-    printf("Added function %s with return type %s to scope %d\n", function_name, return_type, table->scope_level);
-    
-    // Enter new scope for function body
-    enter_scope(table);
-    printf("Entered function scope %d for %s\n", table->scope_level, function_name);
-    
-    // Process parameters
-    for (int i = 0; i < function_node->num_children; i++) {
-        if (function_node->children[i]->type == NODE_PARAM) {
-            ASTNode *param_list = function_node->children[i];
-            
-            // Process each parameter
-            for (int j = 0; j < param_list->num_children; j++) {
-                ASTNode *param = param_list->children[j];
-                // Parameters can be created as NODE_VAR_DECL (from parse_parameters) or NODE_PARAM
-                if (param->type == NODE_PARAM || param->type == NODE_VAR_DECL) {
-                    const char *param_name = param->value;
-                    const char *param_type = "int";  // Default
-                    
-                    // Find parameter type
-                    for (int k = 0; k < param->num_children; k++) {
-                        if (param->children[k]->type == NODE_TYPE) {
-                            param_type = param->children[k]->value;
-                            break;
-                        }
-                    }
-                    
-                    // Add parameter to symbol table
-                    add_symbol(table, param_name, SYMBOL_PARAMETER, param_type, 0);  // Line number not available
-                    printf("Added parameter %s of type %s to scope %d\n", param_name, param_type, table->scope_level);
-                }
-            }
-        }
+    bool added = add_symbol(table, function_name, SYMBOL_FUNCTION, return_type, 0);  // Line number not available
+    if (added) {
+        // Calls are checked against the parameter list
+        lookup_symbol(table, function_name)->declaration = function_node;
     }
-    
-    // Process function body 
-    for (int i = 0; i < function_node->num_children; i++) {
-        if (function_node->children[i]->type == NODE_BLOCK) {
-            // Don't enter a new scope here, as the block will do that itself
-            // Just directly process the block's children
-            ASTNode *block = function_node->children[i];
-            for (int j = 0; j < block->num_children; j++) {
-                build_symbol_table(table, block->children[j]);
-            }
-            break;
+    symbol_table_trace(table, "Added function %s with return type %s to scope %d\n", function_name, return_type, table->scope_level);
+    return added;
+}
+
+// Declare the parameters of a function in the current (function) scope
+void declare_parameters(SymbolTable *table, ASTNode *function_node) {
+    ASTNode *param_list = find_child(function_node, NODE_PARAM);
+    if (!table || !param_list) return;
+    
+    for (int i = 0; i < param_list->num_children; i++) {
+        ASTNode *param = param_list->children[i];
+        // Parameters can be created as NODE_VAR_DECL (from parse_parameters) or NODE_PARAM
+        if (param->type == NODE_PARAM || param->type == NODE_VAR_DECL) {
+            const char *param_type = get_declared_type(param, "int");
+            
+            // Add parameter to symbol table
+            add_symbol(table, param->value, SYMBOL_PARAMETER, param_type, 0);  // Line number not available
+            symbol_table_trace(table, "Added parameter %s of type %s to scope %d\n", param->value, param_type, table->scope_level);
         }
     }
-    
-    // Exit function scope
-    printf("Exiting function scope %d for %s\n", table->scope_level, function_name);
-    exit_scope(table);
 }
 
-// Helper function to process variable declarations
-static void process_variable(SymbolTable *table, ASTNode *var_node) {
-    if (!table || !var_node || var_node->type != NODE_VAR_DECL) return;
+// Declare a variable in the current scope
+bool declare_variable(SymbolTable *table, ASTNode *var_node) {
+    if (!table || !var_node || var_node->type != NODE_VAR_DECL) return false;
     
-    // Get variable name
     const char *var_name = var_node->value;
-    
-    // Find variable type
-    const char *var_type = "int";  // Default
-    for (int i = 0; i < var_node->num_children; i++) {
-        if (var_node->children[i]->type == NODE_TYPE) {
-            var_type = var_node->children[i]->value;
-            break;
-        }
-    }
+    const char *var_type = get_declared_type(var_node, "int");
     
     // Add variable to symbol table with current scope
-    add_symbol(table, var_name, SYMBOL_VARIABLE, var_type, 0);  // Line number not available
+    bool added = add_symbol(table, var_name, SYMBOL_VARIABLE, var_type, 0);  // Line number not available
     
     // Debug print
-    printf("Added variable %s of type %s to scope %d\n", var_name, var_type, table->scope_level);
+    symbol_table_trace(table, "Added variable %s of type %s to scope %d\n", var_name, var_type, table->scope_level);
+    return added;
 }
-
-// Recursive function to build symbol table from AST
-void build_symbol_table(SymbolTable *table, ASTNode *node) {
-    if (!table || !node) return;
-    
-    // Process current node
-    switch (node->type) {
-        case NODE_FUNCTION:
-            process_function(table, node);
-            break;
-            
-        case NODE_VAR_DECL:
-            process_variable(table, node);
-            break;
-            
-        case NODE_BLOCK:
-            // Check if the parent is a function node
-            // If so, don't enter a new scope as function already provides one
-            ASTNode *parent = node->parent;
-            bool is_function_body = (parent && parent->type == NODE_FUNCTION);
-            
-            if (!is_function_body) {
-                // Enter new scope for non-function blocks
-                enter_scope(table);
-                printf("Entered block scope %d\n", table->scope_level);
-            } else {
-                printf("Processing function body without new scope: %d\n", table->scope_level);
-            }
-            
-            // Process all statements in the block
-            for (int i = 0; i < node->num_children; i++) {
-                build_symbol_table(table, node->children[i]);
-            }
-            
-            // Exit block scope (only if we entered one)
-            if (!is_function_body) {
-                printf("Exiting block scope %d\n", table->scope_level);
-                exit_scope(table);
-            }
-            break;
-            
-        case NODE_IF:
-            // Process all children (condition, if-block, else-node)
-            for (int i = 0; i < node->num_children; i++) {
-                build_symbol_table(table, node->children[i]);
-            }
-            break;
-            
-        case NODE_ELSE:
-            // Process else block
-            for (int i = 0; i < node->num_children; i++) {
-                build_symbol_table(table, node->children[i]);
-            }
-            break;
-            
-        case NODE_LULOOP:
-            // Process all children (condition, loop-block)
-            for (int i = 0; i < node->num_children; i++) {
-                build_symbol_table(table, node->children[i]);
-            }
-            break;
-            
-        case NODE_PROGRAM:
-            // Process all top-level declarations
-            for (int i = 0; i < node->num_children; i++) {
-                build_symbol_table(table, node->children[i]);
-            }
-            break;
-            
-        default:
-            // Process other node types if needed
-            break;
-    }
-}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "parser.h"
+#include "string_buffer.h"
 
 // Symbol types
 typedef enum {
@@ -18,19 +19,31 @@ typedef struct Symbol {
     char *data_type;             // Data type (int, void, etc.)
     int scope_level;             // Scope level (0 for global, >0 for nested)
     int line_declared;           // Line number where the symbol is declared
+    ASTNode *declaration;        // Function node with the parameter list (functions only)
     struct Symbol *next;         // Next symbol in the same hash bucket
 } Symbol;
 
 // Symbol table structure
-typedef struct {
+typedef struct SymbolTable {
     Symbol **buckets;            // Hash table buckets
     int size;                    // Size of the hash table
     int scope_level;             // Current scope level
+    struct SymbolTable *parent;  // Read-only enclosing table searched on a miss (NULL for global)
+    StringBuffer *trace_output;  // Collects trace messages (NULL prints to stdout)
+    StringBuffer *error_output;  // Collects error messages (NULL prints to stderr)
 } SymbolTable;
 
 // Create a new symbol table
 SymbolTable* create_symbol_table(int size);
 
+// Create a table for one function's locals on top of a read-only parent.
+// Lookups that miss fall back to the parent, which is never modified, so
+// several local tables can be used concurrently.
+SymbolTable* create_local_symbol_table(SymbolTable *parent);
+
+// Move every symbol of a local table into its parent and free the local table
+void merge_symbol_table(SymbolTable *parent, SymbolTable *local);
+
 // Free a symbol table
 void free_symbol_table(SymbolTable *table);
 
@@ -46,10 +59,17 @@ bool add_symbol(SymbolTable *table, const char *name, SymbolType type, const cha
 // Look up a symbol in the table
 Symbol* lookup_symbol(SymbolTable *table, const char *name);
 
+// Write a trace or error message for the table (buffered if the table has buffers)
+void symbol_table_trace(SymbolTable *table, const char *format, ...);
+void symbol_table_error(SymbolTable *table, const char *format, ...);
+
 // Print the symbol table (for debugging)
 void print_symbol_table(SymbolTable *table);
 
-// Build the symbol table from an AST
-void build_symbol_table(SymbolTable *table, ASTNode *node);
+// Declare the symbols introduced by a function, its parameters or a variable
+// declaration, as the semantic analyzer walks the AST
+bool declare_function(SymbolTable *table, ASTNode *function_node);
+void declare_parameters(SymbolTable *table, ASTNode *function_node);
+bool declare_variable(SymbolTable *table, ASTNode *var_node);
 
 #endif // SYMBOL_TABLE_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "tail_call.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The call `block` ends with, if the function returns what it returns (or
+// nothing) right after it: the return follows the call, or is all of the
+// block the call jumps or falls through to. `exit` is set to the jump or
+// return after the call, or NULL.
+static IRInstr* tail_call(IRBlock *block, IRInstr **exit) {
+    IRInstr *last = block->last;
+    IRInstr *call = last;
+    IRInstr *ret = block->next ? block->next->first : NULL;
+    *exit = NULL;
+    if (last && ir_is_terminator(last->op)) {
+        *exit = last;
+        call = last->prev;
+        ret = last->op == IR_JUMP ? last->target->first : last;
+    }
+    if (!call || call->op != IR_CALL || !ret || ret->op != IR_RET) return NULL;
+    if (ret->a.kind != IR_OPERAND_NONE && !ir_is_vreg(ret->a, call->dst.value)) return NULL;
+    return call;
+}
+
+static bool is_self_call(const IRFunction *function, const IRInstr *call) {
+    return strcmp(call->callee, function->name) == 0;
+}
+
+// Slots of the parameters, by argument number: the lowering takes the
+// register arguments first thing and stores them into locals; the others
+// are parameter slots from [bp+4] up. Also finds the first instruction
+// after the register arguments are stored. False if some parameter has
+// no slot.
+static bool find_parameters(IRFunction *function, int count, int *slots, IRInstr **body) {
+    IRBlock *entry = function->first_block;
+    int taken[IR_REGISTER_ARGUMENTS] = { 0 };    // Virtual register of each argument
+    for (int i = 0; i < count; i++) {
+        slots[i] = -1;
+    }
+
+    IRInstr *instr = entry->first;
+    for (; instr && instr->op == IR_ARG; instr = instr->next) {
+        taken[instr->a.value] = instr->dst.value;
+    }
+    for (; instr && instr->op == IR_STORE && instr->a.kind == IR_OPERAND_VREG; instr = instr->next) {
+        bool argument = false;
+        for (int i = 0; i < count && i < IR_REGISTER_ARGUMENTS; i++) {
+            if (slots[i] < 0 && instr->a.value == taken[i]) {
+                slots[i] = instr->dst.value;
+                argument = true;
+            }
+        }
+        if (!argument) break;
+    }
+    *body = instr;
+
+    for (int slot = 0; slot < function->slot_count; slot++) {
+        const IRSlot *parameter = &function->slots[slot];
+        int argument = IR_REGISTER_ARGUMENTS + (parameter->offset - 4) / 2;
+        if (parameter->parameter && argument < count) slots[argument] = slot;
+    }
+    for (int i = 0; i < count; i++) {
+        if (slots[i] < 0) return false;
+    }
+    return true;
+}
+
+// Give the body a block of its own after the entry, for the self tail
+// calls to jump back to
+static IRBlock* split_entry(IRFunction *function, IRInstr *body) {
+    IRBlock *entry = function->first_block;
+    IRBlock *start = ir_new_block(function, NULL);
+    start->loop_depth = entry->loop_depth;
+    while (body) {
+        IRInstr *next = body->next;
+        ir_remove(entry, body);
+        ir_append(start, body);
+        body = next;
+    }
+    if (entry->next) {
+        ir_insert_block_before(function, entry->next, start);
+    } else {
+        ir_append_block(function, start);
+    }
+
+    // A loop the entry jumped into is now entered from the new block
+    for (IRLoop *loop = function->loops; loop; loop = loop->next) {
+        if (loop->preheader == entry) loop->preheader = start;
+    }
+    return start;
+}
+
+// Replace `call` (followed by `exit`) in `block` by assignments to the
+// parameters and a jump back to `start`. The arguments are all computed
+// before the call, so storing them one after the other is safe.
+static void loop_back(IRFunction *function, IRBlock *block, IRInstr *call, IRInstr *exit,
+                      const int *slots, IRBlock *start) {
+    for (int i = 0; i < call->arg_count; i++) {
+        IRInstr *store = ir_new_instr(function, IR_STORE, IR_TYPE_VOID);
+        store->dst = ir_slot(slots[i]);
+        store->a = call->args[i];
+        ir_insert_before(block, call, store);
+    }
+    IRInstr *jump = ir_new_instr(function, IR_JUMP, IR_TYPE_VOID);
+    jump->target = start;
+    ir_insert_before(block, call, jump);
+    ir_remove(block, call);
+    if (exit) ir_remove(block, exit);
+}
+
+void eliminate_tail_calls(IRFunction *function) {
+    if (!function->first_block) return;
+
+    // Self tail calls need the parameters' slots and a block to go back to
+    int parameter_count = -1;
+    IRInstr *exit;
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        IRInstr *call = tail_call(block, &exit);
+        if (call && is_self_call(function, call)) parameter_count = call->arg_count;
+    }
+    int *slots = NULL;
+    IRBlock *start = NULL;
+    if (parameter_count >= 0) {
+        IRInstr *body;
+        slots = (int *)malloc(sizeof(int) * (parameter_count + 1));
+        if (!slots) {
+            fprintf(stderr, "Failed to allocate memory for tail calls in '%s'\n", function->name);
+        } else if (find_parameters(function, parameter_count, slots, &body)) {
+            start = split_entry(function, body);
+        }
+    }
+
+    for (IRBlock *block = function->first_block; block; block = block->next) {
+        IRInstr *call = tail_call(block, &exit);
+        if (!call) continue;
+
+        if (is_self_call(function, call)) {
+            if (start && call->arg_count == parameter_count) loop_back(function, block, call, exit, slots, start);
+        } else if (call->arg_count <= IR_REGISTER_ARGUMENTS) {
+            // The caller's stack arguments stay where they are: only
+            // register arguments can be passed on
+            call->op = IR_TAIL_CALL;
+            call->type = IR_TYPE_VOID;
+            call->dst = ir_none();
+            if (exit) ir_remove(block, exit);
+        }
+    }
+    free(slots);
+}
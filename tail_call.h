@@ -0,0 +1,17 @@
+#ifndef TAIL_CALL_H
+#define TAIL_CALL_H
+
+#include "ir.h"
+
+// Tail call elimination.
+// A call is in tail position when the function returns its result right
+// away (or returns nothing right after it). A tail call of the function
+// itself stores the arguments into the parameters and jumps back to the
+// start of the body, turning the recursion into a loop. A tail call of
+// another function with all its arguments in registers becomes
+// IR_TAIL_CALL, which releases the frame and jumps to the callee so that
+// it returns straight to the caller. Either way the stack no longer grows
+// with the depth of the calls.
+void eliminate_tail_calls(IRFunction *function);
+
+#endif // TAIL_CALL_H
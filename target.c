@@ -0,0 +1,69 @@
+#include "target.h"
+#include <string.h>
+
+static const TargetCosts target_table[] = {
+    [TARGET_8086] = {
+        .name = "8086", .directive = NULL,
+        .immediate_shift = false, .immediate_multiply = false,
+        .move = 2, .move_immediate = 4, .alu = 3, .shift_one = 2,
+        .shift_base = 0, .shift_per_bit = 0,
+        .multiply = 141, .multiply_immediate = 0,
+        .divide = 175, .unsigned_divide = 153, .sign_extend = 5, .branch = 16
+    },
+    [TARGET_186] = {
+        .name = "186", .directive = ".186",
+        .immediate_shift = true, .immediate_multiply = true,
+        .move = 2, .move_immediate = 3, .alu = 3, .shift_one = 2,
+        .shift_base = 5, .shift_per_bit = 1,
+        .multiply = 27, .multiply_immediate = 23,
+        .divide = 48, .unsigned_divide = 38, .sign_extend = 4, .branch = 13
+    },
+    [TARGET_286] = {
+        .name = "286", .directive = ".286",
+        .immediate_shift = true, .immediate_multiply = true,
+        .move = 2, .move_immediate = 2, .alu = 2, .shift_one = 2,
+        .shift_base = 5, .shift_per_bit = 1,
+        .multiply = 21, .multiply_immediate = 21,
+        .divide = 25, .unsigned_divide = 22, .sign_extend = 2, .branch = 8
+    }
+};
+
+const TargetCosts* target_costs(TargetCPU cpu) {
+    return &target_table[cpu];
+}
+
+bool parse_target(const char *name, TargetCPU *cpu) {
+    // "i286" and "80286" name the same processor as "286"
+    if (name[0] == 'i') name++;
+    else if (strncmp(name, "80", 2) == 0 && strcmp(name, "8086") != 0) name += 2;
+
+    for (int i = 0; i < (int)(sizeof(target_table) / sizeof(target_table[0])); i++) {
+        if (strcmp(name, target_table[i].name) == 0) {
+            *cpu = (TargetCPU)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+ShiftForm select_shift(const TargetCosts *costs, ShiftKind kind, int count, int *cost) {
+    ShiftForm form = SHIFT_REPEAT;
+    int best = costs->shift_one * count;
+
+    if (costs->immediate_shift && costs->shift_base + costs->shift_per_bit * count < best) {
+        form = SHIFT_IMMEDIATE;
+        best = costs->shift_base + costs->shift_per_bit * count;
+    }
+    // Only the sign bit is left: add r, r moves it into the carry, and
+    // sbb r, r spreads it; rol r, 1 / and r, 1 isolates it
+    if (count == 15 && kind != SHIFT_LEFT) {
+        int sign = kind == SHIFT_RIGHT_ARITHMETIC ? 2 * costs->alu : costs->shift_one + costs->alu;
+        if (sign < best) {
+            form = SHIFT_SIGN;
+            best = sign;
+        }
+    }
+
+    if (cost) *cost = best;
+    return form;
+}
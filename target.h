@@ -0,0 +1,58 @@
+#ifndef TARGET_H
+#define TARGET_H
+
+#include <stdbool.h>
+
+// Target processors (--march). Code runs on the 8086 by default; the later
+// processors add immediate shift counts and a three-operand imul, and make
+// multiplication and division much cheaper relative to everything else.
+typedef enum {
+    TARGET_8086,
+    TARGET_186,
+    TARGET_286
+} TargetCPU;
+
+// Clock counts of the instructions the code generator chooses between
+// (register operands, from the Intel manuals; ranges are averaged)
+typedef struct {
+    const char *name;            // --march value
+    const char *directive;       // Assembler directive enabling the instruction set (NULL for 8086)
+    bool immediate_shift;        // shl reg, imm8
+    bool immediate_multiply;     // imul reg, r/m, imm
+    int move;                    // mov reg, reg
+    int move_immediate;          // mov reg, imm
+    int alu;                     // add/sub/and/neg/sbb reg, reg or imm
+    int shift_one;               // shl/sar/shr/rol reg, 1
+    int shift_base;              // shl reg, imm8: base + per_bit * count
+    int shift_per_bit;
+    int multiply;                // imul reg16
+    int multiply_immediate;      // imul reg, reg, imm
+    int divide;                  // idiv reg16
+    int unsigned_divide;         // div reg16
+    int sign_extend;             // cwd
+    int branch;                  // Conditional jump, taken
+} TargetCosts;
+
+// How a register is shifted by a constant count
+typedef enum {
+    SHIFT_REPEAT,                // `count` shifts by one
+    SHIFT_IMMEDIATE,             // One shift with an immediate count (186+)
+    SHIFT_SIGN                   // Count 15 of a right shift: add/sbb (sar) or rol/and (shr)
+} ShiftForm;
+
+typedef enum {
+    SHIFT_LEFT,
+    SHIFT_RIGHT,                 // Logical
+    SHIFT_RIGHT_ARITHMETIC
+} ShiftKind;
+
+const TargetCosts* target_costs(TargetCPU cpu);
+
+// Look up a --march value. Returns false if the name is not known.
+bool parse_target(const char *name, TargetCPU *cpu);
+
+// Cheapest way to shift a register by `count` (1-15) on the target, and
+// its cost in clocks
+ShiftForm select_shift(const TargetCosts *costs, ShiftKind kind, int count, int *cost);
+
+#endif // TARGET_H
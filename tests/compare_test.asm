@@ -0,0 +1,268 @@
+; Generated assembly code for TASM
+; Source file: tests/compare_test.lx
+
+data segment
+; Data section with variables needed by the compiler
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+text_main_0 db '1', 0Dh, 0Ah, '$'
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Print a constant string
+print_text:
+    mov si, ax
+    mov di, output_length
+print_text_next:
+    mov al, [si]
+    cmp al, '$'
+    je print_text_done
+    cmp di, 256
+    jb print_text_store
+    mov output_length, di
+    call flush_output
+    xor di, di
+print_text_store:
+    mov output_buffer[di], al
+    inc di
+    inc si
+    jmp print_text_next
+print_text_done:
+    mov output_length, di
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: xlt
+xlt:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    jge endif_xlt_0
+if_xlt_0:
+    mov ax, 1
+    jmp end_xlt
+endif_xlt_0:
+    mov ax, 0
+end_xlt:
+    pop di
+    pop si
+    ret
+; Function: xle
+xle:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    jg endif_xle_0
+if_xle_0:
+    mov ax, 1
+    jmp end_xle
+endif_xle_0:
+    mov ax, 0
+end_xle:
+    pop di
+    pop si
+    ret
+; Function: xgt
+xgt:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    jle endif_xgt_0
+if_xgt_0:
+    mov ax, 1
+    jmp end_xgt
+endif_xgt_0:
+    mov ax, 0
+end_xgt:
+    pop di
+    pop si
+    ret
+; Function: xge
+xge:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    jl endif_xge_0
+if_xge_0:
+    mov ax, 1
+    jmp end_xge
+endif_xge_0:
+    mov ax, 0
+end_xge:
+    pop di
+    pop si
+    ret
+; Function: xeq
+xeq:
+    push si
+; Variable xa in si
+    mov si, ax
+    cmp si, 3
+    jne endif_xeq_0
+if_xeq_0:
+    mov ax, 1
+    jmp end_xeq
+endif_xeq_0:
+    mov ax, 0
+end_xeq:
+    pop si
+    ret
+; Function: xne
+xne:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    je endif_xne_0
+if_xne_0:
+    mov ax, 1
+    jmp end_xne
+endif_xne_0:
+    mov ax, 0
+end_xne:
+    pop di
+    pop si
+    ret
+; Function: xboth
+xboth:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    test si, si
+    jle endif_xboth_0
+block_xboth_3:
+    cmp di, 5
+    jle endif_xboth_0
+if_xboth_0:
+    mov ax, 1
+    jmp end_xboth
+endif_xboth_0:
+    mov ax, 0
+end_xboth:
+    pop di
+    pop si
+    ret
+; Function: xeither
+xeither:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, 5
+    jg if_xeither_0
+block_xeither_3:
+    cmp di, 5
+    jle endif_xeither_0
+if_xeither_0:
+    mov ax, 1
+    jmp end_xeither
+endif_xeither_0:
+    mov ax, 0
+end_xeither:
+    pop di
+    pop si
+    ret
+; Function: xnot
+xnot:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, di
+    je endif_xnot_0
+if_xnot_0:
+    mov ax, 1
+    jmp end_xnot
+endif_xnot_0:
+    mov ax, 0
+end_xnot:
+    pop di
+    pop si
+    ret
+; Function: xnotor
+xnotor:
+    push si
+    push di
+; Variable xa in si
+; Variable xb in di
+    mov si, ax
+    mov di, dx
+    cmp si, 5
+    jg endif_xnotor_0
+block_xnotor_3:
+    test di, di
+    jl endif_xnotor_0
+if_xnotor_0:
+    mov ax, 1
+    jmp end_xnotor
+endif_xnotor_0:
+    mov ax, 0
+end_xnotor:
+    pop di
+    pop si
+    ret
+; Function: main
+main:
+    mov ax, offset text_main_0
+    call print_text
+end_main:
+    ret
+code ends
+
+end main_init
@@ -0,0 +1,405 @@
+; Generated assembly code for TASM
+; Source file: tests/condition_test.lx
+
+data segment
+; Data section with variables needed by the compiler
+input_length dw 0 ; Bytes read into input_buffer
+input_position dw 0 ; Next byte luload parses
+input_buffer db 512 dup(?)
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+text_main_0 db '1', 0Dh, 0Ah, '$'
+text_main_1 db '2', 0Dh, 0Ah, '$'
+text_main_2 db '3', 0Dh, 0Ah, '$'
+text_main_3 db '4', 0Dh, 0Ah, '$'
+text_main_4 db '5', 0Dh, 0Ah, '$'
+text_main_5 db '6', 0Dh, 0Ah, '$'
+text_main_6 db '7', 0Dh, 0Ah, '$'
+text_main_7 db '8', 0Dh, 0Ah, '$'
+text_main_8 db '9', 0Dh, 0Ah, '$'
+text_main_9 db '10', 0Dh, 0Ah, '$'
+text_main_10 db '0', 0Dh, 0Ah, '$'
+text_main_11 db '11', 0Dh, 0Ah, '$'
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Entry for non-negative values (no sign handling)
+lulog_unsigned:
+    call reserve_output
+lulog_digits:
+    cmp ax, 10
+    jb lulog_place_1
+    cmp ax, 100
+    jb lulog_place_10
+    cmp ax, 1000
+    jb lulog_place_100
+    cmp ax, 10000
+    jb lulog_place_1000
+lulog_place_10000:
+    mov dl, '0' - 1
+    cmp ax, 50000
+    jb lulog_count_10000
+    sub ax, 50000
+    mov dl, '5' - 1
+lulog_count_10000:
+    inc dl
+    sub ax, 10000
+    jae lulog_count_10000
+    add ax, 10000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1000:
+    mov dl, '0' - 1
+    cmp ax, 5000
+    jb lulog_count_1000
+    sub ax, 5000
+    mov dl, '5' - 1
+lulog_count_1000:
+    inc dl
+    sub ax, 1000
+    jae lulog_count_1000
+    add ax, 1000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_100:
+    mov dl, '0' - 1
+    cmp ax, 500
+    jb lulog_count_100
+    sub ax, 500
+    mov dl, '5' - 1
+lulog_count_100:
+    inc dl
+    sub ax, 100
+    jae lulog_count_100
+    add ax, 100
+    mov output_buffer[di], dl
+    inc di
+lulog_place_10:
+    mov dl, '0' - 1
+    cmp ax, 50
+    jb lulog_count_10
+    sub ax, 50
+    mov dl, '5' - 1
+lulog_count_10:
+    inc dl
+    sub ax, 10
+    jae lulog_count_10
+    add ax, 10
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1:
+    add al, '0'
+    mov output_buffer[di], al
+    inc di
+    mov word ptr output_buffer[di], 0A0Dh
+    add di, 2
+    mov output_length, di
+    ret
+; Print a constant string
+print_text:
+    mov si, ax
+    mov di, output_length
+print_text_next:
+    mov al, [si]
+    cmp al, '$'
+    je print_text_done
+    cmp di, 256
+    jb print_text_store
+    mov output_length, di
+    call flush_output
+    xor di, di
+print_text_store:
+    mov output_buffer[di], al
+    inc di
+    inc si
+    jmp print_text_next
+print_text_done:
+    mov output_length, di
+    ret
+; Read an integer from the next input line into AX
+luload:
+    push di
+    call reserve_output
+    mov output_buffer[di], '?'
+    mov output_buffer[di+1], ' '
+    add di, 2
+    mov output_length, di
+    pop di
+    xor bx, bx
+    xor cx, cx
+luload_start:
+    call read_input
+    cmp al, 10
+    je luload_start
+    cmp al, '-'
+    jne luload_char
+    mov cx, 1
+luload_next:
+    call read_input
+luload_char:
+    cmp al, 13
+    je luload_done
+    cmp al, '0'
+    jb luload_next
+    cmp al, '9'
+    ja luload_next
+    sub al, '0'
+    mov ah, 0
+    xchg ax, bx
+    mov dx, 10
+    mul dx
+    add bx, ax
+    jmp luload_next
+luload_done:
+    push di
+    call reserve_output
+    mov output_buffer[di], 13
+    mov output_buffer[di+1], 10
+    add di, 2
+    mov output_length, di
+    pop di
+    mov ax, bx
+    jcxz luload_return
+    neg ax
+luload_return:
+    ret
+read_input:
+    push si
+    mov si, input_position
+    cmp si, input_length
+    jb read_input_take
+    call flush_output
+    push bx
+    push cx
+    push dx
+    mov ah, 3Fh
+    xor bx, bx
+    mov cx, 512
+    mov dx, offset input_buffer
+    int 21h
+    pop dx
+    pop cx
+    pop bx
+    mov si, 0
+    jc read_input_end
+    mov input_length, ax
+    test ax, ax
+    jnz read_input_take
+read_input_end:
+    mov input_length, 0
+    mov input_position, 0
+    mov al, 13
+    jmp read_input_done
+read_input_take:
+    mov al, input_buffer[si]
+    inc si
+    mov input_position, si
+read_input_done:
+    pop si
+    ret
+reserve_output:
+    mov di, output_length
+    cmp di, 248
+    jbe reserve_output_done
+    call flush_output
+    xor di, di
+reserve_output_done:
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: main
+main:
+; Variable xa in si
+; Variable xb in di
+    call luload
+    mov si, ax
+    call luload
+    mov di, ax
+    cmp si, di
+    jge endif_main_0
+if_main_0:
+    push si
+    push di
+    mov ax, offset text_main_0
+    call print_text
+    pop di
+    pop si
+endif_main_0:
+    cmp si, di
+    jg endif_main_1
+if_main_1:
+    push si
+    push di
+    mov ax, offset text_main_1
+    call print_text
+    pop di
+    pop si
+endif_main_1:
+    cmp di, si
+    jle endif_main_2
+if_main_2:
+    push si
+    push di
+    mov ax, offset text_main_2
+    call print_text
+    pop di
+    pop si
+endif_main_2:
+    cmp di, si
+    jl endif_main_3
+if_main_3:
+    push si
+    push di
+    mov ax, offset text_main_3
+    call print_text
+    pop di
+    pop si
+endif_main_3:
+    cmp si, 3
+    jne endif_main_4
+if_main_4:
+    push si
+    push di
+    mov ax, offset text_main_4
+    call print_text
+    pop di
+    pop si
+endif_main_4:
+    cmp si, di
+    je endif_main_5
+if_main_5:
+    push si
+    push di
+    mov ax, offset text_main_5
+    call print_text
+    pop di
+    pop si
+endif_main_5:
+    test si, si
+    jle endif_main_6
+block_main_15:
+    cmp di, 5
+    jle endif_main_6
+if_main_6:
+    push si
+    push di
+    mov ax, offset text_main_6
+    call print_text
+    pop di
+    pop si
+endif_main_6:
+    cmp si, 5
+    jg if_main_7
+block_main_18:
+    cmp di, 5
+    jle endif_main_7
+if_main_7:
+    push si
+    push di
+    mov ax, offset text_main_7
+    call print_text
+    pop di
+    pop si
+endif_main_7:
+    cmp si, di
+    je endif_main_8
+if_main_8:
+    push si
+    push di
+    mov ax, offset text_main_8
+    call print_text
+    pop di
+    pop si
+endif_main_8:
+    cmp si, 5
+    jg else_main_9
+block_main_25:
+    test di, di
+    jl else_main_9
+block_main_24:
+    cmp si, di
+    jl if_main_9
+block_main_26:
+    test si, si
+    jne else_main_9
+if_main_9:
+    push si
+    push di
+    mov ax, offset text_main_9
+    call print_text
+    pop di
+    pop si
+    jmp endif_main_9
+else_main_9:
+    push si
+    push di
+    mov ax, offset text_main_10
+    call print_text
+    pop di
+    pop si
+endif_main_9:
+    cmp si, 5
+    jle block_main_29
+block_main_30:
+    cmp di, 5
+    jg if_main_10
+block_main_29:
+    cmp di, 7
+    jne endif_main_10
+if_main_10:
+    push si
+    push di
+    mov ax, offset text_main_11
+    call print_text
+    pop di
+    pop si
+endif_main_10:
+    jmp luloop_test_main_11
+luloop_start_main_11:
+    push di
+    mov ax, si
+    call lulog_unsigned
+    pop di
+    sub si, 1
+luloop_test_main_11:
+    test si, si
+    jle luloop_end_main_11
+block_main_34:
+    test di, di
+    jne luloop_start_main_11
+luloop_end_main_11:
+end_main:
+    ret
+code ends
+
+end main_init
@@ -0,0 +1,487 @@
+; Generated assembly code for TASM
+; Source file: tests/inline_test.lx
+
+data segment
+; Data section with variables needed by the compiler
+input_length dw 0 ; Bytes read into input_buffer
+input_position dw 0 ; Next byte luload parses
+input_buffer db 512 dup(?)
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Print the number in AX (buffered)
+lulog:
+    call reserve_output
+    test ax, ax
+    jns lulog_digits
+    neg ax
+    mov output_buffer[di], '-'
+    inc di
+    jmp lulog_digits
+; Entry for non-negative values (no sign handling)
+lulog_unsigned:
+    call reserve_output
+lulog_digits:
+    cmp ax, 10
+    jb lulog_place_1
+    cmp ax, 100
+    jb lulog_place_10
+    cmp ax, 1000
+    jb lulog_place_100
+    cmp ax, 10000
+    jb lulog_place_1000
+lulog_place_10000:
+    mov dl, '0' - 1
+    cmp ax, 50000
+    jb lulog_count_10000
+    sub ax, 50000
+    mov dl, '5' - 1
+lulog_count_10000:
+    inc dl
+    sub ax, 10000
+    jae lulog_count_10000
+    add ax, 10000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1000:
+    mov dl, '0' - 1
+    cmp ax, 5000
+    jb lulog_count_1000
+    sub ax, 5000
+    mov dl, '5' - 1
+lulog_count_1000:
+    inc dl
+    sub ax, 1000
+    jae lulog_count_1000
+    add ax, 1000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_100:
+    mov dl, '0' - 1
+    cmp ax, 500
+    jb lulog_count_100
+    sub ax, 500
+    mov dl, '5' - 1
+lulog_count_100:
+    inc dl
+    sub ax, 100
+    jae lulog_count_100
+    add ax, 100
+    mov output_buffer[di], dl
+    inc di
+lulog_place_10:
+    mov dl, '0' - 1
+    cmp ax, 50
+    jb lulog_count_10
+    sub ax, 50
+    mov dl, '5' - 1
+lulog_count_10:
+    inc dl
+    sub ax, 10
+    jae lulog_count_10
+    add ax, 10
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1:
+    add al, '0'
+    mov output_buffer[di], al
+    inc di
+    mov word ptr output_buffer[di], 0A0Dh
+    add di, 2
+    mov output_length, di
+    ret
+; Read an integer from the next input line into AX
+luload:
+    push di
+    call reserve_output
+    mov output_buffer[di], '?'
+    mov output_buffer[di+1], ' '
+    add di, 2
+    mov output_length, di
+    pop di
+    xor bx, bx
+    xor cx, cx
+luload_start:
+    call read_input
+    cmp al, 10
+    je luload_start
+    cmp al, '-'
+    jne luload_char
+    mov cx, 1
+luload_next:
+    call read_input
+luload_char:
+    cmp al, 13
+    je luload_done
+    cmp al, '0'
+    jb luload_next
+    cmp al, '9'
+    ja luload_next
+    sub al, '0'
+    mov ah, 0
+    xchg ax, bx
+    mov dx, 10
+    mul dx
+    add bx, ax
+    jmp luload_next
+luload_done:
+    push di
+    call reserve_output
+    mov output_buffer[di], 13
+    mov output_buffer[di+1], 10
+    add di, 2
+    mov output_length, di
+    pop di
+    mov ax, bx
+    jcxz luload_return
+    neg ax
+luload_return:
+    ret
+read_input:
+    push si
+    mov si, input_position
+    cmp si, input_length
+    jb read_input_take
+    call flush_output
+    push bx
+    push cx
+    push dx
+    mov ah, 3Fh
+    xor bx, bx
+    mov cx, 512
+    mov dx, offset input_buffer
+    int 21h
+    pop dx
+    pop cx
+    pop bx
+    mov si, 0
+    jc read_input_end
+    mov input_length, ax
+    test ax, ax
+    jnz read_input_take
+read_input_end:
+    mov input_length, 0
+    mov input_position, 0
+    mov al, 13
+    jmp read_input_done
+read_input_take:
+    mov al, input_buffer[si]
+    inc si
+    mov input_position, si
+read_input_done:
+    pop si
+    ret
+reserve_output:
+    mov di, output_length
+    cmp di, 248
+    jbe reserve_output_done
+    call flush_output
+    xor di, di
+reserve_output_done:
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: xsum
+xsum:
+    push si
+; Variable xn in cx
+; Variable xs in si
+    mov cx, ax
+    mov si, 0
+luloop_test_xsum_0:
+    test cx, cx
+    jle luloop_end_xsum_0
+luloop_start_xsum_0:
+    add si, cx
+    loop luloop_start_xsum_0
+luloop_end_xsum_0:
+    mov ax, si
+end_xsum:
+    pop si
+    ret
+; Function: xfive
+xfive:
+    push bp
+    mov bp, sp
+; Reserve space for local variables (2 bytes)
+    sub sp, 2
+    push si
+    push di
+; Variable xa in bx
+; Variable xb in si
+; Variable xc in di
+    mov bx, ax
+    mov si, dx
+    mov di, cx
+    mov ax, [bp+4]
+    mov cx, [bp+6]
+    cmp ax, cx
+    jle endif_xfive_0
+if_xfive_0:
+    mov ax, bx
+    add ax, si
+    mov cx, [bp+4]
+    mov [bp-2], ax
+    mov ax, di
+    imul cx
+    mov cx, [bp-2]
+    add cx, ax
+    mov ax, cx
+    jmp end_xfive
+endif_xfive_0:
+    mov ax, bx
+    sub ax, si
+    sub ax, di
+    mov cx, [bp+6]
+    add ax, cx
+end_xfive:
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+; Function: xeven
+xeven:
+    push si
+; Variable xn in si
+    mov si, ax
+    test si, si
+    jne endif_xeven_0
+if_xeven_0:
+    mov ax, 1
+    jmp end_xeven
+endif_xeven_0:
+    mov ax, si
+    sub ax, 1
+    pop si
+    jmp xodd
+end_xeven:
+    pop si
+    ret
+; Function: xodd
+xodd:
+    push si
+; Variable xn in si
+    mov si, ax
+    test si, si
+    jne endif_xodd_0
+if_xodd_0:
+    mov ax, 0
+    jmp end_xodd
+endif_xodd_0:
+    mov ax, si
+    sub ax, 1
+    pop si
+    jmp xeven
+end_xodd:
+    pop si
+    ret
+; Function: main
+main:
+    push bp
+    mov bp, sp
+; Reserve space for local variables (16 bytes)
+    sub sp, 16
+; Variable xi in di
+; Variable xt in bx
+; Variable xk in si
+; Variable xm in si
+; Variable xabs.xv in si
+; Variable xabs.xv in di
+; Variable xabs.xv in di
+; Variable inl.1 in si
+; Variable xabs.return in bx
+; Variable xsum.xn in cx
+; Variable xsum.xs in si
+; Variable xsum.return in si
+; Variable xsum.xn in cx
+; Variable xsum.xs in di
+; Variable xsum.return in di
+    call luload
+    mov [bp-2], ax
+    mov di, 0
+    mov bx, 0
+    mov word ptr [bp-4], 0
+    jmp luloop_test_main_0
+luloop_start_main_0:
+    mov cx, di
+    mov si, 0
+block_main_18:
+    test cx, cx
+    jle block_main_19
+block_main_17:
+    add si, cx
+    loop block_main_17
+block_main_19:
+block_main_16:
+    add bx, si
+    add di, 1
+    mov si, di
+    test si, si
+    jge block_main_9
+block_main_8:
+    mov ax, si
+    neg ax
+    mov [bp-6], ax
+    jmp block_main_7
+block_main_9:
+    mov [bp-6], si
+block_main_7:
+    mov ax, [bp-6]
+    mov [bp-4], ax
+luloop_test_main_0:
+    mov ax, [bp-4]
+    mov cx, [bp-2]
+    cmp ax, cx
+    jl luloop_start_main_0
+luloop_end_main_0:
+    mov ax, bx
+    call lulog
+    mov si, 3
+luloop_test_main_1:
+    test si, si
+    jle luloop_end_main_1
+luloop_start_main_1:
+    mov di, si
+    sub di, 9
+    test di, di
+    jge block_main_12
+block_main_11:
+    mov ax, di
+    neg ax
+    mov [bp-8], ax
+    jmp block_main_10
+block_main_12:
+    mov [bp-8], di
+block_main_10:
+    mov ax, [bp-8]
+    mov [bp-10], ax
+    mov cx, si
+    mov di, 0
+block_main_22:
+    test cx, cx
+    jle block_main_23
+block_main_21:
+    add di, cx
+    loop block_main_21
+block_main_23:
+block_main_20:
+    mov ax, [bp-10]
+    imul di
+    add bx, ax
+    dec si
+    jnz luloop_start_main_1
+luloop_end_main_1:
+    mov ax, bx
+    call lulog
+    mov ax, [bp-2]
+    call xsum
+    mov cx, [bp-2]
+    neg cx
+    mov si, ax
+    mov di, cx
+    test di, di
+    jge block_main_15
+block_main_14:
+    mov bx, di
+    neg bx
+    jmp block_main_13
+block_main_15:
+    mov bx, di
+block_main_13:
+    mov ax, [bp-2]
+    push si
+    mov cx, 4
+    push cx
+    mov cx, bx
+    mov dx, 2
+    call xfive
+    add sp, 4
+    mov cx, [bp-2]
+    mov dx, cx
+    shl dx, 1
+    shl dx, 1
+    sub dx, cx
+    mov si, dx
+    add si, ax
+    mov ax, si
+    call lulog
+    mov ax, 4
+    push ax
+    mov ax, 9
+    push ax
+    mov ax, 1
+    mov dx, 2
+    mov cx, 3
+    call xfive
+    add sp, 4
+    mov cx, [bp-2]
+    mov dx, [bp-2]
+    mov [bp-12], ax
+    mov ax, [bp-2]
+    mov [bp-14], cx
+    mov cx, [bp-2]
+    mov [bp-16], dx
+    mov dx, [bp-2]
+    push word ptr [bp-14]
+    push word ptr [bp-16]
+    mov [bp-16], ax
+    mov ax, dx
+    mov dx, cx
+    mov cx, [bp-16]
+    call xfive
+    add sp, 4
+    mov si, word ptr [bp-12]
+    sub si, ax
+    mov ax, si
+    call lulog
+    mov ax, [bp-2]
+    call xeven
+    mov si, ax
+    mov ax, si
+    call lulog
+    mov ax, [bp-2]
+    add ax, 2
+    call xodd
+    mov si, ax
+    mov ax, si
+    call lulog
+end_main:
+    mov sp, bp
+    pop bp
+    ret
+code ends
+
+end main_init
@@ -0,0 +1,206 @@
+; Generated assembly code for TASM
+; Source file: tests/lulog_286_test.lx
+
+.286
+
+data segment
+; Data section with variables needed by the compiler
+input_length dw 0 ; Bytes read into input_buffer
+input_position dw 0 ; Next byte luload parses
+input_buffer db 512 dup(?)
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Print the number in AX (buffered)
+lulog:
+    call reserve_output
+    test ax, ax
+    jns lulog_digits
+    neg ax
+    mov output_buffer[di], '-'
+    inc di
+    jmp lulog_digits
+; Entry for non-negative values (no sign handling)
+lulog_unsigned:
+    call reserve_output
+lulog_digits:
+    cmp ax, 10
+    jb lulog_length_1
+    cmp ax, 100
+    jb lulog_length_2
+    cmp ax, 1000
+    jb lulog_length_3
+    cmp ax, 10000
+    jb lulog_length_4
+    inc di
+lulog_length_4:
+    inc di
+lulog_length_3:
+    inc di
+lulog_length_2:
+    inc di
+lulog_length_1:
+    inc di
+    mov cx, di
+    mov bx, 10
+lulog_divide:
+    xor dx, dx
+    div bx
+    add dl, '0'
+    dec di
+    mov output_buffer[di], dl
+    test ax, ax
+    jnz lulog_divide
+    mov di, cx
+    mov word ptr output_buffer[di], 0A0Dh
+    add di, 2
+    mov output_length, di
+    ret
+; Read an integer from the next input line into AX
+luload:
+    push di
+    call reserve_output
+    mov output_buffer[di], '?'
+    mov output_buffer[di+1], ' '
+    add di, 2
+    mov output_length, di
+    pop di
+    xor bx, bx
+    xor cx, cx
+luload_start:
+    call read_input
+    cmp al, 10
+    je luload_start
+    cmp al, '-'
+    jne luload_char
+    mov cx, 1
+luload_next:
+    call read_input
+luload_char:
+    cmp al, 13
+    je luload_done
+    cmp al, '0'
+    jb luload_next
+    cmp al, '9'
+    ja luload_next
+    sub al, '0'
+    mov ah, 0
+    xchg ax, bx
+    mov dx, 10
+    mul dx
+    add bx, ax
+    jmp luload_next
+luload_done:
+    push di
+    call reserve_output
+    mov output_buffer[di], 13
+    mov output_buffer[di+1], 10
+    add di, 2
+    mov output_length, di
+    pop di
+    mov ax, bx
+    jcxz luload_return
+    neg ax
+luload_return:
+    ret
+read_input:
+    push si
+    mov si, input_position
+    cmp si, input_length
+    jb read_input_take
+    call flush_output
+    push bx
+    push cx
+    push dx
+    mov ah, 3Fh
+    xor bx, bx
+    mov cx, 512
+    mov dx, offset input_buffer
+    int 21h
+    pop dx
+    pop cx
+    pop bx
+    mov si, 0
+    jc read_input_end
+    mov input_length, ax
+    test ax, ax
+    jnz read_input_take
+read_input_end:
+    mov input_length, 0
+    mov input_position, 0
+    mov al, 13
+    jmp read_input_done
+read_input_take:
+    mov al, input_buffer[si]
+    inc si
+    mov input_position, si
+read_input_done:
+    pop si
+    ret
+reserve_output:
+    mov di, output_length
+    cmp di, 248
+    jbe reserve_output_done
+    call flush_output
+    xor di, di
+reserve_output_done:
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: main
+main:
+; Variable count in cx
+; Variable xv in si
+    call luload
+    mov cx, ax
+luloop_test_main_0:
+    test cx, cx
+    jle luloop_end_main_0
+luloop_start_main_0:
+    push cx
+    call luload
+    pop cx
+    mov si, ax
+    push cx
+    mov ax, si
+    call lulog
+    pop cx
+    loop luloop_start_main_0
+luloop_end_main_0:
+end_main:
+    ret
+code ends
+
+end main_init
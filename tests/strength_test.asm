@@ -0,0 +1,449 @@
+; Generated assembly code for TASM
+; Source file: tests/strength_test.lx
+
+data segment
+; Data section with variables needed by the compiler
+input_length dw 0 ; Bytes read into input_buffer
+input_position dw 0 ; Next byte luload parses
+input_buffer db 512 dup(?)
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Print the number in AX (buffered)
+lulog:
+    call reserve_output
+    test ax, ax
+    jns lulog_digits
+    neg ax
+    mov output_buffer[di], '-'
+    inc di
+    jmp lulog_digits
+; Entry for non-negative values (no sign handling)
+lulog_unsigned:
+    call reserve_output
+lulog_digits:
+    cmp ax, 10
+    jb lulog_place_1
+    cmp ax, 100
+    jb lulog_place_10
+    cmp ax, 1000
+    jb lulog_place_100
+    cmp ax, 10000
+    jb lulog_place_1000
+lulog_place_10000:
+    mov dl, '0' - 1
+    cmp ax, 50000
+    jb lulog_count_10000
+    sub ax, 50000
+    mov dl, '5' - 1
+lulog_count_10000:
+    inc dl
+    sub ax, 10000
+    jae lulog_count_10000
+    add ax, 10000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1000:
+    mov dl, '0' - 1
+    cmp ax, 5000
+    jb lulog_count_1000
+    sub ax, 5000
+    mov dl, '5' - 1
+lulog_count_1000:
+    inc dl
+    sub ax, 1000
+    jae lulog_count_1000
+    add ax, 1000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_100:
+    mov dl, '0' - 1
+    cmp ax, 500
+    jb lulog_count_100
+    sub ax, 500
+    mov dl, '5' - 1
+lulog_count_100:
+    inc dl
+    sub ax, 100
+    jae lulog_count_100
+    add ax, 100
+    mov output_buffer[di], dl
+    inc di
+lulog_place_10:
+    mov dl, '0' - 1
+    cmp ax, 50
+    jb lulog_count_10
+    sub ax, 50
+    mov dl, '5' - 1
+lulog_count_10:
+    inc dl
+    sub ax, 10
+    jae lulog_count_10
+    add ax, 10
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1:
+    add al, '0'
+    mov output_buffer[di], al
+    inc di
+    mov word ptr output_buffer[di], 0A0Dh
+    add di, 2
+    mov output_length, di
+    ret
+; Read an integer from the next input line into AX
+luload:
+    push di
+    call reserve_output
+    mov output_buffer[di], '?'
+    mov output_buffer[di+1], ' '
+    add di, 2
+    mov output_length, di
+    pop di
+    xor bx, bx
+    xor cx, cx
+luload_start:
+    call read_input
+    cmp al, 10
+    je luload_start
+    cmp al, '-'
+    jne luload_char
+    mov cx, 1
+luload_next:
+    call read_input
+luload_char:
+    cmp al, 13
+    je luload_done
+    cmp al, '0'
+    jb luload_next
+    cmp al, '9'
+    ja luload_next
+    sub al, '0'
+    mov ah, 0
+    xchg ax, bx
+    mov dx, 10
+    mul dx
+    add bx, ax
+    jmp luload_next
+luload_done:
+    push di
+    call reserve_output
+    mov output_buffer[di], 13
+    mov output_buffer[di+1], 10
+    add di, 2
+    mov output_length, di
+    pop di
+    mov ax, bx
+    jcxz luload_return
+    neg ax
+luload_return:
+    ret
+read_input:
+    push si
+    mov si, input_position
+    cmp si, input_length
+    jb read_input_take
+    call flush_output
+    push bx
+    push cx
+    push dx
+    mov ah, 3Fh
+    xor bx, bx
+    mov cx, 512
+    mov dx, offset input_buffer
+    int 21h
+    pop dx
+    pop cx
+    pop bx
+    mov si, 0
+    jc read_input_end
+    mov input_length, ax
+    test ax, ax
+    jnz read_input_take
+read_input_end:
+    mov input_length, 0
+    mov input_position, 0
+    mov al, 13
+    jmp read_input_done
+read_input_take:
+    mov al, input_buffer[si]
+    inc si
+    mov input_position, si
+read_input_done:
+    pop si
+    ret
+reserve_output:
+    mov di, output_length
+    cmp di, 248
+    jbe reserve_output_done
+    call flush_output
+    xor di, di
+reserve_output_done:
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: main
+main:
+    push bp
+    mov bp, sp
+; Reserve space for local variables (2 bytes)
+    sub sp, 2
+; Variable xp in di
+; Variable xm in bx
+; Variable xb in si
+; Variable count in si
+; Variable total in di
+    call luload
+    mov [bp-2], ax
+    mov cx, ax
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    sub cx, ax
+    shl cx, 1
+    shl cx, 1
+    add cx, ax
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    shl cx, 1
+    mov di, cx
+    add di, ax
+    push di
+    mov ax, di
+    call lulog
+    pop di
+    mov bx, di
+    neg bx
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, di
+    shl ax, 1
+    shl ax, 1
+    add ax, di
+    mov si, ax
+    shl si, 1
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, [bp-2]
+    mov cx, ax
+    neg cx
+    shl cx, 1
+    shl cx, 1
+    mov si, cx
+    add si, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, di
+    add ax, ax
+    sbb ax, ax
+    and ax, 7
+    add ax, di
+    mov si, ax
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, bx
+    add ax, ax
+    sbb ax, ax
+    and ax, 7
+    add ax, bx
+    mov si, ax
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, di
+    add ax, ax
+    sbb ax, ax
+    and ax, 7
+    mov cx, ax
+    add cx, di
+    and cx, 7
+    mov si, cx
+    sub si, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, bx
+    add ax, ax
+    sbb ax, ax
+    and ax, 7
+    mov cx, ax
+    add cx, bx
+    and cx, 7
+    mov si, cx
+    sub si, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, di
+    mov cx, 26215
+    imul cx
+    sar dx, 1
+    sar dx, 1
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    mov si, dx
+    add si, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, bx
+    mov cx, 26215
+    imul cx
+    sar dx, 1
+    sar dx, 1
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    mov si, dx
+    add si, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    mov ax, di
+    mov cx, -18725
+    imul cx
+    sar dx, 1
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    mov si, dx
+    add si, ax
+    mov ax, si
+    call lulog
+    mov ax, bx
+    mov cx, 7282
+    imul cx
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    add dx, ax
+    mov ax, dx
+    shl ax, 1
+    shl ax, 1
+    shl ax, 1
+    add ax, dx
+    mov si, bx
+    sub si, ax
+    mov ax, si
+    call lulog
+    mov ax, bx
+    rol ax, 1
+    and ax, 1
+    add ax, bx
+    mov si, ax
+    sar si, 1
+    mov ax, si
+    call lulog
+    mov ax, bx
+    add ax, ax
+    sbb ax, ax
+    and ax, 16383
+    add ax, bx
+    mov si, ax
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    sar si, 1
+    mov ax, si
+    call lulog
+    mov ax, bx
+    add ax, ax
+    sbb ax, ax
+    and ax, 16383
+    mov cx, ax
+    add cx, bx
+    and cx, 16383
+    mov si, cx
+    sub si, ax
+    mov ax, si
+    call lulog
+    mov si, 20
+    mov di, 0
+luloop_test_main_0:
+    test si, si
+    jle luloop_end_main_0
+luloop_start_main_0:
+    mov ax, si
+    mov cx, 21846
+    imul cx
+    mov ax, si
+    and ax, 3
+    add dx, ax
+    add di, dx
+    dec si
+    jnz luloop_start_main_0
+luloop_end_main_0:
+    mov ax, di
+    call lulog
+end_main:
+    mov sp, bp
+    pop bp
+    ret
+code ends
+
+end main_init
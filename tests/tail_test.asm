@@ -0,0 +1,516 @@
+; Generated assembly code for TASM
+; Source file: tests/tail_test.lx
+
+data segment
+; Data section with variables needed by the compiler
+input_length dw 0 ; Bytes read into input_buffer
+input_position dw 0 ; Next byte luload parses
+input_buffer db 512 dup(?)
+output_length dw 0 ; Bytes waiting in output_buffer
+output_buffer db 256 dup(?)
+data ends
+
+program_stack segment
+    dw   128  dup(0)
+program_stack ends
+
+code segment
+    assume cs:code, ds:data
+
+main_init:
+    mov ax, data
+    mov ds, ax
+    call main
+    call flush_output
+    mov ax, 4c00h
+    int 21h
+; Print the number in AX (buffered)
+lulog:
+    call reserve_output
+    test ax, ax
+    jns lulog_digits
+    neg ax
+    mov output_buffer[di], '-'
+    inc di
+    jmp lulog_digits
+; Entry for non-negative values (no sign handling)
+lulog_unsigned:
+    call reserve_output
+lulog_digits:
+    cmp ax, 10
+    jb lulog_place_1
+    cmp ax, 100
+    jb lulog_place_10
+    cmp ax, 1000
+    jb lulog_place_100
+    cmp ax, 10000
+    jb lulog_place_1000
+lulog_place_10000:
+    mov dl, '0' - 1
+    cmp ax, 50000
+    jb lulog_count_10000
+    sub ax, 50000
+    mov dl, '5' - 1
+lulog_count_10000:
+    inc dl
+    sub ax, 10000
+    jae lulog_count_10000
+    add ax, 10000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1000:
+    mov dl, '0' - 1
+    cmp ax, 5000
+    jb lulog_count_1000
+    sub ax, 5000
+    mov dl, '5' - 1
+lulog_count_1000:
+    inc dl
+    sub ax, 1000
+    jae lulog_count_1000
+    add ax, 1000
+    mov output_buffer[di], dl
+    inc di
+lulog_place_100:
+    mov dl, '0' - 1
+    cmp ax, 500
+    jb lulog_count_100
+    sub ax, 500
+    mov dl, '5' - 1
+lulog_count_100:
+    inc dl
+    sub ax, 100
+    jae lulog_count_100
+    add ax, 100
+    mov output_buffer[di], dl
+    inc di
+lulog_place_10:
+    mov dl, '0' - 1
+    cmp ax, 50
+    jb lulog_count_10
+    sub ax, 50
+    mov dl, '5' - 1
+lulog_count_10:
+    inc dl
+    sub ax, 10
+    jae lulog_count_10
+    add ax, 10
+    mov output_buffer[di], dl
+    inc di
+lulog_place_1:
+    add al, '0'
+    mov output_buffer[di], al
+    inc di
+    mov word ptr output_buffer[di], 0A0Dh
+    add di, 2
+    mov output_length, di
+    ret
+; Read an integer from the next input line into AX
+luload:
+    push di
+    call reserve_output
+    mov output_buffer[di], '?'
+    mov output_buffer[di+1], ' '
+    add di, 2
+    mov output_length, di
+    pop di
+    xor bx, bx
+    xor cx, cx
+luload_start:
+    call read_input
+    cmp al, 10
+    je luload_start
+    cmp al, '-'
+    jne luload_char
+    mov cx, 1
+luload_next:
+    call read_input
+luload_char:
+    cmp al, 13
+    je luload_done
+    cmp al, '0'
+    jb luload_next
+    cmp al, '9'
+    ja luload_next
+    sub al, '0'
+    mov ah, 0
+    xchg ax, bx
+    mov dx, 10
+    mul dx
+    add bx, ax
+    jmp luload_next
+luload_done:
+    push di
+    call reserve_output
+    mov output_buffer[di], 13
+    mov output_buffer[di+1], 10
+    add di, 2
+    mov output_length, di
+    pop di
+    mov ax, bx
+    jcxz luload_return
+    neg ax
+luload_return:
+    ret
+read_input:
+    push si
+    mov si, input_position
+    cmp si, input_length
+    jb read_input_take
+    call flush_output
+    push bx
+    push cx
+    push dx
+    mov ah, 3Fh
+    xor bx, bx
+    mov cx, 512
+    mov dx, offset input_buffer
+    int 21h
+    pop dx
+    pop cx
+    pop bx
+    mov si, 0
+    jc read_input_end
+    mov input_length, ax
+    test ax, ax
+    jnz read_input_take
+read_input_end:
+    mov input_length, 0
+    mov input_position, 0
+    mov al, 13
+    jmp read_input_done
+read_input_take:
+    mov al, input_buffer[si]
+    inc si
+    mov input_position, si
+read_input_done:
+    pop si
+    ret
+reserve_output:
+    mov di, output_length
+    cmp di, 248
+    jbe reserve_output_done
+    call flush_output
+    xor di, di
+reserve_output_done:
+    ret
+flush_output:
+    push ax
+    push bx
+    push cx
+    push dx
+    mov cx, output_length
+    jcxz flush_output_done
+    mov ah, 40h
+    mov bx, 1
+    mov dx, offset output_buffer
+    int 21h
+    mov output_length, 0
+flush_output_done:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+    ret
+
+; Function: xsum
+xsum:
+    push si
+    push di
+; Variable xn in si
+; Variable xacc in di
+    mov si, ax
+    mov di, dx
+block_xsum_3:
+    test si, si
+    jne endif_xsum_0
+if_xsum_0:
+    mov ax, di
+    jmp end_xsum
+endif_xsum_0:
+    mov ax, di
+    add ax, si
+    sub si, 1
+    mov di, ax
+    jmp block_xsum_3
+end_xsum:
+    pop di
+    pop si
+    ret
+; Function: xcount
+xcount:
+    push si
+    push di
+; Variable xn in si
+    mov si, ax
+block_xcount_3:
+    mov ax, si
+    call lulog
+    test si, si
+    jle endif_xcount_0
+if_xcount_0:
+    sub si, 1
+    jmp block_xcount_3
+endif_xcount_0:
+end_xcount:
+    pop di
+    pop si
+    ret
+; Function: xwalk
+xwalk:
+    push bp
+    mov bp, sp
+    push si
+    push di
+; Variable xa in di
+; Variable xb in bx
+; Variable xc in si
+    mov di, ax
+    mov bx, dx
+    mov si, cx
+block_xwalk_3:
+    cmp di, 1
+    jge endif_xwalk_0
+if_xwalk_0:
+    mov ax, [bp+4]
+    imul si
+    mov cx, bx
+    add cx, ax
+    mov ax, cx
+    jmp end_xwalk
+endif_xwalk_0:
+    mov ax, bx
+    add ax, 1
+    mov cx, [bp+4]
+    sub di, 1
+    mov bx, cx
+    mov [bp+4], ax
+    jmp block_xwalk_3
+end_xwalk:
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+; Function: xshow
+xshow:
+    push bp
+    mov bp, sp
+; Reserve space for local variables (2 bytes)
+    sub sp, 2
+    push si
+    push di
+; Variable xv in si
+; Variable xw in di
+; Variable xk in bx
+    mov si, ax
+    mov di, dx
+    mov ax, si
+    imul di
+    mov bx, ax
+    push di
+    mov ax, si
+    call lulog
+    pop di
+    push di
+    mov ax, di
+    call lulog
+    pop di
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, bx
+    add ax, si
+    mov bx, ax
+    sub bx, di
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, bx
+    shl ax, 1
+    shl ax, 1
+    sub ax, bx
+    mov cx, ax
+    mov ax, si
+    imul di
+    mov bx, cx
+    sub bx, ax
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, bx
+    mov cx, 18725
+    imul cx
+    sar dx, 1
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    add dx, ax
+    mov ax, di
+    mov cx, dx
+    mov [bp-2], cx
+    mov cx, 26215
+    imul cx
+    sar dx, 1
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    add dx, ax
+    mov ax, dx
+    shl ax, 1
+    shl ax, 1
+    add ax, dx
+    mov cx, di
+    sub cx, ax
+    mov bx, word ptr [bp-2]
+    add bx, cx
+    mov ax, si
+    shl ax, 1
+    mov cx, bx
+    add cx, ax
+    mov ax, cx
+end_xshow:
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+; Function: xscale
+xscale:
+    push bp
+    mov bp, sp
+; Reserve space for local variables (2 bytes)
+    sub sp, 2
+    push si
+    push di
+; Variable xv in si
+; Variable xt in di
+; Variable xu in bx
+    mov si, ax
+    mov di, si
+    add di, 4
+    mov ax, si
+    imul si
+    mov bx, ax
+    sub bx, di
+    push di
+    mov ax, di
+    call lulog
+    pop di
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, bx
+    shl ax, 1
+    shl ax, 1
+    add ax, bx
+    mov cx, ax
+    mov ax, di
+    mov [bp-2], cx
+    mov cx, 21846
+    imul cx
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    add dx, ax
+    mov bx, word ptr [bp-2]
+    add bx, dx
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, di
+    add ax, bx
+    mov cx, ax
+    mov ax, cx
+    mov [bp-2], cx
+    mov cx, 7282
+    imul cx
+    mov ax, dx
+    rol ax, 1
+    and ax, 1
+    add dx, ax
+    mov ax, dx
+    shl ax, 1
+    shl ax, 1
+    shl ax, 1
+    add ax, dx
+    mov di, word ptr [bp-2]
+    sub di, ax
+    push di
+    mov ax, di
+    call lulog
+    pop di
+    mov ax, bx
+    sub ax, di
+    mov cx, si
+    add cx, 1
+    imul cx
+    mov bx, ax
+    push di
+    mov ax, bx
+    call lulog
+    pop di
+    mov ax, si
+    imul di
+    mov dx, bx
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    jmp xshow
+end_xscale:
+    pop di
+    pop si
+    mov sp, bp
+    pop bp
+    ret
+; Function: main
+main:
+; Variable xa in si
+; Variable xr in di
+    call luload
+    mov si, ax
+    mov ax, 200
+    xor dx, dx
+    call xsum
+    mov di, ax
+    mov ax, di
+    call lulog
+    mov ax, si
+    call xcount
+    mov ax, 3
+    push ax
+    mov ax, si
+    mov dx, 1
+    mov cx, 2
+    call xwalk
+    add sp, 2
+    mov di, ax
+    mov ax, di
+    call lulog
+    mov ax, si
+    call xscale
+    mov di, ax
+    mov ax, di
+    call lulog
+    mov ax, si
+    mov dx, 2
+    call xshow
+    mov di, ax
+    mov ax, di
+    call lulog
+    mov ax, 1
+    call xscale
+    mov di, ax
+    mov ax, di
+    call lulog
+end_main:
+    ret
+code ends
+
+end main_init
@@ -0,0 +1,232 @@
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Minimal threading layer: Win32 threads on Windows, pthreads elsewhere
+#ifdef _WIN32
+#include <windows.h>
+
+typedef CRITICAL_SECTION PoolMutex;
+typedef HANDLE PoolThread;
+
+static void mutex_init(PoolMutex *mutex) { InitializeCriticalSection(mutex); }
+static void mutex_destroy(PoolMutex *mutex) { DeleteCriticalSection(mutex); }
+static void mutex_lock(PoolMutex *mutex) { EnterCriticalSection(mutex); }
+static void mutex_unlock(PoolMutex *mutex) { LeaveCriticalSection(mutex); }
+#else
+#include <pthread.h>
+
+typedef pthread_mutex_t PoolMutex;
+typedef pthread_t PoolThread;
+
+static void mutex_init(PoolMutex *mutex) { pthread_mutex_init(mutex, NULL); }
+static void mutex_destroy(PoolMutex *mutex) { pthread_mutex_destroy(mutex); }
+static void mutex_lock(PoolMutex *mutex) { pthread_mutex_lock(mutex); }
+static void mutex_unlock(PoolMutex *mutex) { pthread_mutex_unlock(mutex); }
+#endif
+
+// Per-worker deque of item indices: the owner pops from the tail, thieves
+// take from the head
+typedef struct {
+    int *items;                  // Item indices
+    int head;                    // Next index to steal
+    int tail;                    // One past the owner's next index
+    PoolMutex lock;              // Guards head and tail
+} WorkDeque;
+
+struct ThreadPool {
+    int worker_count;            // Number of workers (including the caller)
+    WorkDeque *deques;           // One deque per worker
+    ThreadPoolTask task;         // Task of the current run
+    void **items;                // Items of the current run
+};
+
+// Worker thread argument
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} Worker;
+
+// Create a pool with the given number of workers
+ThreadPool* create_thread_pool(int worker_count) {
+    if (worker_count < 1) worker_count = 1;
+
+    ThreadPool *pool = (ThreadPool *)malloc(sizeof(ThreadPool));
+    if (!pool) {
+        fprintf(stderr, "Memory allocation failed for thread pool\n");
+        return NULL;
+    }
+
+    pool->deques = (WorkDeque *)calloc(worker_count, sizeof(WorkDeque));
+    if (!pool->deques) {
+        fprintf(stderr, "Memory allocation failed for thread pool deques\n");
+        free(pool);
+        return NULL;
+    }
+
+    pool->worker_count = worker_count;
+    pool->task = NULL;
+    pool->items = NULL;
+    for (int i = 0; i < worker_count; i++) {
+        mutex_init(&pool->deques[i].lock);
+    }
+
+    return pool;
+}
+
+// Free a thread pool
+void free_thread_pool(ThreadPool *pool) {
+    if (!pool) return;
+
+    for (int i = 0; i < pool->worker_count; i++) {
+        mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].items);
+    }
+    free(pool->deques);
+    free(pool);
+}
+
+// Number of workers in the pool
+int thread_pool_size(const ThreadPool *pool) {
+    return pool ? pool->worker_count : 1;
+}
+
+// Take the most recently queued item from a worker's own deque
+static bool pop_item(WorkDeque *deque, int *item) {
+    bool found = false;
+    mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *item = deque->items[--deque->tail];
+        found = true;
+    }
+    mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Take the oldest item from another worker's deque
+static bool steal_item(WorkDeque *deque, int *item) {
+    bool found = false;
+    mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *item = deque->items[deque->head++];
+        found = true;
+    }
+    mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Run items until every deque is empty (no items are added during a run,
+// so an empty sweep means the work is done)
+static void run_worker(ThreadPool *pool, int index) {
+    for (;;) {
+        int item;
+        bool found = pop_item(&pool->deques[index], &item);
+
+        for (int i = 1; !found && i < pool->worker_count; i++) {
+            found = steal_item(&pool->deques[(index + i) % pool->worker_count], &item);
+        }
+
+        if (!found) return;
+        pool->task(pool->items[item]);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+    Worker *worker = (Worker *)arg;
+    run_worker(worker->pool, worker->index);
+    return 0;
+}
+#else
+static void* worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    run_worker(worker->pool, worker->index);
+    return NULL;
+}
+#endif
+
+// Deal the items round-robin onto the first `workers` deques so every
+// worker starts with local work. False if a deque could not be allocated:
+// its items would never run, so the caller runs them all itself.
+static bool deal_items(ThreadPool *pool, int count, int workers) {
+    for (int w = 0; w < workers; w++) {
+        WorkDeque *deque = &pool->deques[w];
+        free(deque->items);
+        deque->items = (int *)malloc(sizeof(int) * (count / workers + 1));
+        deque->head = 0;
+        deque->tail = 0;
+        if (!deque->items) {
+            fprintf(stderr, "Memory allocation failed for thread pool deque, running serially\n");
+            return false;
+        }
+    }
+    for (int w = 0; w < workers; w++) {
+        WorkDeque *deque = &pool->deques[w];
+        // Push in reverse so the owner pops its items in source order
+        for (int i = count - 1; i >= 0; i--) {
+            if (i % workers == w) {
+                deque->items[deque->tail++] = i;
+            }
+        }
+    }
+    return true;
+}
+
+// Run a task on every item and wait for completion
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask task, void **items, int count) {
+    if (count <= 0) return;
+
+    // Serial fallback keeps source order
+    int workers = pool && pool->worker_count < count ? pool->worker_count : count;
+    if (workers < 1) workers = 1;
+    if (!pool || pool->worker_count == 1 || count == 1 || !deal_items(pool, count, workers)) {
+        for (int i = 0; i < count; i++) {
+            task(items[i]);
+        }
+        return;
+    }
+
+    pool->task = task;
+    pool->items = items;
+
+    // The calling thread is worker 0
+    int saved_count = pool->worker_count;
+    pool->worker_count = workers;
+
+    size_t slots = (size_t)workers;
+    PoolThread *threads = (PoolThread *)malloc(sizeof(PoolThread) * slots);
+    Worker *args = (Worker *)malloc(sizeof(Worker) * slots);
+    bool *started = (bool *)calloc(slots, sizeof(bool));
+
+    for (int w = 1; threads && args && started && w < workers; w++) {
+        args[w].pool = pool;
+        args[w].index = w;
+#ifdef _WIN32
+        threads[w] = CreateThread(NULL, 0, worker_main, &args[w], 0, NULL);
+        started[w] = threads[w] != NULL;
+#else
+        started[w] = pthread_create(&threads[w], NULL, worker_main, &args[w]) == 0;
+#endif
+        // A worker that failed to start just leaves its items to be stolen
+    }
+
+    run_worker(pool, 0);
+
+    for (int w = 1; threads && args && started && w < workers; w++) {
+        if (!started[w]) continue;
+#ifdef _WIN32
+        WaitForSingleObject(threads[w], INFINITE);
+        CloseHandle(threads[w]);
+#else
+        pthread_join(threads[w], NULL);
+#endif
+    }
+
+    free(threads);
+    free(args);
+    free(started);
+    pool->worker_count = saved_count;
+    pool->task = NULL;
+    pool->items = NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Task run by the pool on one work item
+typedef void (*ThreadPoolTask)(void *item);
+
+// Work-stealing thread pool (opaque)
+typedef struct ThreadPool ThreadPool;
+
+// Create a pool with the given number of workers (the calling thread counts
+// as one of them, so a pool of 1 runs everything inline)
+ThreadPool* create_thread_pool(int worker_count);
+
+// Free a thread pool
+void free_thread_pool(ThreadPool *pool);
+
+// Number of workers in the pool (1 for a NULL pool)
+int thread_pool_size(const ThreadPool *pool);
+
+// Run `task` on every item and wait for all of them to finish.
+// Items are dealt round-robin onto the workers' deques; a worker takes from
+// the back of its own deque and steals from the front of the others' when
+// it runs dry. With a NULL or single-worker pool, or when the deques cannot
+// be allocated, the items run in order on the calling thread.
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask task, void **items, int count);
+
+#endif // THREAD_POOL_H